@@ -2,18 +2,29 @@
 import { nodeConfig, globalConfig } from "./util/config";
 import { registerTopicHandler } from "./net/mqtt";
 import { on_ir_message } from "./sensor/ir";
-import { on_nfc_message } from "./sensor/nfc";
+import { on_nfc_dropped_message, on_nfc_message } from "./sensor/nfc";
+import { on_batch_message } from "./sensor/batch";
+import { on_acoustic_message } from "./sensor/sound";
 import { on_intent_message } from "./sensor/speech";
+import { on_dropped_message, on_replay_message } from "./sensor/replay";
 import logger from "./util/logger";
 import { NodeStateMessagePayload } from "./types";
-import { updateStateIfVirtualNode } from "./node/node";                
+import { parseStatePayload } from "./net/payload";
+import { publishNodeRules, updateStateIfVirtualNode } from "./node/node";                
 
 const on_state_message = (topic: string, payload: Buffer): void => {
-    const message: NodeStateMessagePayload = JSON.parse(payload.toString());
+    const message: NodeStateMessagePayload = parseStatePayload(payload);
     updateStateIfVirtualNode(message.node, message.state);
 };
 
 registerTopicHandler("node/+/sensor/ir", on_ir_message);
 registerTopicHandler("node/+/sensor/nfc", on_nfc_message);
+registerTopicHandler("node/+/sensor/nfc/dropped", on_nfc_dropped_message);
+registerTopicHandler("node/+/sensor/batch", on_batch_message);
+registerTopicHandler("node/+/sensor/acoustic", on_acoustic_message);
+registerTopicHandler("node/+/sensor/replay", on_replay_message);
+registerTopicHandler("node/+/sensor/dropped", on_dropped_message);
 registerTopicHandler(globalConfig.speech.intentTopic, on_intent_message);
-registerTopicHandler("node/+/state", on_state_message);
\ No newline at end of file
+registerTopicHandler("node/+/state", on_state_message);
+
+publishNodeRules();
\ No newline at end of file
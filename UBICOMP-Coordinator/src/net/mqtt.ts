@@ -16,8 +16,9 @@ const client = mqtt.connect(`mqtt://${MQTT_HOST}`, {
 
 const topicHandlers: TopicHandlerRegister = {};
 
+// A + matches a single level, so node/+/sensor/nfc doesn't match node/x/sensor/nfc/dropped
 const matchesTopicPattern = (topicPattern: string, topicToTest: string): boolean => {
-    const regex = new RegExp(topicPattern.replace("+", ".+"));
+    const regex = new RegExp(`^${topicPattern.split("+").join("[^/]+")}$`);
     return regex.test(topicToTest);
 };
 
@@ -59,6 +60,6 @@ export const registerTopicHandler = (topic: Topic, callback: TopicCallback): voi
     client.subscribe(topic);
 };
 
-export const publish = (topic: string, message: string | Buffer): void => {
-    client.publish(topic, message);
+export const publish = (topic: string, message: string | Buffer, retain = false): void => {
+    client.publish(topic, message, { retain });
 };
\ No newline at end of file
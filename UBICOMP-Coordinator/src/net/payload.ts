@@ -0,0 +1,103 @@
+import { AcousticMessagePayload, BatchMessagePayload, DroppedMessagePayload, IRMessagePayload, NfcMessagePayload, NodeCommand, NodeStateMessagePayload, SensorEventPayload, SoundMessagePayload } from "../types";
+
+// Nodes built with BINARY_PAYLOADS publish positional MessagePack arrays instead of JSON objects,
+// see SensorMsgPack.h of the firmware. Both are accepted, JSON always starts with '{' or '['.
+const MSGPACK_PAYLOAD_VERSION = 1;
+const SENSOR_TYPES = ["ir", "sound", "nfc", "acoustic"] as const;
+const ACOUSTIC_EVENTS = ["clap", "loud"] as const;
+const NFC_TAG_TYPE_MIFARE_CLASSIC = 0;
+
+type MsgPackValue = number | string | Buffer | null | MsgPackValue[];
+
+const isJson = (payload: Buffer): boolean => payload[0] === 0x7b || payload[0] === 0x5b;
+
+// Decodes the subset of MessagePack the firmware writes: unsigned integers, nil, bin, str and arrays
+const decodeMsgPack = (payload: Buffer): MsgPackValue => {
+    let offset = 0;
+    const next = (): MsgPackValue => {
+        const type = payload.readUInt8(offset++);
+        if(type < 0x80) return type;
+        if((type & 0xf0) === 0x90) return array(type & 0x0f);
+        if((type & 0xe0) === 0xa0) return string(type & 0x1f);
+        switch(type) {
+        case 0xc0: return null;
+        case 0xc4: return bytes(payload.readUInt8(offset++));
+        case 0xcc: offset += 1; return payload.readUInt8(offset - 1);
+        case 0xcd: offset += 2; return payload.readUInt16BE(offset - 2);
+        case 0xce: offset += 4; return payload.readUInt32BE(offset - 4);
+        case 0xd9: return string(payload.readUInt8(offset++));
+        case 0xdc: offset += 2; return array(payload.readUInt16BE(offset - 2));
+        default: throw new Error(`Unsupported MessagePack type 0x${type.toString(16)}`);
+        }
+    };
+    const array = (count: number): MsgPackValue[] => Array.from({ length: count }, () => next());
+    const bytes = (count: number): Buffer => {
+        offset += count;
+        return payload.subarray(offset - count, offset);
+    };
+    const string = (count: number): string => bytes(count).toString("utf8");
+    return next();
+};
+
+const decodeVersioned = (payload: Buffer): MsgPackValue[] => {
+    const decoded = decodeMsgPack(payload);
+    if(!Array.isArray(decoded) || decoded[0] !== MSGPACK_PAYLOAD_VERSION) {
+        throw new Error(`Unsupported binary payload version ${Array.isArray(decoded) ? decoded[0] : "?"}`);
+    }
+    return decoded.slice(1);
+};
+
+const action = (value: MsgPackValue): NodeCommand | undefined => value === null ? undefined : value as NodeCommand;
+
+const formatUid = (uid: Buffer): string => Array.from(uid).map(b => b.toString(16).toUpperCase().padStart(2, "0")).join(":");
+
+const irFields = ([code, command, , act]: MsgPackValue[]): IRMessagePayload => ({
+    code: code as number,
+    command: command as number,
+    action: action(act)
+});
+
+const soundFields = ([rms, peak, envelope]: MsgPackValue[]): SoundMessagePayload => ({
+    rms: rms as number,
+    peak: peak as number,
+    envelope: envelope as number
+});
+
+const nfcFields = ([uid, type, act]: MsgPackValue[]): NfcMessagePayload => ({
+    uid: formatUid(uid as Buffer),
+    type: type === NFC_TAG_TYPE_MIFARE_CLASSIC ? "Mifare Classic" : "NFC Forum Type 2",
+    action: action(act)
+});
+
+const acousticFields = ([kind, onset, peak, duration]: MsgPackValue[]): AcousticMessagePayload => ({
+    event: ACOUSTIC_EVENTS[kind as number],
+    onset: onset as number,
+    peak: peak as number,
+    duration: duration as number
+});
+
+const sensorEvent = ([type, timestamp, ...fields]: MsgPackValue[]): SensorEventPayload => {
+    const sensor = SENSOR_TYPES[type as number];
+    const meta = { timestamp: timestamp as number };
+    switch(sensor) {
+    case "ir": return { sensor, ...meta, ...irFields(fields) };
+    case "sound": return { sensor, ...meta, ...soundFields(fields) };
+    case "nfc": return { sensor, ...meta, ...nfcFields(fields) };
+    case "acoustic": return { sensor, ...meta, ...acousticFields(fields) };
+    default: throw new Error(`Unknown sensor type ${type}`);
+    }
+};
+
+const parse = <T>(payload: Buffer, fromMsgPack: (fields: MsgPackValue[]) => T): T => 
+    isJson(payload) ? JSON.parse(payload.toString()) : fromMsgPack(decodeVersioned(payload));
+
+export const parseIRPayload = (payload: Buffer): IRMessagePayload => parse(payload, irFields);
+export const parseSoundPayload = (payload: Buffer): SoundMessagePayload => parse(payload, soundFields);
+export const parseNfcPayload = (payload: Buffer): NfcMessagePayload => parse(payload, nfcFields);
+export const parseAcousticPayload = (payload: Buffer): AcousticMessagePayload => parse(payload, acousticFields);
+export const parseBatchPayload = (payload: Buffer): BatchMessagePayload => 
+    parse(payload, events => events.map(event => sensorEvent(event as MsgPackValue[])));
+export const parseStatePayload = (payload: Buffer): NodeStateMessagePayload => 
+    parse(payload, ([state, node]) => ({ state: state as 0 | 1, node: node as string }));
+export const parseDroppedPayload = (payload: Buffer): DroppedMessagePayload => 
+    parse(payload, ([dropped]) => ({ dropped: dropped as number }));
@@ -1,11 +1,33 @@
 import logger from "../util/logger";
-import { NodeCommand, NodeCommandPayload, NodeQualifier, State } from "../types";
+import { BroadcastCommandPayload, GroupCommandPayload, NfcUid, NodeCommand, NodeCommandPayload, NodeQualifier, NodeRulesPayload, State } from "../types";
 import { publish } from "../net/mqtt";
-import { nodeConfig } from "../util/config";
+import { globalConfig, nodeConfig } from "../util/config";
 
 
 
+// BROADCAST_MAX_NODES of the firmware, older firmware only reads numbers of 32 bits
+const BROADCAST_MAX_NODES = 1024;
+const BROADCAST_NUMBER_NODES = 32;
+
 const isVirtualNode = (qualifier: NodeQualifier): boolean => nodeConfig[qualifier]?.virtual ?? false;
+const nodeIndex = (qualifier: NodeQualifier): number => nodeConfig[qualifier]?.index ?? -1;
+const isBroadcastIndex = (index: number): boolean => Number.isInteger(index) && index >= 0 && index < BROADCAST_MAX_NODES;
+
+Object.keys(nodeConfig)
+    .filter(key => nodeConfig[key].index !== undefined && !isBroadcastIndex(nodeIndex(key)))
+    .forEach(key => logger.warn(`Index ${nodeIndex(key)} of node ${key} is outside the broadcast bitset, it gets its own commands`));
+
+const broadcastMask = (indices: number[]): number | string => {
+    if(indices.every(index => index < BROADCAST_NUMBER_NODES)) {
+        return indices.reduce((mask, index) => (mask | (1 << index)) >>> 0, 0);
+    }
+    // Each digit holds four nodes, the last one the first four
+    const digits: number[] = Array(Math.floor(Math.max(...indices) / 4) + 1).fill(0);
+    indices.forEach(index => digits[Math.floor(index / 4)] |= 1 << (index % 4));
+    return digits.reverse().map(digit => digit.toString(16)).join("");
+};
+
+export const getGroupMembers = (group: string): NodeQualifier[] => Object.keys(nodeConfig).filter(key => nodeConfig[key].group === group);
 const virtualNodeStates: Record<NodeQualifier, State> = Object.keys(nodeConfig)
     .filter((key) => isVirtualNode(key))
     .reduce((acc, key) => ({ ...acc, [key]: 0 as State}), {});
@@ -27,6 +49,15 @@ export const updateStateIfVirtualNode = (qualifier: NodeQualifier, state: State)
     }
 };
 
+const applyVirtualCommand = (qualifier: NodeQualifier, command: NodeCommand): void => {
+    if(isVirtualNode(qualifier)) {
+        const lastState = virtualNodeStates[qualifier];
+        if(lastState === undefined || lastState === null) throw new Error(`Couldn't find state for qualifier ${qualifier} although its defined as virtual`);
+        const newState: State = command === 2 ? (lastState === 0 ? 1 : 0) : command;
+        updateStateIfVirtualNode(qualifier, newState);
+    }
+};
+
 export const sendNodeCommand = (qualifier: NodeQualifier, command: NodeCommand): void => {
     logger.debug(`Sending Command ${command} to node ${qualifier}`);
     const payload: NodeCommandPayload = {
@@ -34,11 +65,70 @@ export const sendNodeCommand = (qualifier: NodeQualifier, command: NodeCommand):
         node: qualifier
     };
     publish(`node/${qualifier}/set`, JSON.stringify(payload));
-    
-    if(isVirtualNode(qualifier)) {
-        const lastState = virtualNodeStates[qualifier];
-        if(lastState === undefined || lastState === null) throw new Error(`Couldn't find state for qualifier ${qualifier} although its defined as virtual`);
-        const newState: State = command === 2 ? (lastState === 0 ? 1 : 0) : command;
-        updateStateIfVirtualNode(qualifier, newState);
+    applyVirtualCommand(qualifier, command);
+};
+
+/**
+ * Sends a command to all members of a group with a single publish.
+ */
+export const sendGroupCommand = (group: string, command: NodeCommand): void => {
+    logger.debug(`Sending Command ${command} to group ${group}`);
+    const payload: GroupCommandPayload = { command };
+    publish(`group/${group}/set`, JSON.stringify(payload));
+    getGroupMembers(group).forEach(qualifier => applyVirtualCommand(qualifier, command));
+};
+
+/**
+ * Sends a command to several nodes. Physical nodes are addressed by a single
+ * broadcast publish, each node tests its bit of the bitset.
+ */
+export const sendNodesCommand = (qualifiers: NodeQualifier[], command: NodeCommand): void => {
+    const broadcast = qualifiers.filter(q => !isVirtualNode(q) && isBroadcastIndex(nodeIndex(q)));
+    if(broadcast.length < 2) {
+        qualifiers.forEach(q => sendNodeCommand(q, command));
+        return;
     }
+
+    logger.debug(`Broadcasting Command ${command} to nodes ${broadcast.join(", ")}`);
+    const payload: BroadcastCommandPayload = {
+        nodes: broadcastMask(broadcast.map(nodeIndex)),
+        command: command
+    };
+    publish("broadcast/set", JSON.stringify(payload));
+    qualifiers.filter(q => !broadcast.includes(q)).forEach(q => sendNodeCommand(q, command));
+};
+
+// Tags of the other nodes. A node publishes them right away, it only limits
+// how often it publishes tags unknown to the whole fleet
+const knownNfcUids = (qualifier: NodeQualifier): NfcUid[] => Object.keys(nodeConfig)
+    .map(key => nodeConfig[key].nfc?.toggleUid)
+    .filter((uid, i, uids): uid is NfcUid => uid !== undefined && uid !== nodeConfig[qualifier].nfc?.toggleUid && uids.indexOf(uid) === i);
+
+const buildNodeRules = (qualifier: NodeQualifier): NodeRulesPayload => {
+    const { ir, nfc } = nodeConfig[qualifier];
+    const { selectiveOn, selectiveOff } = globalConfig.ir;
+    return {
+        ir: {
+            toggle: ir?.toggleCode !== undefined ? [ir.toggleCode] : [],
+            on: selectiveOn !== undefined ? [selectiveOn] : [],
+            off: selectiveOff !== undefined ? [selectiveOff] : []
+        },
+        nfc: {
+            toggle: nfc?.toggleUid !== undefined ? [nfc.toggleUid] : [],
+            known: knownNfcUids(qualifier)
+        }
+    };
+};
+
+/**
+ * Publishes the rules every physical node executes on its own. They are retained,
+ * so nodes get them on every (re)connect without asking.
+ */
+export const publishNodeRules = (): void => {
+    Object.keys(nodeConfig)
+        .filter((key) => !isVirtualNode(key))
+        .forEach((key) => {
+            logger.debug(`Publishing rules of node ${key}`);
+            publish(`node/${key}/config`, JSON.stringify(buildNodeRules(key)), true);
+        });
 };
\ No newline at end of file
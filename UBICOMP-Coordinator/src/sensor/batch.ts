@@ -0,0 +1,34 @@
+import logger from "../util/logger";
+import { BatchMessagePayload, NodeQualifier } from "../types";
+import { handle_ir } from "./ir";
+import { handle_nfc } from "./nfc";
+import { handle_acoustic } from "./sound";
+import { extractNodeFromTopic } from "./common";
+import { parseBatchPayload } from "../net/payload";
+
+const handle = (node: NodeQualifier, batch: BatchMessagePayload): void => {
+    logger.debug(`Recieved batch of ${batch.length} events from node ${node}`);
+
+    // Events are ordered by their timestamp, so they're handled as if they arrived one by one
+    batch.forEach(event => {
+        switch(event.sensor) {
+        case "ir":
+            handle_ir(node, event);
+            break;
+        case "nfc":
+            handle_nfc(node, event);
+            break;
+        case "acoustic":
+            handle_acoustic(node, event);
+            break;
+        default:
+            break;
+        }
+    });
+};
+
+export const on_batch_message = (topic: string, payload: Buffer): void => {
+    const node = extractNodeFromTopic(topic);
+    const parsedMessage = parseBatchPayload(payload);
+    handle(node, parsedMessage);
+};
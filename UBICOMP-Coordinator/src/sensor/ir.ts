@@ -2,39 +2,43 @@ import logger from "../util/logger";
 import { IRCode, IRMessagePayload, NodeQualifier } from "../types";
 import { nodeConfig } from "../util/config";
 import { globalConfig } from "../util/config";
-import { sendNodeCommand } from "../node/node";
+import { sendNodeCommand, sendNodesCommand } from "../node/node";
 import { extractNodeFromTopic } from "./common";
+import { parseIRPayload } from "../net/payload";
 
 
 const getAffectedNodes = (code: IRCode): NodeQualifier[] => Object.keys(nodeConfig).filter(key => nodeConfig[key].ir?.toggleCode === code);
 
-const handle = (nodeQualifier: NodeQualifier, message: IRMessagePayload): void => {
-    const { code } = message;    
+export const handle_ir = (nodeQualifier: NodeQualifier, message: IRMessagePayload): void => {
+    const { code, action } = message;    
     logger.debug(`Recieved IR Message from node ${nodeQualifier} with IR Code ${code}`);
 
+    // The node already executed its own rule, only the others are left to us
+    const executedLocally = action !== undefined;
+
     const isSelectiveOff = globalConfig.ir.selectiveOff === code;
     const isSelectiveOn = globalConfig.ir.selectiveOn === code;
     
     if(isSelectiveOff) {
         logger.debug(`Performing selective off defined for code ${code}`);
-        sendNodeCommand(nodeQualifier, 0);
+        if(!executedLocally) sendNodeCommand(nodeQualifier, 0);
         return;
     }
     if(isSelectiveOn) {
         logger.debug(`Performing selective on defined for code ${code}`);
-        sendNodeCommand(nodeQualifier, 1);
+        if(!executedLocally) sendNodeCommand(nodeQualifier, 1);
         return;
     }
 
-    const affectedNodes = getAffectedNodes(code);
+    const affectedNodes = getAffectedNodes(code).filter(n => !executedLocally || n !== nodeQualifier);
     logger.debug(`The IR event affects the nodes '${affectedNodes.join(", ")}'`);
-    affectedNodes.forEach(n => sendNodeCommand(n[0], 2));
+    sendNodesCommand(affectedNodes, 2);
 };
 
 export const on_ir_message = (topic: string, message: Buffer): void => {
     const node = extractNodeFromTopic(topic);
-    const parsedMessage = JSON.parse(message.toString());
-    handle(node, parsedMessage);
+    const parsedMessage = parseIRPayload(message);
+    handle_ir(node, parsedMessage);
 };
 
 
@@ -1,25 +1,31 @@
 import { nodeConfig } from "../util/config";
-import { NfcMessagePayload, NfcUid, NodeQualifier } from "../types";
+import { DroppedMessagePayload, NfcMessagePayload, NfcUid, NodeQualifier } from "../types";
 import logger from "../util/logger";
-import { sendNodeCommand } from "../node/node";
+import { sendNodesCommand } from "../node/node";
 import { extractNodeFromTopic } from "./common";
+import { parseDroppedPayload, parseNfcPayload } from "../net/payload";
 
 const getAffectedNodes = (uid: NfcUid): NodeQualifier[] => Object.keys(nodeConfig).filter(key => nodeConfig[key]?.nfc?.toggleUid === uid);
 
-const handle = (node: NodeQualifier, payload: NfcMessagePayload): void => {
-    const { uid } = payload;
+export const handle_nfc = (node: NodeQualifier, payload: NfcMessagePayload): void => {
+    const { uid, action } = payload;
     logger.debug(`Recieved NFC Message for UID ${uid}`);
 
-    const affectedNodes = getAffectedNodes(uid);
+    // The node already executed its own rule, only the others are left to us
+    const affectedNodes = getAffectedNodes(uid).filter(n => action === undefined || n !== node);
     logger.debug(`The UID affects the nodes '${affectedNodes.join(", ")}'`);
     
-    affectedNodes.forEach(node => {
-        sendNodeCommand(node, 2);
-    });
+    sendNodesCommand(affectedNodes, 2);
 };
 
 export const on_nfc_message = (topic: string, payload: Buffer): void => {
     const node = extractNodeFromTopic(topic);
-    const parsedMessage = JSON.parse(payload.toString());
-    handle(node, parsedMessage);
-};
\ No newline at end of file
+    const parsedMessage = parseNfcPayload(payload);
+    handle_nfc(node, parsedMessage);
+};
+// A node only publishes a few tags the fleet doesn't know at once, the rest are counted
+export const on_nfc_dropped_message = (topic: string, payload: Buffer): void => {
+    const node = extractNodeFromTopic(topic);
+    const parsedMessage: DroppedMessagePayload = parseDroppedPayload(payload);
+    logger.warn(`Node ${node} dropped ${parsedMessage.dropped} unknown NFC tags`);
+};
@@ -0,0 +1,25 @@
+import logger from "../util/logger";
+import { BatchMessagePayload, DroppedMessagePayload, NodeQualifier } from "../types";
+import { extractNodeFromTopic } from "./common";
+import { parseBatchPayload, parseDroppedPayload } from "../net/payload";
+
+// Events a node kept while it was disconnected. They're history by now, so
+// they're only logged and don't switch any node
+const handle = (node: NodeQualifier, replay: BatchMessagePayload): void => {
+    logger.info(`Recieved ${replay.length} events that node ${node} kept while offline`);
+    replay.forEach(event => {
+        logger.debug(`Replayed ${event.sensor} event of node ${node} from ${event.timestamp}: ${JSON.stringify(event)}`);
+    });
+};
+
+export const on_replay_message = (topic: string, payload: Buffer): void => {
+    const node = extractNodeFromTopic(topic);
+    const parsedMessage = parseBatchPayload(payload);
+    handle(node, parsedMessage);
+};
+
+export const on_dropped_message = (topic: string, payload: Buffer): void => {
+    const node = extractNodeFromTopic(topic);
+    const parsedMessage: DroppedMessagePayload = parseDroppedPayload(payload);
+    logger.warn(`Node ${node} dropped ${parsedMessage.dropped} events while offline`);
+};
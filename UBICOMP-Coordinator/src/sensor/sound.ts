@@ -0,0 +1,23 @@
+import logger from "../util/logger";
+import { AcousticMessagePayload, NodeQualifier } from "../types";
+import { nodeConfig } from "../util/config";
+import { sendNodeCommand } from "../node/node";
+import { extractNodeFromTopic } from "./common";
+import { parseAcousticPayload } from "../net/payload";
+
+export const handle_acoustic = (nodeQualifier: NodeQualifier, message: AcousticMessagePayload): void => {
+    const { event, peak } = message;
+    logger.debug(`Recieved acoustic event '${event}' from node ${nodeQualifier} with peak ${peak}`);
+
+    // A node toggles itself if it heard its configured event
+    if(nodeConfig[nodeQualifier]?.sound?.toggleEvent === event) {
+        logger.debug(`Toggling node ${nodeQualifier} on acoustic event '${event}'`);
+        sendNodeCommand(nodeQualifier, 2);
+    }
+};
+
+export const on_acoustic_message = (topic: string, message: Buffer): void => {
+    const node = extractNodeFromTopic(topic);
+    const parsedMessage = parseAcousticPayload(message);
+    handle_acoustic(node, parsedMessage);
+};
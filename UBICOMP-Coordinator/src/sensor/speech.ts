@@ -1,7 +1,7 @@
 import { nodeConfig } from "../util/config";
 import logger from "../util/logger";
 import { NodeCommand, NodeQualifier, ToggleNodeIntentPayload } from "../types";
-import { sendNodeCommand } from "../node/node";
+import { getGroupMembers, sendGroupCommand, sendNodesCommand } from "../node/node";
 
 const getAffectedNodes = (value: string): NodeQualifier[] => Object.keys(nodeConfig).filter(key => key === value || nodeConfig[key]?.speech?.additionalQualifiers.includes(value));
 
@@ -10,10 +10,16 @@ const handle = (message: ToggleNodeIntentPayload): void => {
     const state = Number(message.slots.find(s => s.entity === "state").value.value) as NodeCommand;
     logger.debug(`Recieved Intent for node ${node} with state ${state}`);
 
+    if(getGroupMembers(node).length > 0) {
+        logger.debug(`The Intent affects the group '${node}'`);
+        sendGroupCommand(node, state);
+        return;
+    }
+
     const affectedNodes = getAffectedNodes(node);
     logger.debug(`The Intent affects the nodes '${affectedNodes.join(",")}'`);
     
-    affectedNodes.forEach(node => sendNodeCommand(node, state));
+    sendNodesCommand(affectedNodes, state);
 };
 
 export const on_intent_message = (topic: string, message: Buffer): void => {
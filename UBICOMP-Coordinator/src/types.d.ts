@@ -22,6 +22,17 @@ type NodeCommandPayload = {
     command: NodeCommand
 }
 
+type GroupCommandPayload = {
+    command: NodeCommand
+}
+
+// Addressed nodes as bitset of their indices, a number for the first 32 nodes,
+// hex digits (most significant first) beyond
+type BroadcastCommandPayload = {
+    nodes: number | string,
+    command: NodeCommand
+}
+
 type TopicHandler = {
     onMessage: (topic: string, payload: Buffer) => void;
 };
@@ -32,11 +43,59 @@ type NfcUid = string;
 interface NfcMessagePayload {
     uid: NfcUid;
     type: string;
+    action?: NodeCommand;
 }
 
 interface IRMessagePayload {
     code: IRCode;
     command: number;
+    button?: string;
+    action?: NodeCommand;
+}
+
+// Rules a node executes on its own, published retained on node/<id>/config
+interface NodeRulesPayload {
+    ir: {
+        toggle: IRCode[];
+        on: IRCode[];
+        off: IRCode[];
+    };
+    nfc: {
+        toggle: NfcUid[];
+        // Tags of the other nodes, no action on this one
+        known: NfcUid[];
+    };
+}
+
+interface SoundMessagePayload {
+    rms: number;
+    peak: number;
+    envelope: number;
+}
+
+type AcousticEvent = "clap" | "loud";
+interface AcousticMessagePayload {
+    event: AcousticEvent;
+    onset: number;
+    peak: number;
+    duration: number;
+}
+
+interface SensorEventMeta {
+    timestamp: number;
+}
+
+type SensorEventPayload = (IRMessagePayload & SensorEventMeta & { sensor: "ir" }) |
+                (NfcMessagePayload & SensorEventMeta & { sensor: "nfc" }) |
+                (SoundMessagePayload & SensorEventMeta & { sensor: "sound" }) |
+                (AcousticMessagePayload & SensorEventMeta & { sensor: "acoustic" });
+
+type BatchMessagePayload = SensorEventPayload[];
+
+// Sensor events a node dropped while it was disconnected, or unknown NFC tags
+// it dropped since its last report
+interface DroppedMessagePayload {
+    dropped: number;
 }
 
 interface NodeStateMessagePayload {
@@ -1,12 +1,12 @@
 import * as fs from "fs";
-import { IRCode, NfcUid, NodeQualifier } from "../types";
+import { AcousticEvent, IRCode, NfcUid, NodeQualifier } from "../types";
 
 type NodeIRConfig = {
     toggleCode: IRCode;
 };
 
 type NodeSoundConfig = {
-
+    toggleEvent?: AcousticEvent;
 };
 
 type NodeNfcConfig = {
@@ -23,6 +23,11 @@ export type NodeConfig = {
     nfc?: NodeNfcConfig;
     speech?: NodeSpeechConfig;
     virtual?: boolean;
+    // Position in the bitset of broadcast commands, NODE_BROADCAST_INDEX of the firmware.
+    // Nodes without one get their own publish instead
+    index?: number;
+    // Group the node subscribes to, NODE_GROUP of the firmware. A node is in one group at most
+    group?: string;
 };
 
 type GlobalIRConfig = {
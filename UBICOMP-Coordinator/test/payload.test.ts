@@ -0,0 +1,54 @@
+import * as assert from "assert";
+import { parseBatchPayload, parseIRPayload, parseNfcPayload, parseStatePayload } from "../src/net/payload";
+
+// Written by SensorMsgPack.cpp of the firmware, the same hex strings are checked
+// byte for byte in its test/test_msgpack. A change there has to be made here as well
+const IR_NO_ACTION = "9501ce00ff9867450cc0";
+const NFC_SEVEN_BYTE_UID = "9401c40704a1b2c3d4e5f60102";
+const STATE_LONG_NODE = "930101d9216c6976696e672d726f6f6d2d6365696c696e672d6c696768742d6e6f64652d3132";
+const BATCH = "95019600ce00011170ce00ff9867450cc09502ce00011364c4048efc5b2200029501ce0001151ecd012ccd03e80c9603ce0001155800ce0001e240cd070828";
+
+const binary = (hex: string): Buffer => Buffer.from(hex, "hex");
+
+const tests: Record<string, () => void> = {
+    "decodes nil as no action": () => {
+        assert.deepStrictEqual(parseIRPayload(binary(IR_NO_ACTION)), { code: 16750695, command: 0x45, action: undefined });
+    },
+    "formats a bin UID": () => {
+        assert.deepStrictEqual(parseNfcPayload(binary(NFC_SEVEN_BYTE_UID)), {
+            uid: "04:A1:B2:C3:D4:E5:F6",
+            type: "NFC Forum Type 2",
+            action: 2
+        });
+    },
+    "decodes a str8 node name": () => {
+        assert.deepStrictEqual(parseStatePayload(binary(STATE_LONG_NODE)), {
+            state: 1,
+            node: "living-room-ceiling-light-node-12"
+        });
+    },
+    "decodes a batch of every sensor": () => {
+        assert.deepStrictEqual(parseBatchPayload(binary(BATCH)), [
+            { sensor: "ir", timestamp: 70000, code: 16750695, command: 0x45, action: undefined },
+            { sensor: "nfc", timestamp: 70500, uid: "8E:FC:5B:22", type: "Mifare Classic", action: 2 },
+            { sensor: "sound", timestamp: 70942, rms: 300, peak: 1000, envelope: 12 },
+            { sensor: "acoustic", timestamp: 71000, event: "clap", onset: 123456, peak: 1800, duration: 40 }
+        ]);
+    },
+    "still accepts JSON": () => {
+        assert.deepStrictEqual(parseStatePayload(Buffer.from("{\"node\":\"node-1\",\"state\":0}")), { node: "node-1", state: 0 });
+    },
+    "rejects another payload version": () => {
+        assert.throws(() => parseIRPayload(binary("9502ce00ff9867450cc0")), /version/);
+    }
+};
+
+Object.keys(tests).forEach(name => {
+    try {
+        tests[name]();
+        console.log(`PASS ${name}`);
+    } catch(error) {
+        console.log(`FAIL ${name}\n${error}`);
+        process.exitCode = 1;
+    }
+});
@@ -0,0 +1,40 @@
+#ifndef BACKOFF_H
+#define BACKOFF_H
+
+#include <stdint.h>
+
+// Exponential backoff between reconnect attempts. The delay doubles per
+// failed attempt up to a maximum and is jittered, so nodes that lost the
+// connection at the same time don't all retry at once
+typedef struct s_backoff {
+  uint32_t minDelay;  // ms, delay of the first attempt before the jitter
+  uint32_t maxDelay;  // ms
+  uint8_t attempt;    // failed attempts since the last success
+} t_backoff;
+
+/**
+ * @brief Sets the delay range and starts without failed attempts
+ *
+ * @param minDelay delay before the first attempt (ms)
+ * @param maxDelay the delay doesn't grow beyond this (ms)
+ */
+void initBackoff(t_backoff* backoff, uint32_t minDelay, uint32_t maxDelay);
+
+/**
+ * @brief Delay before the next attempt, counts the attempt. Half of the
+ *        delay is fixed, the other half random ("equal jitter"), so it
+ *        still grows with every attempt
+ *
+ * @param random any random number, e.g. esp_random()
+ * @return uint32_t delay (ms)
+ */
+uint32_t nextBackoff(t_backoff* backoff, uint32_t random);
+
+/**
+ * @brief Starts over with the shortest delay after a successful attempt
+ */
+inline void resetBackoff(t_backoff* backoff) {
+  backoff->attempt = 0;
+}
+
+#endif
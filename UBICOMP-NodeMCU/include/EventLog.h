@@ -0,0 +1,136 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Erase unit of the flash, every sector starts with a t_log_sector_header
+#define LOG_SECTOR_SIZE 4096
+// Records are collected in RAM and written up to this many bytes at once
+#define LOG_PAGE_SIZE 256
+// Largest payload of a single record
+#define LOG_RECORD_MAX_SIZE 64
+// Marks a sector that belongs to the log ("ELOG")
+#define LOG_MAGIC 0x474F4C45
+
+/*
+ * Append-only log of records in a ring of flash sectors, survives reboots.
+ *
+ * Layout: each sector starts with a header, followed by records. Every record
+ * is a t_log_record_header and its payload, padded to 4 bytes. The log is
+ * written front to back and wraps around, so each sector is erased equally
+ * often. Starting a sector erases it - records that weren't consumed yet are
+ * dropped then.
+ *
+ * Flash semantics are those of NOR flash: erasing sets all bits, writing can
+ * only clear them. A record is consumed by clearing its state in place, a
+ * record whose write was cut off by a reset fails its CRC and is skipped.
+ */
+
+typedef struct s_log_sector_header {
+  uint32_t magic;     // LOG_MAGIC, the sector isn't part of the log otherwise
+  uint32_t sequence;  // increases with every sector that is started
+} t_log_sector_header;
+
+typedef struct s_log_record_header {
+  uint16_t length;  // of the payload, 0xFFFF where no record was written yet
+  uint16_t state;   // LOG_RECORD_PENDING until consumed
+  uint32_t crc;     // CRC-32 of the length and the payload
+} t_log_record_header;
+
+#define LOG_RECORD_PENDING 0xFFFF
+#define LOG_RECORD_CONSUMED 0x0000
+
+/**
+ * @brief Raw flash the log is stored in, e.g. a partition on the device or
+ *        a file on the host. Offsets are relative to the start of the log.
+ *        All functions return false on an error
+ */
+typedef struct s_log_flash {
+  bool (*read)(void* context, uint32_t offset, void* data, size_t length);
+  bool (*write)(void* context, uint32_t offset, const void* data, size_t length);
+  // Sets the whole sector starting at offset to 0xFF
+  bool (*erase)(void* context, uint32_t offset);
+  void* context;
+  uint32_t size;  // bytes, a multiple of LOG_SECTOR_SIZE
+} t_log_flash;
+
+typedef struct s_event_log {
+  const t_log_flash* flash;
+  uint32_t sectors;
+  // Where the next record goes and the sequence of the sector it's in
+  uint32_t writeOffset;
+  uint32_t sequence;
+  // Records not written yet, they belong at pageOffset
+  uint8_t page[LOG_PAGE_SIZE];
+  uint32_t pageOffset;
+  size_t pageLength;
+  // Oldest record that may not be consumed yet
+  uint32_t readOffset;
+  uint32_t pending;  // records not consumed yet
+  uint32_t dropped;  // records erased before they were consumed
+} t_event_log;
+
+/**
+ * @brief Finds the records of the log in flash, or starts a new log if the
+ *        flash doesn't contain one
+ *
+ * @param flash flash of at least two sectors
+ * @return false if the flash couldn't be read or written
+ */
+bool mountLog(t_event_log* log, const t_log_flash* flash);
+
+/**
+ * @brief Appends a record. It's only collected in RAM, the page is written
+ *        once it's full, the record doesn't fit or flushLog() is called
+ *
+ * @param data payload of the record
+ * @param length at most LOG_RECORD_MAX_SIZE
+ * @return false if the record is too long or the flash failed
+ */
+bool appendLog(t_event_log* log, const void* data, size_t length);
+
+/**
+ * @brief Writes the collected records to flash
+ */
+bool flushLog(t_event_log* log);
+
+/**
+ * @brief Starts reading the pending records, from the oldest. Writes the
+ *        collected records first
+ *
+ * @return uint32_t cursor to pass to readLog() and consumeLog()
+ */
+uint32_t startLogRead(t_event_log* log);
+
+/**
+ * @brief Reads the next pending record and moves the cursor past it
+ *
+ * @param cursor position returned by startLogRead() or the last readLog()
+ * @param data filled with the payload, cut off if it doesn't fit
+ * @param size size of data
+ * @return size_t length of the payload, 0 if there is no further record
+ */
+size_t readLog(t_event_log* log, uint32_t* cursor, void* data, size_t size);
+
+/**
+ * @brief Consumes all records up to the cursor, they're not read again -
+ *        even after a reboot
+ *
+ * @param cursor position returned by readLog()
+ */
+void consumeLog(t_event_log* log, uint32_t cursor);
+
+/**
+ * @brief Number of records not consumed yet
+ */
+inline uint32_t pendingLogRecords(const t_event_log* log) {
+  return log->pending;
+}
+
+/**
+ * @brief CRC-32 (IEEE) as used for the records, start with crc = 0
+ */
+uint32_t logCrc(uint32_t crc, const void* data, size_t length);
+
+#endif
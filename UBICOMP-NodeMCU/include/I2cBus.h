@@ -0,0 +1,92 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <freertos/semphr.h>
+#include <atomic>
+
+#include <I2cDevice.h>
+
+/**
+ * @brief Owns a TwoWire shared by several devices. Transactions of any task
+ *        are serialized, a transaction may span several frames - e.g. the
+ *        length read, ACK and response read of a PN532 response - which
+ *        nothing gets in between of. Keep transactions short, a device holding
+ *        the bus delays all others
+ */
+class I2cBus {
+public:
+  explicit I2cBus(TwoWire& wire);
+
+  /**
+   * @brief Starts the bus, before any device is added
+   */
+  void begin();
+
+  /**
+   * @brief Adds a device for its transactions and counters
+   *
+   * @param name name of the device, for reports
+   * @return t_i2c_device* the device, NULL if the bus has I2C_MAX_DEVICES
+   */
+  t_i2c_device* addDevice(const char* name, I2cPriority priority);
+
+  /**
+   * @brief Waits until the bus is free for the device and takes it. High
+   *        priority devices are queued first, low priority ones wait while
+   *        a high priority transaction is pending
+   */
+  void acquire(t_i2c_device* device);
+
+  /**
+   * @brief Frees the bus taken by acquire() and counts the transaction
+   */
+  void release(t_i2c_device* device);
+
+  // Only to be used while the bus is acquired
+  TwoWire& wire() {
+    return bus;
+  }
+
+  const t_i2c_device* devices() const {
+    return deviceTable;
+  }
+
+  uint8_t deviceCount() const {
+    return count;
+  }
+
+private:
+  TwoWire& bus;
+  SemaphoreHandle_t mutex;
+  // High priority transactions waiting for the bus
+  std::atomic<uint8_t> highWaiting;
+  // When the current transaction got the bus (us)
+  uint32_t acquired;
+  t_i2c_device deviceTable[I2C_MAX_DEVICES];
+  uint8_t count;
+};
+
+/**
+ * @brief Holds the bus for a device while in scope
+ */
+class I2cTransaction {
+public:
+  I2cTransaction(I2cBus& bus, t_i2c_device* device) : bus(bus), device(device) {
+    bus.acquire(device);
+  }
+
+  ~I2cTransaction() {
+    bus.release(device);
+  }
+
+  I2cTransaction(const I2cTransaction&) = delete;
+  I2cTransaction& operator=(const I2cTransaction&) = delete;
+
+private:
+  I2cBus& bus;
+  t_i2c_device* device;
+};
+
+#endif
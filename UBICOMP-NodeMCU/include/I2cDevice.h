@@ -0,0 +1,31 @@
+#ifndef I2C_DEVICE_H
+#define I2C_DEVICE_H
+
+#include <stdint.h>
+
+// Devices a single bus takes
+#define I2C_MAX_DEVICES 4
+
+/**
+ * @brief Bus access of a device. Waiting high priority transactions go
+ *        first, low priority ones step back for them
+ */
+enum I2cPriority : uint8_t {
+  I2C_PRIORITY_HIGH = 0,  // latency sensitive, e.g. PN532 frames
+  I2C_PRIORITY_LOW = 1    // cosmetic, e.g. LCD updates
+};
+
+/**
+ * @brief Device on a shared I2C bus and its bus utilization, see I2cBus.h.
+ *        The counters only grow, a report takes their differences
+ */
+typedef struct s_i2c_device {
+  const char* name;
+  I2cPriority priority;
+  // Counters since the device was added, only written while it holds the bus
+  uint32_t transactions;
+  uint32_t busy;  // us the device held the bus
+  uint32_t wait;  // us the device waited for the bus
+} t_i2c_device;
+
+#endif
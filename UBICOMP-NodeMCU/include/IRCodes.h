@@ -1,30 +1,157 @@
-#define IR_DIM_UP 0xFF906F
-#define IR_DIM_DOWN 0xFFB847
-#define IR_CODE_ON 0xFFB04F
-#define IR_CODE_OFF 0xFFF807
-
-#define IR_CODE_RED_0 0xFF9867
-#define IR_CODE_GREEN_0 0xFFD827
-#define IR_CODE_BLUE_0 0xFF8877
-#define IR_CODE_WHITE 0xFFA857
-
-#define IR_CODE_RED_1 0xFFE817
-#define IR_CODE_GREEN_1 0xFF48B7
-#define IR_CODE_BLUE_1 0xFF6897
-
-#define IR_CODE_RED_2 0xFF02FD
-#define IR_CODE_GREEN_2 0xFF32CD
-#define IR_CODE_BLUE_2 0xFF20DF
-
-#define IR_CODE_RED_3 0xFF50AF
-#define IR_CODE_GREEN_3 0xFF7887
-#define IR_CODE_BLUE_3 0xFF708F
-
-#define IR_CODE_RED_4 0xFF38C7
-#define IR_CODE_GREEN_4 0xFF28D7
-#define IR_CODE_BLUE_4 0xFFF00F
-
-#define IR_CODE_FLASH 0xFFB24D
-#define IR_CODE_STROBE 0xFF00FF
-#define IR_CODE_FADE 0xFF58A7
-#define IR_CODE_SMOOTH 0xFF30CF
\ No newline at end of file
+#ifndef IR_CODES_H
+#define IR_CODES_H
+
+#include <stdint.h>
+
+// Buttons of the IR remote
+enum IRButton : uint8_t {
+  IR_BUTTON_NONE = 0,  // unknown code
+
+  IR_BUTTON_DIM_UP,
+  IR_BUTTON_DIM_DOWN,
+  IR_BUTTON_ON,
+  IR_BUTTON_OFF,
+
+  IR_BUTTON_RED_0,
+  IR_BUTTON_GREEN_0,
+  IR_BUTTON_BLUE_0,
+  IR_BUTTON_WHITE,
+
+  IR_BUTTON_RED_1,
+  IR_BUTTON_GREEN_1,
+  IR_BUTTON_BLUE_1,
+
+  IR_BUTTON_RED_2,
+  IR_BUTTON_GREEN_2,
+  IR_BUTTON_BLUE_2,
+
+  IR_BUTTON_RED_3,
+  IR_BUTTON_GREEN_3,
+  IR_BUTTON_BLUE_3,
+
+  IR_BUTTON_RED_4,
+  IR_BUTTON_GREEN_4,
+  IR_BUTTON_BLUE_4,
+
+  IR_BUTTON_FLASH,
+  IR_BUTTON_STROBE,
+  IR_BUTTON_FADE,
+  IR_BUTTON_SMOOTH
+};
+
+typedef struct s_ir_code {
+  uint32_t code;
+  IRButton button;
+  const char* name;
+} t_ir_code;
+
+/***** Perfect Hash ******/
+// Codes are mapped to IR_HASH_SIZE slots by a multiplicative hash. The
+// multiplier is searched at compile time, so that no two codes share a slot
+// and a lookup is a single multiplication, shift and compare.
+
+constexpr uint8_t IR_HASH_BITS = 7;
+constexpr uint8_t IR_HASH_SIZE = 1 << IR_HASH_BITS;
+constexpr uint8_t IR_SLOT_EMPTY = 0xFF;
+
+typedef struct s_ir_hash_table {
+  uint8_t slots[IR_HASH_SIZE];  // index into the codes or IR_SLOT_EMPTY
+} t_ir_hash_table;
+
+constexpr uint8_t irHash(uint32_t code, uint32_t seed) {
+  return (uint32_t) (code * seed) >> (32 - IR_HASH_BITS);
+}
+
+constexpr bool isPerfectIRSeed(const t_ir_code* codes, uint8_t count, uint32_t seed) {
+  bool used[IR_HASH_SIZE] = {};
+  for(uint8_t i = 0; i < count; i++) {
+    uint8_t slot = irHash(codes[i].code, seed);
+    if(used[slot]) {
+      return false;
+    }
+    used[slot] = true;
+  }
+  return true;
+}
+
+constexpr uint32_t findIRSeed(const t_ir_code* codes, uint8_t count) {
+  // Odd multipliers starting at the golden ratio, the first fit wins
+  uint32_t seed = 0x9E3779B1;
+  while(!isPerfectIRSeed(codes, count, seed)) {
+    seed += 2;
+  }
+  return seed;
+}
+
+constexpr t_ir_hash_table buildIRHashTable(const t_ir_code* codes, uint8_t count, uint32_t seed) {
+  t_ir_hash_table table = {};
+  for(uint8_t slot = 0; slot < IR_HASH_SIZE; slot++) {
+    table.slots[slot] = IR_SLOT_EMPTY;
+  }
+  for(uint8_t i = 0; i < count; i++) {
+    table.slots[irHash(codes[i].code, seed)] = i;
+  }
+  return table;
+}
+
+/**
+ * @brief Codes sent by the IR remote and their hash table. Static members are
+ *        defined once (IRCodes.cpp), so the inline lookupIRCode() refers to
+ *        the same tables in every translation unit
+ */
+struct IRCodes {
+  static constexpr t_ir_code CODES[] = {
+    { 0xFF906F, IR_BUTTON_DIM_UP, "DIM_UP" },
+    { 0xFFB847, IR_BUTTON_DIM_DOWN, "DIM_DOWN" },
+    { 0xFFB04F, IR_BUTTON_ON, "ON" },
+    { 0xFFF807, IR_BUTTON_OFF, "OFF" },
+
+    { 0xFF9867, IR_BUTTON_RED_0, "RED_0" },
+    { 0xFFD827, IR_BUTTON_GREEN_0, "GREEN_0" },
+    { 0xFF8877, IR_BUTTON_BLUE_0, "BLUE_0" },
+    { 0xFFA857, IR_BUTTON_WHITE, "WHITE" },
+
+    { 0xFFE817, IR_BUTTON_RED_1, "RED_1" },
+    { 0xFF48B7, IR_BUTTON_GREEN_1, "GREEN_1" },
+    { 0xFF6897, IR_BUTTON_BLUE_1, "BLUE_1" },
+
+    { 0xFF02FD, IR_BUTTON_RED_2, "RED_2" },
+    { 0xFF32CD, IR_BUTTON_GREEN_2, "GREEN_2" },
+    { 0xFF20DF, IR_BUTTON_BLUE_2, "BLUE_2" },
+
+    { 0xFF50AF, IR_BUTTON_RED_3, "RED_3" },
+    { 0xFF7887, IR_BUTTON_GREEN_3, "GREEN_3" },
+    { 0xFF708F, IR_BUTTON_BLUE_3, "BLUE_3" },
+
+    { 0xFF38C7, IR_BUTTON_RED_4, "RED_4" },
+    { 0xFF28D7, IR_BUTTON_GREEN_4, "GREEN_4" },
+    { 0xFFF00F, IR_BUTTON_BLUE_4, "BLUE_4" },
+
+    { 0xFFB24D, IR_BUTTON_FLASH, "FLASH" },
+    { 0xFF00FF, IR_BUTTON_STROBE, "STROBE" },
+    { 0xFF58A7, IR_BUTTON_FADE, "FADE" },
+    { 0xFF30CF, IR_BUTTON_SMOOTH, "SMOOTH" }
+  };
+  static constexpr uint8_t COUNT = sizeof(CODES) / sizeof(CODES[0]);
+  static constexpr uint32_t HASH_SEED = findIRSeed(CODES, COUNT);
+  static constexpr t_ir_hash_table HASH_TABLE = buildIRHashTable(CODES, COUNT, HASH_SEED);
+
+  static_assert(COUNT < IR_SLOT_EMPTY, "Too many IR codes for the slot type");
+  static_assert(COUNT <= IR_HASH_SIZE, "Too many IR codes for the hash table");
+};
+
+/**
+ * @brief Resolves a raw IR code to the button of the remote
+ *
+ * @param code raw code as decoded by the IR receiver
+ * @return const t_ir_code* entry of the button, nullptr if the code is unknown
+ */
+inline const t_ir_code* lookupIRCode(uint32_t code) {
+  uint8_t index = IRCodes::HASH_TABLE.slots[irHash(code, IRCodes::HASH_SEED)];
+  if(index == IR_SLOT_EMPTY || IRCodes::CODES[index].code != code) {
+    return nullptr;
+  }
+  return &IRCodes::CODES[index];
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Log-scale buckets: bucket 0 counts durations of 0us, bucket i durations in
+// [2^(i-1), 2^i) us. The last bucket also takes everything above (> 262ms)
+#define LATENCY_BUCKETS 20
+
+// Counters are free running and only written by the task that measures, so
+// recording needs no lock. The reader takes differences between snapshots
+typedef struct s_latency_histogram {
+  uint32_t buckets[LATENCY_BUCKETS];
+  uint32_t sum;  // us, wraps around
+} t_latency_histogram;
+
+/**
+ * @brief Counts a duration. A handful of instructions, no allocation
+ *
+ * @param us measured duration
+ */
+inline void recordLatency(t_latency_histogram* histogram, uint32_t us) {
+  uint32_t bucket = us ? 32 - __builtin_clz(us) : 0;
+  if(bucket >= LATENCY_BUCKETS) {
+    bucket = LATENCY_BUCKETS - 1;
+  }
+  histogram->buckets[bucket]++;
+  histogram->sum += us;
+}
+
+/**
+ * @brief Takes what was recorded since the last call
+ *
+ * @param live histogram written by the measuring task
+ * @param reported snapshot of the last call, updated to the current counters
+ * @param interval filled with the counts since the last call
+ */
+void takeLatencyInterval(const t_latency_histogram* live, t_latency_histogram* reported, t_latency_histogram* interval);
+
+/**
+ * @brief Number of buckets up to the last non-empty one
+ */
+size_t usedLatencyBuckets(const t_latency_histogram* histogram);
+
+#endif
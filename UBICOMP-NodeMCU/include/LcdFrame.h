@@ -0,0 +1,124 @@
+#ifndef LCD_FRAME_H
+#define LCD_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief Shadow framebuffer of a character LCD with RGB backlight. The
+ *        contents are set in RAM, render() compares them with what was
+ *        written last and only sends the cells and colour that changed. Every
+ *        command is an I2C transaction on the bus the NFC reader shares, and
+ *        a clear() is one of the slowest HD44780 commands - it's never used.
+ *
+ *        Nothing is known about the display at first, the first render()
+ *        writes every cell and the colour.
+ *
+ * @tparam Columns cells per row
+ * @tparam Rows rows of the display
+ */
+template <uint8_t Columns, uint8_t Rows>
+class LcdFrame {
+public:
+  LcdFrame() {
+    memset(cells, ' ', sizeof(cells));
+    memset(color, 0, sizeof(color));
+    invalidate();
+  }
+
+  /**
+   * @brief Sets a row, text beyond the row is cut off and the rest of the
+   *        row is cleared
+   */
+  void setLine(uint8_t row, const char* text) {
+    if(row >= Rows) {
+      return;
+    }
+    size_t length = strlen(text);
+    for(uint8_t column = 0; column < Columns; column++) {
+      cells[row][column] = column < length ? text[column] : ' ';
+    }
+  }
+
+  void setColor(uint8_t red, uint8_t green, uint8_t blue) {
+    color[0] = red;
+    color[1] = green;
+    color[2] = blue;
+  }
+
+  /**
+   * @brief Forgets what is on the display, e.g. after it was reset. The next
+   *        render() writes everything
+   */
+  void invalidate() {
+    // No cell is ever set to 0, it's what a cell never matches
+    memset(written, 0, sizeof(written));
+    colorWritten = false;
+    cursorKnown = false;
+  }
+
+  /**
+   * @brief Writes what changed since the last render()
+   *
+   * @tparam Display display with setCursor(column, row), write(uint8_t) and
+   *                 setRGB(red, green, blue) like rgb_lcd
+   * @return size_t commands sent to the display, 0 if nothing changed
+   */
+  template <typename Display>
+  size_t render(Display& display) {
+    size_t commands = 0;
+    if(!colorWritten || memcmp(color, writtenColor, sizeof(color))) {
+      display.setRGB(color[0], color[1], color[2]);
+      memcpy(writtenColor, color, sizeof(color));
+      colorWritten = true;
+      commands++;
+    }
+
+    for(uint8_t row = 0; row < Rows; row++) {
+      for(uint8_t column = 0; column < Columns; column++) {
+        if(cells[row][column] == written[row][column]) {
+          continue;
+        }
+        // The display moves the cursor on by itself after every character,
+        // it's only set when it isn't there already
+        if(!cursorKnown || cursorRow != row || cursorColumn != column) {
+          display.setCursor(column, row);
+          commands++;
+        }
+        // A single unchanged cell between two changed ones is rewritten,
+        // that's as cheap as moving the cursor past it
+        uint8_t end = column + 1;
+        while(end < Columns && (cells[row][end] != written[row][end] ||
+              (end + 1 < Columns && cells[row][end + 1] != written[row][end + 1]))) {
+          end++;
+        }
+        for(; column < end; column++) {
+          display.write((uint8_t) cells[row][column]);
+          written[row][column] = cells[row][column];
+          commands++;
+        }
+        // The cursor doesn't wrap to the next row on its own
+        cursorKnown = end < Columns;
+        cursorRow = row;
+        cursorColumn = end;
+        column = end - 1;
+      }
+    }
+    return commands;
+  }
+
+private:
+  char cells[Rows][Columns];
+  uint8_t color[3];
+  // What the display shows
+  char written[Rows][Columns];
+  uint8_t writtenColor[3];
+  bool colorWritten;
+  // Where the next written character goes
+  bool cursorKnown;
+  uint8_t cursorRow;
+  uint8_t cursorColumn;
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef MQTT_DISPATCH_H
+#define MQTT_DISPATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Topics a node subscribes to
+#define MQTT_MAX_ROUTES 8
+// Returned for topics that weren't registered
+#define TOPIC_UNKNOWN 0xFF
+// Largest payload that is reassembled, larger ones are dropped
+#define MQTT_PAYLOAD_MAX_SIZE 1024
+
+typedef struct s_topic_route {
+  uint32_t hash;
+  uint16_t length;
+  uint8_t id;
+  const char* topic;  // has to outlive the route
+} t_topic_route;
+
+// Subscribed topics with their precomputed length and hash. Resolving the
+// topic of a message hashes it once and only compares the topic text on a
+// hash hit, no Strings are built
+typedef struct s_topic_dispatch {
+  t_topic_route routes[MQTT_MAX_ROUTES];
+  uint8_t count;
+} t_topic_dispatch;
+
+// Collects the chunks of one message. AsyncMqttClient hands payloads larger
+// than a TCP segment over in several callbacks, in order, with the offset in
+// index and the full length in total. Payloads aren't NUL terminated
+typedef struct s_payload_assembler {
+  char buffer[MQTT_PAYLOAD_MAX_SIZE + 1];
+  size_t received;
+  size_t total;         // 0 while no message is collected
+  bool discarding;      // the chunks that follow belong to a dropped message
+  uint32_t dropped;     // messages that were too large or missed a chunk
+} t_payload_assembler;
+
+/**
+ * @brief Registers a topic under an ID
+ *
+ * @param topic topic without wildcards, has to outlive the dispatch
+ * @return false if there are too many topics
+ */
+bool registerTopic(t_topic_dispatch* dispatch, const char* topic, uint8_t id);
+
+/**
+ * @brief Resolves the topic of a received message
+ *
+ * @return uint8_t ID of the topic, TOPIC_UNKNOWN if it isn't registered
+ */
+uint8_t dispatchTopic(const t_topic_dispatch* dispatch, const char* topic);
+
+/**
+ * @brief Forgets a partially received message
+ */
+void resetAssembler(t_payload_assembler* assembler);
+
+/**
+ * @brief Adds a chunk of a message
+ *
+ * @param payload chunk as passed to the MQTT message callback
+ * @param len length of the chunk
+ * @param index offset of the chunk in the message
+ * @param total length of the message
+ * @return char* the complete NUL terminated message once the last chunk
+ *         arrived, valid until the next call. NULL otherwise
+ */
+char* assemblePayload(t_payload_assembler* assembler, const char* payload, size_t len, size_t index, size_t total);
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef NFC_ALLOWLIST_H
+#define NFC_ALLOWLIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <SensorEvent.h>
+
+// Slots of the hash table, a power of two. Kept at least half empty so
+// probe sequences stay short
+#define NFC_ALLOWLIST_SLOTS 32
+#define NFC_ALLOWLIST_MAX_TAGS (NFC_ALLOWLIST_SLOTS / 2)
+// Every lookup inspects exactly this many slots. An insert that would need
+// a longer probe sequence rehashes the table with another seed
+#define NFC_ALLOWLIST_MAX_PROBE 4
+// Seeds tried before an insert gives up. A full table fits with about 3 of 4
+// seeds, so this is only reached by a broken hash
+#define NFC_ALLOWLIST_MAX_SEEDS 64
+
+// Known tags in an open addressing hash table with linear probing. A raw UID
+// is packed into a single 64 bit key (length in the top byte), so matching
+// a tag is a few word compares instead of comparing formatted strings.
+// Key 0 marks an empty slot, no valid UID packs to it
+typedef struct s_nfc_allowlist {
+  uint64_t keys[NFC_ALLOWLIST_SLOTS];
+  uint8_t actions[NFC_ALLOWLIST_SLOTS];
+  uint8_t count;
+  uint64_t seed;         // mixed into the hash, changed on a rehash
+} t_nfc_allowlist;
+
+// Token bucket limiting how often unknown tags get published
+typedef struct s_tag_rate_limiter {
+  uint8_t burst;         // tokens available after a quiet period
+  uint32_t interval;     // ms to regain a token
+  uint8_t tokens;
+  uint32_t lastRefill;   // millis() of the last refill
+} t_tag_rate_limiter;
+
+/**
+ * @brief Removes all tags
+ */
+void clearAllowlist(t_nfc_allowlist* list);
+
+/**
+ * @brief Packs a raw UID into a hash table key
+ *
+ * @return uint64_t the key, 0 if the UID is empty or too long
+ */
+uint64_t packNfcUid(const uint8_t* uid, uint8_t uidLength);
+
+/**
+ * @brief Adds a tag, replacing the action of an existing one with the same UID.
+ *        If the probe window of the tag is taken, all tags are rehashed with
+ *        the next seed that fits them
+ *
+ * @param action value returned by matchAllowlist() for the tag
+ * @return false if the UID is invalid, NFC_ALLOWLIST_MAX_TAGS are known or
+ *         none of NFC_ALLOWLIST_MAX_SEEDS fits, the table is left as it was
+ */
+bool addAllowlistTag(t_nfc_allowlist* list, const uint8_t* uid, uint8_t uidLength, uint8_t action);
+
+/**
+ * @brief Looks up the action of a tag. Takes the same time for known and
+ *        unknown tags, the whole probe window is compared without branching
+ *
+ * @param fallback returned if the tag is unknown
+ * @return uint8_t action of the tag
+ */
+uint8_t matchAllowlist(const t_nfc_allowlist* list, const uint8_t* uid, uint8_t uidLength, uint8_t fallback);
+
+/**
+ * @brief Initializes the limiter with a full bucket
+ */
+void initTagRateLimiter(t_tag_rate_limiter* limiter, uint8_t burst, uint32_t interval, uint32_t now);
+
+/**
+ * @brief Takes a token for an unknown tag
+ *
+ * @param now millis()
+ * @return true if the tag may be published, false if it should be dropped
+ */
+bool allowUnknownTag(t_tag_rate_limiter* limiter, uint32_t now);
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef NODE_MESSAGES_H
+#define NODE_MESSAGES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <ArduinoJson.h>
+#include <NodeRules.h>
+
+// Command types that can be performed on a node
+enum Command {
+  DISABLE = 0,
+  ENABLE = 1,
+  TOGGLE = 2
+};
+
+// Nodes a broadcast command can address by index. A number addresses the
+// first 32 of them, a hex string all of them
+#define BROADCAST_MAX_NODES 1024
+
+// A command addressed to this node. Fixed size, so it can be queued by value
+typedef struct s_node_command {
+  Command command;
+} t_node_command;
+
+// Topic a command was received on
+enum CommandScope : uint8_t {
+  SCOPE_NODE = 0,       // node/<id>/set, names the node once more
+  SCOPE_GROUP = 1,      // group/<name>/set, addresses every member
+  SCOPE_BROADCAST = 2   // broadcast/set, addresses nodes by index
+};
+
+enum CommandResult : uint8_t {
+  COMMAND_ACCEPTED = 0,
+  COMMAND_NOT_ADDRESSED = 1,
+  COMMAND_INVALID = 2
+};
+
+/**
+ * @brief Reads a parsed command message, e.g. {"node":"node-1","command":2},
+ *        {"command":2}, {"nodes":5,"command":2} or {"nodes":"100000005","command":2}
+ *
+ * @param message parsed JSON of the message
+ * @param scope topic the message was received on
+ * @param node identifier of this node
+ * @param index position of this node in the bitset of broadcast commands
+ * @param command filled with the command if it was accepted
+ * @return COMMAND_NOT_ADDRESSED if the command is meant for other nodes,
+ *         COMMAND_INVALID if it has no known command
+ */
+CommandResult readCommand(JsonVariantConst message, CommandScope scope, const char* node, uint16_t index,
+                          t_node_command* command);
+
+/**
+ * @brief Decides whether a broadcast command addresses a node
+ *
+ * @param nodes bitset of node indices as a number (e.g. 5 for the first and
+ *              third node, up to 32 nodes) or as hex digits, most
+ *              significant first (e.g. "100000005" adds the 33rd node), or a
+ *              list of node indices (e.g. [0, 2, 32])
+ * @param index position of the node in the bitset
+ */
+bool isBroadcastTarget(JsonVariantConst nodes, uint16_t index);
+
+/**
+ * @brief Compiles the rules of a parsed config message, e.g.
+ *        {"ir":{"toggle":[...],"on":[...],"off":[...]},"nfc":{"toggle":["8E:FC:5B:22"],"known":[...]}}
+ *        Known tags are those of the other nodes, they match as RULE_KNOWN
+ *
+ * @param config parsed JSON of the message
+ * @param rules cleared and filled with the rules
+ * @return false if rules were invalid or didn't fit, the others are kept
+ */
+bool readRules(JsonVariantConst config, t_node_rules* rules);
+
+#endif
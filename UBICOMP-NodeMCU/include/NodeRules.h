@@ -0,0 +1,79 @@
+#ifndef NODE_RULES_H
+#define NODE_RULES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <SensorEvent.h>
+#include <NfcAllowlist.h>
+
+#define RULES_MAX_IR 16
+
+// What a matching rule does to this node. The values match the node commands
+enum RuleAction : uint8_t {
+  RULE_DISABLE = 0,
+  RULE_ENABLE = 1,
+  RULE_TOGGLE = 2,
+  // A tag of the fleet's config that only switches other nodes
+  RULE_KNOWN = 0xFE,
+  RULE_NONE = SENSOR_NO_ACTION
+};
+
+typedef struct s_ir_rule {
+  uint32_t code;
+  RuleAction action;
+} t_ir_rule;
+
+// The slice of the coordinator's rules that affects this node. IR rules are
+// sorted by code so a match is a binary search, known NFC tags are hashed
+typedef struct s_node_rules {
+  t_ir_rule ir[RULES_MAX_IR];
+  uint8_t irCount;
+  t_nfc_allowlist nfc;
+} t_node_rules;
+
+/**
+ * @brief Removes all rules
+ */
+void clearRules(t_node_rules* rules);
+
+/**
+ * @brief Adds a rule for an IR code, replacing an existing one for the same code
+ *
+ * @return false if the rule table is full
+ */
+bool addIRRule(t_node_rules* rules, uint32_t code, RuleAction action);
+
+/**
+ * @brief Adds a rule for an NFC UID, replacing an existing one for the same UID
+ *
+ * @param uid UID formatted as hex bytes separated by colons (e.g. "8E:FC:5B:22")
+ * @return false if the UID is malformed or the allowlist is full
+ */
+bool addNfcRule(t_node_rules* rules, const char* uid, RuleAction action);
+
+/**
+ * @brief Looks up the action for an IR code
+ *
+ * @return RuleAction action of the matching rule, RULE_NONE if there is none
+ */
+RuleAction matchIRRule(const t_node_rules* rules, uint32_t code);
+
+/**
+ * @brief Looks up the action for a read NFC tag
+ *
+ * @return RuleAction action of the matching rule, RULE_KNOWN for a tag of
+ *         another node, RULE_NONE for a tag the fleet doesn't know
+ */
+RuleAction matchNfcRule(const t_node_rules* rules, const t_nfc_data* nfc);
+
+/**
+ * @brief Parses a UID formatted as hex bytes separated by colons
+ *
+ * @param text formatted UID
+ * @param uid filled with up to NFC_UID_MAX_LENGTH bytes
+ * @param uidLength filled with the number of bytes
+ * @return false if the text is no valid UID
+ */
+bool parseNfcUid(const char* text, uint8_t* uid, uint8_t* uidLength);
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef PRESENTERS_H
+#define PRESENTERS_H
+
+#include <Arduino.h>
+
+// LCD
+#include "rgb_lcd.h"
+#include <LcdFrame.h>
+#include <I2cBus.h>
+
+#include <Trace.h>
+
+/*
+ * Every presenter is a component selected at compile time by its build flag,
+ * like the sensors in Sensors.h. A presenter shows whether the node is
+ * enabled, the disabled specialization is empty and does nothing.
+ */
+
+/**
+ * @brief LED that is lit while the node is enabled
+ *
+ * @tparam Enabled P_LED_ENABLED
+ * @tparam Pin pin of the LED
+ */
+template <bool Enabled, int Pin>
+class LedPresenter {
+public:
+  void setup() {}
+  void present(bool) {}
+};
+
+template <int Pin>
+class LedPresenter<true, Pin> {
+public:
+  void setup() {
+    pinMode(Pin, OUTPUT);
+  }
+
+  void present(bool on) {
+    digitalWrite(Pin, on ? HIGH : LOW);
+  }
+};
+
+/**
+ * @brief Grove RGB LCD, green while the node is enabled and red otherwise
+ *
+ * @tparam Enabled P_LCD_ENABLED
+ * @tparam Bus I2C bus the LCD is connected to, rgb_lcd always uses Wire
+ */
+template <bool Enabled, I2cBus& Bus>
+class LcdPresenter {
+public:
+  void setup() {}
+  void present(bool) {}
+};
+
+template <I2cBus& Bus>
+class LcdPresenter<true, Bus> {
+public:
+  void setup() {
+    device = Bus.addDevice("lcd", I2C_PRIORITY_LOW);
+    I2cTransaction transaction(Bus, device);
+    lcd.begin(16, 2);
+    lcd.display();
+    // begin() cleared the display, but the frame writes every cell anyway
+    frame.invalidate();
+  }
+
+  // Only the changed cells and colour are written, the LCD shares its bus
+  // with the NFC reader
+  void present(bool on) {
+    TRACE_BEGIN(TRACE_LCD, on, 0);
+    if(on) {
+      frame.setColor(0, 255, 0);
+    } else {
+      frame.setColor(255, 0, 0);
+    }
+    frame.setLine(0, on ? "ENABLED" : "DISABLED");
+    frame.setLine(1, "");
+    BusDisplay display = { lcd, device };
+    size_t commands = frame.render(display);
+    TRACE_END(TRACE_LCD, on, commands);
+  }
+
+private:
+  // Sends every command as a transaction of its own, waiting PN532 frames
+  // get in between them
+  struct BusDisplay {
+    rgb_lcd& lcd;
+    t_i2c_device* device;
+
+    void setCursor(uint8_t column, uint8_t row) {
+      I2cTransaction transaction(Bus, device);
+      lcd.setCursor(column, row);
+    }
+
+    size_t write(uint8_t character) {
+      I2cTransaction transaction(Bus, device);
+      return lcd.write(character);
+    }
+
+    void setRGB(uint8_t red, uint8_t green, uint8_t blue) {
+      I2cTransaction transaction(Bus, device);
+      lcd.setRGB(red, green, blue);
+    }
+  };
+
+  rgb_lcd lcd;
+  t_i2c_device* device = NULL;
+  LcdFrame<16, 2> frame;
+};
+
+/**
+ * @brief All presenters of the node, each call is passed on to every one of
+ *        them. The presenters are base classes, so disabled (empty) ones
+ *        take no space
+ *
+ * @tparam Presenters presenter components, e.g. LedPresenter<P_LED_ENABLED, LED>
+ */
+template <typename... Presenters>
+class Presentation;
+
+template <>
+class Presentation<> {
+public:
+  void setup() {}
+  void present(bool) {}
+};
+
+template <typename First, typename... Rest>
+class Presentation<First, Rest...> : private First, private Presentation<Rest...> {
+public:
+  void setup() {
+    First::setup();
+    Presentation<Rest...>::setup();
+  }
+
+  void present(bool on) {
+    First::present(on);
+    Presentation<Rest...>::present(on);
+  }
+};
+
+#endif
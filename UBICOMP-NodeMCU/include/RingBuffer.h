@@ -0,0 +1,71 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stddef.h>
+
+/**
+ * @brief Bounded ring buffer that is only used by a single task, so it takes
+ *        no lock - see SpscQueue for passing elements between tasks. Once
+ *        full, the oldest element is overwritten to make room.
+ *
+ * @tparam T element type, copied in by value
+ * @tparam N capacity, has to be a power of two
+ */
+template <typename T, size_t N>
+class RingBuffer {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "RingBuffer capacity has to be a power of two");
+
+public:
+  RingBuffer() : head(0), tail(0) {}
+
+  /**
+   * @brief Append an element, overwrites the oldest one if full
+   *
+   * @return false if the oldest element was overwritten
+   */
+  bool push(const T& item) {
+    bool full = size() == N;
+    if(full) {
+      tail++;
+    }
+    buffer[head++ & (N - 1)] = item;
+    return !full;
+  }
+
+  /**
+   * @brief Element at a position, 0 is the oldest. The position has to be
+   *        smaller than size()
+   */
+  const T& at(size_t index) const {
+    return buffer[(tail + index) & (N - 1)];
+  }
+
+  /**
+   * @brief Removes the oldest elements
+   *
+   * @param count number of elements, at most size()
+   */
+  void drop(size_t count) {
+    tail += count;
+  }
+
+  size_t size() const {
+    return head - tail;
+  }
+
+  bool empty() const {
+    return head == tail;
+  }
+
+  static size_t capacity() {
+    return N;
+  }
+
+private:
+  T buffer[N];
+  // Free running counters
+  size_t head;
+  size_t tail;
+};
+
+#endif
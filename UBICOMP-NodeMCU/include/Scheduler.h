@@ -0,0 +1,73 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Tasks a single scheduler takes
+#define SCHEDULER_MAX_TASKS 4
+
+// Work of a task, has to return after at most its budget
+typedef void (*t_task_function)();
+// Current time (us), wrapping around. micros() on the device, a virtual
+// clock on the host
+typedef uint32_t (*t_scheduler_clock)();
+
+// A periodic task. Each release is due by the next one (implicit deadline)
+typedef struct s_scheduled_task {
+  const char* name;
+  t_task_function run;
+  uint32_t period;   // us between releases
+  uint32_t budget;   // us, worst case execution time
+  uint32_t release;  // us, when the task is due next
+  // Counters since the task was added
+  uint32_t runs;
+  uint32_t misses;    // runs that ended after their deadline and skipped releases
+  uint32_t overruns;  // runs that took longer than their budget
+} t_scheduled_task;
+
+// Cooperative earliest deadline first scheduler. Tasks aren't preempted,
+// the budgets keep the others on time
+typedef struct s_scheduler {
+  t_scheduled_task tasks[SCHEDULER_MAX_TASKS];
+  uint8_t count;
+  uint32_t utilization;  // sum of budget / period of all tasks, in 1/1000
+} t_scheduler;
+
+/**
+ * @brief Starts without tasks
+ */
+void initScheduler(t_scheduler* scheduler);
+
+/**
+ * @brief Adds a periodic task, first released right away. Tasks are only
+ *        admitted while the sum of their budgets per period stays at 100%
+ *        and no budget is longer than the period of another task
+ *
+ * @param name name of the task, for reports
+ * @param run work of the task
+ * @param period us between releases
+ * @param budget us the task takes at most
+ * @param now current time (us)
+ * @return int index of the task, -1 if it wasn't admitted
+ */
+int addScheduledTask(t_scheduler* scheduler, const char* name, t_task_function run, uint32_t period, uint32_t budget, uint32_t now);
+
+/**
+ * @brief The released task with the earliest deadline. Ties go to the task
+ *        added first
+ *
+ * @param now current time (us)
+ * @return int index of the task, -1 if no task is released
+ */
+int nextScheduledTask(const t_scheduler* scheduler, uint32_t now);
+
+/**
+ * @brief Runs the next task and counts whether it met its deadline and budget
+ *
+ * @param clock time source
+ * @return uint32_t 0 if a task ran, otherwise us until the next release
+ */
+uint32_t runScheduler(t_scheduler* scheduler, t_scheduler_clock clock);
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef SENSOR_EVENT_H
+#define SENSOR_EVENT_H
+
+#include <stdint.h>
+#include <IRCodes.h>
+
+// No command was executed locally for a sensor reading
+#define SENSOR_NO_ACTION 0xFF
+
+// Longest ISO14443A UID (double size)
+#define NFC_UID_MAX_LENGTH 7
+// Longest UID formatted as "XX:XX:...", including the terminator
+#define NFC_UID_STRING_LENGTH (NFC_UID_MAX_LENGTH * 3)
+
+// Data that we get from the IR Sensor
+typedef struct s_ir_data {
+  uint32_t code;
+  uint16_t command;
+  uint8_t button;  // IRButton the code resolved to, IR_BUTTON_NONE if unknown
+  uint8_t action;  // command executed by a local rule or SENSOR_NO_ACTION
+} t_ir_data;
+
+// Features of the sound sensor signal over one publish interval,
+// in ADC counts around the DC offset
+typedef struct s_sound_data {
+  uint16_t rms;
+  uint16_t peak;
+  uint16_t envelope;
+} t_sound_data;
+
+// Kinds of acoustic events detected on the sound signal
+enum AcousticKind : uint8_t {
+  ACOUSTIC_CLAP = 0,  // short and loud
+  ACOUSTIC_LOUD = 1   // loud for longer than a clap
+};
+
+// A discrete event detected on the sound signal
+typedef struct s_acoustic_data {
+  AcousticKind kind;
+  uint16_t peak;      // highest level, in ADC counts around the DC offset
+  uint16_t duration;  // ms
+  uint32_t onset;     // millis() when the level crossed the threshold
+} t_acoustic_data;
+
+// Data that we get from the NFC Sensor. The UID is kept raw, it's only
+// formatted when the event gets published
+typedef struct s_nfc_data {
+  uint8_t uid[NFC_UID_MAX_LENGTH];
+  uint8_t uidLength;
+  uint8_t tagType;  // TAG_TYPE_* as guessed by the NfcAdapter
+  uint8_t action;   // command executed by a local rule or SENSOR_NO_ACTION
+} t_nfc_data;
+
+// Same value as the NfcAdapter's TAG_TYPE_MIFARE_CLASSIC
+#define NFC_TAG_TYPE_MIFARE_CLASSIC 0
+
+// Which sensor an event originates from
+enum SensorType : uint8_t {
+  SENSOR_IR = 0,
+  SENSOR_SOUND = 1,
+  SENSOR_NFC = 2,
+  SENSOR_ACOUSTIC = 3
+};
+
+// A single reading of any sensor. Events are stored by value in statically
+// sized rings and recycled once published, so reading a sensor never allocates
+typedef struct s_sensor_event {
+  SensorType type;
+  uint32_t timestamp;  // millis() when the sensor was read
+  union {
+    t_ir_data ir;
+    t_sound_data sound;
+    t_nfc_data nfc;
+    t_acoustic_data acoustic;
+  };
+} t_sensor_event;
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef SENSOR_JSON_H
+#define SENSOR_JSON_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <SensorEvent.h>
+#include <LatencyHistogram.h>
+#include <Scheduler.h>
+#include <I2cDevice.h>
+
+// Sizes of the per-topic output buffers. Each one fits the largest payload
+// of its fixed schema, including the terminator
+#define IR_JSON_SIZE 80     // {"code":4294967295,"command":65535,"button":"DIM_DOWN","action":2}
+#define SOUND_JSON_SIZE 48  // {"rms":65535,"peak":65535,"envelope":65535}
+#define NFC_JSON_SIZE 80    // {"uid":"XX:XX:XX:XX:XX:XX:XX","type":"NFC Forum Type 2","action":2}
+#define ACOUSTIC_JSON_SIZE 72  // {"event":"clap","onset":4294967295,"peak":65535,"duration":65535}
+#define STATE_JSON_SIZE 64  // {"state":1,"node":"..."}
+// Largest single event within a batch, e.g.
+// {"sensor":"nfc","timestamp":4294967295,"uid":"XX:XX:XX:XX:XX:XX:XX","type":"NFC Forum Type 2","action":2}
+#define SENSOR_EVENT_JSON_SIZE 128
+// Buffer size for a batch of count events: brackets, events and separators
+#define BATCH_JSON_SIZE(count) (2 + (count) * (SENSOR_EVENT_JSON_SIZE + 1))
+// Metrics of count histograms, e.g. ,"loop":{"sum":4294967295,"buckets":[...]}
+#define METRICS_JSON_SIZE(count) (32 + (count) * (48 + LATENCY_BUCKETS * 11))
+// Boot times of count phases, e.g. ,"wifi":4294967295 after {"build":"..."}
+#define BOOT_JSON_SIZE(count) (80 + (count) * 32)
+#define DROPPED_JSON_SIZE 24  // {"dropped":4294967295}
+// Schedule of count tasks, e.g. ,"sound":{"period":4294967295,"budget":...}
+#define SCHEDULE_JSON_SIZE(count) (2 + (count) * 128)
+// Bus use of count devices, e.g. ,"nfc":{"transactions":4294967295,"busy":...}
+#define BUS_JSON_SIZE(count) (2 + (count) * 96)
+
+/**
+ * @brief Serializers for the fixed sensor and state schemas. They write straight
+ *        into a caller-provided buffer and never allocate, unlike a
+ *        DynamicJsonDocument serialized into a String.
+ *
+ *        All of them return the length of the written JSON (without the terminator)
+ *        or 0 if it didn't fit into the buffer.
+ */
+size_t writeIrJson(char* out, size_t size, const t_ir_data* ir);
+size_t writeSoundJson(char* out, size_t size, const t_sound_data* sound);
+size_t writeNfcJson(char* out, size_t size, const t_nfc_data* nfc);
+size_t writeAcousticJson(char* out, size_t size, const t_acoustic_data* acoustic);
+size_t writeStateJson(char* out, size_t size, uint8_t state, const char* node);
+
+/**
+ * @brief Serializes sensor events as one JSON array. Every element carries the
+ *        sensor name and timestamp next to the fields of the per-sensor schema,
+ *        e.g. [{"sensor":"ir","timestamp":1200,"code":16750695,"command":7}]
+ */
+size_t writeBatchJson(char* out, size_t size, const t_sensor_event* events, size_t count);
+
+/**
+ * @brief Serializes latency histograms of one interval, e.g.
+ *        {"interval":10000,"loop":{"sum":5120,"buckets":[0,12,830]}}. Empty
+ *        buckets at the end are left out
+ *
+ * @param interval length of the interval (ms)
+ * @param names name of each histogram
+ */
+size_t writeMetricsJson(char* out, size_t size, uint32_t interval, const t_latency_histogram* histograms, const char* const* names, size_t count);
+
+/**
+ * @brief Serializes the boot times of a firmware build, e.g.
+ *        {"build":"Oct 17 2026 09:12:44","setup":31,"nfc":64,"wifi":1250}.
+ *        Phases that weren't reached (time 0) are null
+ *
+ * @param build identifies the firmware build
+ * @param times ms since reset each phase was reached at
+ * @param names name of each phase
+ */
+size_t writeBootJson(char* out, size_t size, const char* build, const uint32_t* times, const char* const* names, size_t count);
+
+/**
+ * @brief Serializes the number of sensor events that were dropped, e.g.
+ *        {"dropped":12}
+ */
+size_t writeDroppedJson(char* out, size_t size, uint32_t dropped);
+
+/**
+ * @brief Serializes the periods, budgets (us) and counters of scheduled tasks,
+ *        e.g. {"ir":{"period":10000,"budget":1000,"runs":120,"misses":0,"overruns":2}}
+ */
+size_t writeScheduleJson(char* out, size_t size, const t_scheduled_task* tasks, size_t count);
+
+/**
+ * @brief Serializes the transactions and the time (us) each device held and
+ *        waited for the I2C bus, e.g.
+ *        {"nfc":{"transactions":5210,"busy":80412,"wait":310}}
+ */
+size_t writeBusJson(char* out, size_t size, const t_i2c_device* devices, size_t count);
+
+/**
+ * @brief Formats a raw NFC UID as upper case hex bytes separated by colons
+ *        (e.g. "8E:FC:5B:22")
+ *
+ * @param nfc data read from the NFC tag
+ * @param out buffer of at least NFC_UID_STRING_LENGTH chars
+ */
+void formatNfcUid(const t_nfc_data* nfc, char* out);
+
+/**
+ * @brief Human readable type of an NFC tag
+ *
+ * @param nfc data read from the NFC tag
+ * @return const char* name of the guessed tag type
+ */
+const char* nfcTagTypeName(const t_nfc_data* nfc);
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef SENSOR_MSGPACK_H
+#define SENSOR_MSGPACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <SensorEvent.h>
+#include <LatencyHistogram.h>
+#include <Scheduler.h>
+#include <I2cDevice.h>
+
+// First element of every binary payload. Bumped whenever a layout changes
+#define MSGPACK_PAYLOAD_VERSION 1
+
+// Sizes of the per-topic output buffers. Each one fits the largest payload
+// of its fixed layout
+#define IR_MSGPACK_SIZE 16        // [version, code, command, button, action]
+#define SOUND_MSGPACK_SIZE 16     // [version, rms, peak, envelope]
+#define NFC_MSGPACK_SIZE 16       // [version, uid (bin), type, action]
+#define ACOUSTIC_MSGPACK_SIZE 16  // [version, kind, onset, peak, duration]
+#define STATE_MSGPACK_SIZE 40     // [version, state, node]
+// Largest single event within a batch, e.g. [type, timestamp, uid, type, action]
+#define SENSOR_EVENT_MSGPACK_SIZE 24
+// Buffer size for a batch of count events: array header, version and events
+#define BATCH_MSGPACK_SIZE(count) (4 + (count) * SENSOR_EVENT_MSGPACK_SIZE)
+// Metrics of count histograms: [version, interval, [sum, bucket...]...]
+#define METRICS_MSGPACK_SIZE(count) (8 + (count) * (8 + LATENCY_BUCKETS * 5))
+// Boot times of count phases: [version, build, time...]
+#define BOOT_MSGPACK_SIZE(count) (48 + (count) * 5)
+#define DROPPED_MSGPACK_SIZE 8  // [version, dropped]
+// Schedule of count tasks: [version, [period, budget, runs, misses, overruns]...]
+#define SCHEDULE_MSGPACK_SIZE(count) (4 + (count) * 26)
+// Bus use of count devices: [version, [transactions, busy, wait]...]
+#define BUS_MSGPACK_SIZE(count) (4 + (count) * 16)
+
+/**
+ * @brief Serializers of the sensor and state payloads as MessagePack arrays.
+ *        Fields are positional, integers take the smallest encoding, UIDs stay
+ *        raw bytes and names are sent as their enum values. An action of 
+ *        SENSOR_NO_ACTION is encoded as nil.
+ *
+ *        All of them return the length of the written payload or 0 if it
+ *        didn't fit into the buffer. The payload isn't terminated.
+ */
+size_t writeIrMsgPack(uint8_t* out, size_t size, const t_ir_data* ir);
+size_t writeSoundMsgPack(uint8_t* out, size_t size, const t_sound_data* sound);
+size_t writeNfcMsgPack(uint8_t* out, size_t size, const t_nfc_data* nfc);
+size_t writeAcousticMsgPack(uint8_t* out, size_t size, const t_acoustic_data* acoustic);
+size_t writeStateMsgPack(uint8_t* out, size_t size, uint8_t state, const char* node);
+
+/**
+ * @brief Serializes sensor events as [version, event...]. Every event is an
+ *        array of its SensorType and timestamp followed by the fields of the
+ *        per-sensor layout, without the version
+ */
+size_t writeBatchMsgPack(uint8_t* out, size_t size, const t_sensor_event* events, size_t count);
+
+/**
+ * @brief Serializes latency histograms of one interval as
+ *        [version, interval, [sum, bucket...]...], in the order of the
+ *        histograms. Empty buckets at the end are left out
+ */
+size_t writeMetricsMsgPack(uint8_t* out, size_t size, uint32_t interval, const t_latency_histogram* histograms, size_t count);
+
+/**
+ * @brief Serializes the boot times of a firmware build as
+ *        [version, build, time...], in the order of the phases. Phases that
+ *        weren't reached (time 0) are nil
+ */
+size_t writeBootMsgPack(uint8_t* out, size_t size, const char* build, const uint32_t* times, size_t count);
+
+/**
+ * @brief Serializes the number of sensor events that were dropped as
+ *        [version, dropped]
+ */
+size_t writeDroppedMsgPack(uint8_t* out, size_t size, uint32_t dropped);
+
+/**
+ * @brief Serializes scheduled tasks as
+ *        [version, [period, budget, runs, misses, overruns]...], in the order
+ *        of the tasks
+ */
+size_t writeScheduleMsgPack(uint8_t* out, size_t size, const t_scheduled_task* tasks, size_t count);
+
+/**
+ * @brief Serializes the bus use of devices as
+ *        [version, [transactions, busy, wait]...], in the order of the devices
+ */
+size_t writeBusMsgPack(uint8_t* out, size_t size, const t_i2c_device* devices, size_t count);
+
+#endif
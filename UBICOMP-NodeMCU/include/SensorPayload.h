@@ -0,0 +1,109 @@
+#ifndef SENSOR_PAYLOAD_H
+#define SENSOR_PAYLOAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <SensorEvent.h>
+
+// Encoding of the sensor and state payloads, chosen at build time. Only the
+// selected serializers are referenced, the others aren't linked in.
+// Build with -D BINARY_PAYLOADS for MessagePack, JSON otherwise
+#ifdef BINARY_PAYLOADS
+#include <SensorMsgPack.h>
+
+#define IR_PAYLOAD_SIZE IR_MSGPACK_SIZE
+#define SOUND_PAYLOAD_SIZE SOUND_MSGPACK_SIZE
+#define NFC_PAYLOAD_SIZE NFC_MSGPACK_SIZE
+#define ACOUSTIC_PAYLOAD_SIZE ACOUSTIC_MSGPACK_SIZE
+#define STATE_PAYLOAD_SIZE STATE_MSGPACK_SIZE
+#define BATCH_PAYLOAD_SIZE(count) BATCH_MSGPACK_SIZE(count)
+#define METRICS_PAYLOAD_SIZE(count) METRICS_MSGPACK_SIZE(count)
+#define BOOT_PAYLOAD_SIZE(count) BOOT_MSGPACK_SIZE(count)
+#define DROPPED_PAYLOAD_SIZE DROPPED_MSGPACK_SIZE
+#define SCHEDULE_PAYLOAD_SIZE(count) SCHEDULE_MSGPACK_SIZE(count)
+#define BUS_PAYLOAD_SIZE(count) BUS_MSGPACK_SIZE(count)
+
+inline size_t writeIrPayload(char* out, size_t size, const t_ir_data* ir) {
+  return writeIrMsgPack((uint8_t*) out, size, ir);
+}
+inline size_t writeSoundPayload(char* out, size_t size, const t_sound_data* sound) {
+  return writeSoundMsgPack((uint8_t*) out, size, sound);
+}
+inline size_t writeNfcPayload(char* out, size_t size, const t_nfc_data* nfc) {
+  return writeNfcMsgPack((uint8_t*) out, size, nfc);
+}
+inline size_t writeAcousticPayload(char* out, size_t size, const t_acoustic_data* acoustic) {
+  return writeAcousticMsgPack((uint8_t*) out, size, acoustic);
+}
+inline size_t writeStatePayload(char* out, size_t size, uint8_t state, const char* node) {
+  return writeStateMsgPack((uint8_t*) out, size, state, node);
+}
+inline size_t writeBatchPayload(char* out, size_t size, const t_sensor_event* events, size_t count) {
+  return writeBatchMsgPack((uint8_t*) out, size, events, count);
+}
+inline size_t writeMetricsPayload(char* out, size_t size, uint32_t interval, const t_latency_histogram* histograms, const char* const* names, size_t count) {
+  return writeMetricsMsgPack((uint8_t*) out, size, interval, histograms, count);
+}
+inline size_t writeBootPayload(char* out, size_t size, const char* build, const uint32_t* times, const char* const* names, size_t count) {
+  return writeBootMsgPack((uint8_t*) out, size, build, times, count);
+}
+inline size_t writeDroppedPayload(char* out, size_t size, uint32_t dropped) {
+  return writeDroppedMsgPack((uint8_t*) out, size, dropped);
+}
+inline size_t writeSchedulePayload(char* out, size_t size, const t_scheduled_task* tasks, size_t count) {
+  return writeScheduleMsgPack((uint8_t*) out, size, tasks, count);
+}
+inline size_t writeBusPayload(char* out, size_t size, const t_i2c_device* devices, size_t count) {
+  return writeBusMsgPack((uint8_t*) out, size, devices, count);
+}
+#else
+#include <SensorJson.h>
+
+#define IR_PAYLOAD_SIZE IR_JSON_SIZE
+#define SOUND_PAYLOAD_SIZE SOUND_JSON_SIZE
+#define NFC_PAYLOAD_SIZE NFC_JSON_SIZE
+#define ACOUSTIC_PAYLOAD_SIZE ACOUSTIC_JSON_SIZE
+#define STATE_PAYLOAD_SIZE STATE_JSON_SIZE
+#define BATCH_PAYLOAD_SIZE(count) BATCH_JSON_SIZE(count)
+#define METRICS_PAYLOAD_SIZE(count) METRICS_JSON_SIZE(count)
+#define BOOT_PAYLOAD_SIZE(count) BOOT_JSON_SIZE(count)
+#define DROPPED_PAYLOAD_SIZE DROPPED_JSON_SIZE
+#define SCHEDULE_PAYLOAD_SIZE(count) SCHEDULE_JSON_SIZE(count)
+#define BUS_PAYLOAD_SIZE(count) BUS_JSON_SIZE(count)
+
+inline size_t writeIrPayload(char* out, size_t size, const t_ir_data* ir) {
+  return writeIrJson(out, size, ir);
+}
+inline size_t writeSoundPayload(char* out, size_t size, const t_sound_data* sound) {
+  return writeSoundJson(out, size, sound);
+}
+inline size_t writeNfcPayload(char* out, size_t size, const t_nfc_data* nfc) {
+  return writeNfcJson(out, size, nfc);
+}
+inline size_t writeAcousticPayload(char* out, size_t size, const t_acoustic_data* acoustic) {
+  return writeAcousticJson(out, size, acoustic);
+}
+inline size_t writeStatePayload(char* out, size_t size, uint8_t state, const char* node) {
+  return writeStateJson(out, size, state, node);
+}
+inline size_t writeBatchPayload(char* out, size_t size, const t_sensor_event* events, size_t count) {
+  return writeBatchJson(out, size, events, count);
+}
+inline size_t writeMetricsPayload(char* out, size_t size, uint32_t interval, const t_latency_histogram* histograms, const char* const* names, size_t count) {
+  return writeMetricsJson(out, size, interval, histograms, names, count);
+}
+inline size_t writeBootPayload(char* out, size_t size, const char* build, const uint32_t* times, const char* const* names, size_t count) {
+  return writeBootJson(out, size, build, times, names, count);
+}
+inline size_t writeDroppedPayload(char* out, size_t size, uint32_t dropped) {
+  return writeDroppedJson(out, size, dropped);
+}
+inline size_t writeSchedulePayload(char* out, size_t size, const t_scheduled_task* tasks, size_t count) {
+  return writeScheduleJson(out, size, tasks, count);
+}
+inline size_t writeBusPayload(char* out, size_t size, const t_i2c_device* devices, size_t count) {
+  return writeBusJson(out, size, devices, count);
+}
+#endif
+
+#endif
@@ -0,0 +1,392 @@
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include <Arduino.h>
+
+// Grove NFC
+#include <I2cBus.h>
+#include <PN532/PN532_I2C/PN532_I2C.h>
+#include <NfcAdapter.h>
+
+// IR
+#include <IRremoteESP8266.h>
+#include <IRrecv.h>
+#include <IRutils.h>
+#include <IRCodes.h>
+
+// Sound
+#include <driver/i2s.h>
+#include <driver/adc.h>
+#include <SoundFeatures.h>
+#include <SoundDetector.h>
+
+#include <SensorEvent.h>
+#include <Trace.h>
+
+/*
+ * Every sensor is a component selected at compile time by its build flag.
+ * The enabled specialization owns the driver and the state of the sensor,
+ * the disabled one is empty and its inline no-ops fold away - a disabled
+ * sensor takes no flash, RAM or constructor time and the callers need no
+ * runtime checks. Both specializations take the same constructor arguments.
+ *
+ * The components only read the hardware into a t_sensor_event, rules,
+ * metrics and queueing stay with the caller.
+ */
+
+/**
+ * @brief PN532 NFC reader on I2C
+ *
+ * @tparam Enabled S_NFC_ENABLED
+ */
+template <bool Enabled>
+class NfcSensor;
+
+template <>
+class NfcSensor<true> {
+public:
+  static const bool ENABLED = true;
+
+  /**
+   * @param bus I2C bus the PN532 is connected to
+   * @param timeout a pending tag detection without response for this long (ms)
+   *                means that no tag is held against the antenna
+   * @param startTimeout the reader is given up if it didn't answer this long (ms)
+   *                     after setup()
+   * @param responseTimeout longest wait (ms) for each answer while the reader
+   *                        starts, it's asked again by the next poll
+   */
+  NfcSensor(I2cBus& bus, unsigned long timeout, unsigned long startTimeout, uint16_t responseTimeout)
+    : bus(bus), device(NULL), i2c(bus.wire()), nfc(i2c), timeout(timeout), startTimeout(startTimeout),
+      responseTimeout(responseTimeout), status(NFC_STARTING), started(0), mutex(false), polling(false),
+      pollStarted(0) {}
+
+  /**
+   * @brief Joins the I2C bus without waiting for the PN532 to wake up,
+   *        read() polls until it answers. PN532 frames take the bus before
+   *        waiting updates of other devices
+   */
+  void setup() {
+    device = bus.addDevice("nfc", I2C_PRIORITY_HIGH);
+    I2cTransaction transaction(bus, device);
+    nfc.startBegin();
+    started = millis();
+  }
+
+  // Whether the PN532 answered and reads tags
+  bool ready() const {
+    return status == NFC_READY;
+  }
+
+  // Whether the PN532 didn't answer in time and was given up
+  bool missing() const {
+    return status == NFC_MISSING;
+  }
+
+  /**
+   * @brief Read the UID of a tag. The detection is split-phase: the first call
+   *        asks the PN532 to wait for a tag and returns right away, later calls
+   *        only check whether the PN532 answered. Hence the caller never blocks
+   *        on the NFC reader.
+   *
+   * @param event filled with the UID and type of the tag, the action is left
+   *              to the caller
+   * @return true if a new tag was read, false if no tag was present
+   */
+  bool read(t_sensor_event* event) {
+    // Every call exchanges at most a few frames, they're one transaction so
+    // no other device gets between a command and its response
+    I2cTransaction transaction(bus, device);
+    if(status != NFC_READY) {
+      start();
+      return false;
+    }
+
+    // Start a new detection, the response will be collected in a later call
+    if(!polling) {
+      if(nfc.startTagDetection()) {
+        polling = true;
+        pollStarted = millis();
+      }
+      return false;
+    }
+
+    if(!nfc.tagDetectionReady()) {
+      // The PN532 is still waiting for a tag. The detection stays pending, but
+      // we're freeing the mutex as the previous tag has left the field
+      if(millis() - pollStarted > timeout) {
+        mutex = false;
+      }
+      return false;
+    }
+
+    polling = false;
+    if(!nfc.readDetectedTag()) {
+      mutex = false;
+      return false;
+    }
+
+    // We're using a simple mutex to prevent reading the same tag over and
+    // over again if it is held against the antenna
+    if(mutex) {
+      return false;
+    }
+    mutex = true;
+
+    // Only the raw UID and type are of interest, the NDEF message isn't read
+    event->type = SENSOR_NFC;
+    event->timestamp = millis();
+    event->nfc.uidLength = nfc.getUidLength();
+    event->nfc.tagType = nfc.guessTagType();
+    nfc.getUid(event->nfc.uid, sizeof(event->nfc.uid));
+    event->nfc.action = SENSOR_NO_ACTION;
+    return true;
+  }
+
+private:
+  enum Status : uint8_t {
+    NFC_STARTING,
+    NFC_READY,
+    NFC_MISSING
+  };
+
+  // Asks the PN532 for its firmware version, it doesn't answer before it
+  // woke up. Replaces the fixed delay of NfcAdapter::begin(). Runs within the
+  // transaction of read(), so it only waits responseTimeout per answer
+  void start() {
+    if(status != NFC_STARTING) {
+      return;
+    }
+    if(nfc.beginReady(responseTimeout)) {
+      status = NFC_READY;
+    } else if(millis() - started > startTimeout) {
+      status = NFC_MISSING;
+      Serial.println("Didn't find PN53x board");
+    }
+  }
+
+  I2cBus& bus;
+  t_i2c_device* device;
+  PN532_I2C i2c;
+  NfcAdapter nfc;
+  unsigned long timeout;
+  unsigned long startTimeout;
+  uint16_t responseTimeout;
+  Status status;
+  unsigned long started;
+  // Whether the last tag is still held against the antenna
+  bool mutex;
+  // Whether a tag detection is pending on the PN532 and since when
+  bool polling;
+  unsigned long pollStarted;
+};
+
+template <>
+class NfcSensor<false> {
+public:
+  static const bool ENABLED = false;
+
+  NfcSensor(I2cBus&, unsigned long, unsigned long, uint16_t) {}
+  void setup() {}
+  bool ready() const { return false; }
+  bool missing() const { return false; }
+  bool read(t_sensor_event*) { return false; }
+};
+
+/**
+ * @brief IR receiver
+ *
+ * @tparam Enabled S_IR_ENABLED
+ */
+template <bool Enabled>
+class IrSensor;
+
+template <>
+class IrSensor<true> {
+public:
+  static const bool ENABLED = true;
+
+  /**
+   * @param pin pin of the IR receiver
+   */
+  explicit IrSensor(uint16_t pin) : receiver(pin) {}
+
+  void setup() {
+    receiver.enableIRIn();
+  }
+
+  /**
+   * @brief Takes the last decoded IR signal
+   *
+   * @param event filled with the code and button, the action is left to the caller
+   * @return true if a signal was decoded, false if no signal was present
+   */
+  bool read(t_sensor_event* event) {
+    if(!receiver.decode(&results)) {
+      return false;
+    }
+
+    // The decoded value is taken as is, no detour via a hex String
+    uint32_t code = (uint32_t) results.value;
+    const t_ir_code* button = lookupIRCode(code);
+    TRACE_INSTANT(TRACE_IR_DECODE, code, results.command);
+
+    event->type = SENSOR_IR;
+    event->timestamp = millis();
+    event->ir.code = code;
+    event->ir.command = results.command;
+    event->ir.button = button ? button->button : IR_BUTTON_NONE;
+    event->ir.action = SENSOR_NO_ACTION;
+
+    receiver.resume();
+    return true;
+  }
+
+  /**
+   * @brief Prints the raw signal last read, for debugging
+   */
+  void printLast(Print& out) {
+    out.print(resultToHumanReadableBasic(&results));
+    out.println(resultToSourceCode(&results));
+  }
+
+private:
+  IRrecv receiver;
+  decode_results results;
+};
+
+template <>
+class IrSensor<false> {
+public:
+  static const bool ENABLED = false;
+
+  explicit IrSensor(uint16_t) {}
+  void setup() {}
+  bool read(t_sensor_event*) { return false; }
+  void printLast(Print&) {}
+};
+
+/**
+ * @brief Sound sensor on an ADC1 channel, sampled continuously through I2S/DMA
+ *
+ * @tparam Enabled S_SOUND_ENABLED
+ * @tparam BlockSize samples per DMA buffer
+ */
+template <bool Enabled, size_t BlockSize>
+class SoundSensor;
+
+template <size_t BlockSize>
+class SoundSensor<true, BlockSize> {
+public:
+  static const bool ENABLED = true;
+
+  /**
+   * @param channel ADC channel of the sound sensor pin
+   * @param sampleRate samples per second
+   * @param featureInterval the features are taken this often (ms)
+   * @param attack envelope follower coefficient per sample while the level rises
+   * @param release envelope follower coefficient per sample while the level falls
+   * @param detector acoustic event detection on the peak level of each block
+   */
+  SoundSensor(adc1_channel_t channel, uint32_t sampleRate, uint32_t featureInterval,
+              float attack, float release, const t_sound_detector_config* detector)
+    : channel(channel), sampleRate(sampleRate), featureInterval(featureInterval),
+      attack(attack), release(release), detectorConfig(detector), featuresStarted(0) {}
+
+  /**
+   * @brief Starts continuous sampling. The I2S peripheral clocks the ADC at
+   *        the sample rate and the DMA fills two buffers in turns, so the
+   *        sample rate doesn't depend on the loop timing.
+   */
+  void setup() {
+    i2s_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.mode = (i2s_mode_t) (I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN);
+    config.sample_rate = sampleRate;
+    config.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+    config.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT;
+    config.communication_format = I2S_COMM_FORMAT_I2S_MSB;
+    config.dma_buf_count = 2;
+    config.dma_buf_len = BlockSize;
+
+    i2s_driver_install(I2S_NUM_0, &config, 0, NULL);
+    i2s_set_adc_mode(ADC_UNIT_1, channel);
+    i2s_adc_enable(I2S_NUM_0);
+
+    initSoundAnalyzer(&analyzer, attack, release);
+    initSoundDetector(&detector, detectorConfig);
+    featuresStarted = millis();
+  }
+
+  /**
+   * @brief Analyzes the samples the DMA collected so far and looks for
+   *        acoustic events like claps in them
+   *
+   * @param event filled with the detected acoustic event
+   * @return true if an acoustic event ended, false otherwise
+   */
+  bool read(t_sensor_event* event) {
+    // Doesn't wait, takes whatever the DMA has filled up to one block
+    size_t bytesRead = 0;
+    i2s_read(I2S_NUM_0, block, sizeof(block), &bytesRead, 0);
+
+    size_t count = bytesRead / sizeof(block[0]);
+    if(!count) {
+      return false;
+    }
+    for(size_t i = 0; i < count; i++) {
+      // The upper 4 bits of each sample carry the ADC channel
+      block[i] &= 0x0FFF;
+    }
+    uint16_t level = analyzeSoundBlock(&analyzer, block, count);
+    TRACE_INSTANT(TRACE_SOUND_BLOCK, count, level);
+
+    event->type = SENSOR_ACOUSTIC;
+    event->timestamp = millis();
+    return detectSoundEvent(&detector, level, event->timestamp, &event->acoustic);
+  }
+
+  /**
+   * @brief Once per feature interval the features of the signal analyzed by
+   *        read() are taken
+   *
+   * @param event filled with the features of the sound signal
+   * @return true if an interval is complete, false otherwise
+   */
+  bool readFeatures(t_sensor_event* event) {
+    if(millis() - featuresStarted < featureInterval) {
+      return false;
+    }
+    featuresStarted = millis();
+
+    event->type = SENSOR_SOUND;
+    event->timestamp = featuresStarted;
+    return takeSoundFeatures(&analyzer, &event->sound);
+  }
+
+private:
+  adc1_channel_t channel;
+  uint32_t sampleRate;
+  uint32_t featureInterval;
+  float attack;
+  float release;
+  const t_sound_detector_config* detectorConfig;
+  // Samples taken from the DMA and their running features
+  uint16_t block[BlockSize];
+  t_sound_analyzer analyzer;
+  t_sound_detector detector;
+  unsigned long featuresStarted;
+};
+
+template <size_t BlockSize>
+class SoundSensor<false, BlockSize> {
+public:
+  static const bool ENABLED = false;
+
+  SoundSensor(adc1_channel_t, uint32_t, uint32_t, float, float, const t_sound_detector_config*) {}
+  void setup() {}
+  bool read(t_sensor_event*) { return false; }
+  bool readFeatures(t_sensor_event*) { return false; }
+};
+
+#endif
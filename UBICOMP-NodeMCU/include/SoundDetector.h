@@ -0,0 +1,50 @@
+#ifndef SOUND_DETECTOR_H
+#define SOUND_DETECTOR_H
+
+#include <stdint.h>
+#include <SensorEvent.h>
+
+// Tuning of the acoustic event detection
+typedef struct s_sound_detector_config {
+  float floorAdapt;          // how quickly the noise floor follows quiet levels, per update
+  float onFactor;            // an event starts above floor * onFactor + minLevel...
+  float offFactor;           // ...and ends below floor * offFactor + minLevel (hysteresis)
+  uint16_t minLevel;         // margin so that a silent room doesn't trigger on hiss
+  uint32_t refractory;       // ms after an event in which no new one may start
+  uint32_t clapMaxDuration;  // ms, shorter events are claps, longer ones loud noise
+  uint32_t maxDuration;      // ms, longer events end and become the new noise floor
+} t_sound_detector_config;
+
+// Running state of the acoustic event detection
+typedef struct s_sound_detector {
+  t_sound_detector_config config;
+  float noiseFloor;
+  bool floorValid;
+  bool active;         // an event is in progress
+  uint32_t onset;
+  uint16_t peak;
+  bool hasEvent;       // whether lastEventEnd is valid
+  uint32_t lastEventEnd;
+} t_sound_detector;
+
+/**
+ * @brief Resets the detector
+ *
+ * @param detector detector to reset
+ * @param config tuning to use
+ */
+void initSoundDetector(t_sound_detector* detector, const t_sound_detector_config* config);
+
+/**
+ * @brief Feeds the current signal level into the detector. Events are reported
+ *        once they ended, so their duration and peak are known.
+ *
+ * @param detector detector to update
+ * @param level signal level, e.g. the peak of a block of samples around the DC offset
+ * @param timestamp ms of the level
+ * @param event filled with the detected event
+ * @return true if an event ended with this level
+ */
+bool detectSoundEvent(t_sound_detector* detector, uint16_t level, uint32_t timestamp, t_acoustic_data* event);
+
+#endif
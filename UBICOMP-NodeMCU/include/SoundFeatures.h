@@ -0,0 +1,50 @@
+#ifndef SOUND_FEATURES_H
+#define SOUND_FEATURES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <SensorEvent.h>
+
+// Running state of the sound feature extraction. Blocks of samples are fed in
+// as they arrive from the DMA, the features are taken once per publish interval
+typedef struct s_sound_analyzer {
+  float dc;          // running mean of the signal, removed before measuring
+  bool dcValid;      // whether dc was seeded with a first sample yet
+  float envelope;    // attack/release follower of the rectified signal
+  float attack;      // follower coefficients in (0, 1], higher reacts faster
+  float release;
+  float sumSquares;  // accumulated since the features were last taken
+  uint32_t count;
+  uint16_t peak;
+} t_sound_analyzer;
+
+/**
+ * @brief Resets the analyzer
+ *
+ * @param analyzer analyzer to reset
+ * @param attack envelope coefficient while the level rises
+ * @param release envelope coefficient while the level falls
+ */
+void initSoundAnalyzer(t_sound_analyzer* analyzer, float attack, float release);
+
+/**
+ * @brief Feeds a block of raw ADC samples into the analyzer
+ *
+ * @param analyzer analyzer to update
+ * @param samples raw samples, unsigned and without channel bits
+ * @param count number of samples
+ * @return uint16_t peak level within this block
+ */
+uint16_t analyzeSoundBlock(t_sound_analyzer* analyzer, const uint16_t* samples, size_t count);
+
+/**
+ * @brief Takes RMS and peak of everything analyzed since the last call together
+ *        with the current envelope, then starts a new interval
+ *
+ * @param analyzer analyzer to read
+ * @param features filled with the features, in ADC counts around the DC offset
+ * @return false if no sample was analyzed since the last call
+ */
+bool takeSoundFeatures(t_sound_analyzer* analyzer, t_sound_data* features);
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stddef.h>
+#include <atomic>
+
+/**
+ * @brief Bounded lock-free ring buffer for exactly one producer and one consumer.
+ *        push() may only be called from one task and pop() from one task, then
+ *        no lock is needed - the indices are only ever written by their owner.
+ *
+ * @tparam T element type, copied in and out by value
+ * @tparam N capacity, has to be a power of two
+ */
+template <typename T, size_t N>
+class SpscQueue {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue capacity has to be a power of two");
+
+public:
+  SpscQueue() : head(0), tail(0) {}
+
+  /**
+   * @brief Append an element. Producer side only.
+   *
+   * @return false if the queue is full, the element is dropped then
+   */
+  bool push(const T& item) {
+    size_t h = head.load(std::memory_order_relaxed);
+    if(h - tail.load(std::memory_order_acquire) == N) {
+      return false;
+    }
+    buffer[h & (N - 1)] = item;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Take the oldest element. Consumer side only.
+   *
+   * @return false if the queue is empty
+   */
+  bool pop(T& item) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if(t == head.load(std::memory_order_acquire)) {
+      return false;
+    }
+    item = buffer[t & (N - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t size() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  static size_t capacity() {
+    return N;
+  }
+
+private:
+  T buffer[N];
+  // Free running counters, only written by the producer (head) or consumer (tail)
+  std::atomic<size_t> head;
+  std::atomic<size_t> tail;
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <TraceRecord.h>
+
+// Records kept in RAM, a power of two. Older records are overwritten
+#ifndef TRACE_BUFFER_RECORDS
+#define TRACE_BUFFER_RECORDS 512
+#endif
+
+// Instrumentation points. Built with -D TRACING they append a record to the
+// ring buffer, otherwise they compile to nothing - the arguments only appear
+// in sizeof, which doesn't evaluate them but keeps them 'used'
+#ifdef TRACING
+#define TRACE_BEGIN(event, arg0, arg1) traceEvent((event), TRACE_PHASE_BEGIN, (arg0), (arg1))
+#define TRACE_END(event, arg0, arg1) traceEvent((event), TRACE_PHASE_END, (arg0), (arg1))
+#define TRACE_INSTANT(event, arg0, arg1) traceEvent((event), TRACE_PHASE_INSTANT, (arg0), (arg1))
+#else
+#define TRACE_UNUSED(event, arg0, arg1) do { (void) sizeof(event); (void) sizeof(arg0); (void) sizeof(arg1); } while(0)
+#define TRACE_BEGIN(event, arg0, arg1) TRACE_UNUSED(event, arg0, arg1)
+#define TRACE_END(event, arg0, arg1) TRACE_UNUSED(event, arg0, arg1)
+#define TRACE_INSTANT(event, arg0, arg1) TRACE_UNUSED(event, arg0, arg1)
+#endif
+
+/**
+ * @brief Appends a record, may be called from any task. Nothing is recorded
+ *        while the trace is paused for a dump
+ */
+void traceEvent(uint16_t event, uint8_t phase, uint32_t arg0, uint32_t arg1);
+
+/**
+ * @brief Stops recording so the buffer can be read consistently. Waits for
+ *        records that are still being written, so it's only called from a
+ *        task
+ *
+ * @param first filled with the index of the oldest record still buffered
+ * @return uint32_t index behind the newest record
+ */
+uint32_t pauseTrace(uint32_t* first);
+
+/**
+ * @brief Buffered record by index, between the ones returned by pauseTrace()
+ */
+const t_trace_record* traceRecordAt(uint32_t index);
+
+/**
+ * @brief Continues recording after a dump
+ *
+ * @param clear whether the dumped records are dropped
+ */
+void resumeTrace(bool clear);
+
+#endif
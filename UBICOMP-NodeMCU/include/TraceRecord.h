@@ -0,0 +1,45 @@
+#ifndef TRACE_RECORD_H
+#define TRACE_RECORD_H
+
+#include <stdint.h>
+
+// Binary layout of the trace, shared by the firmware and the host decoder
+// (tools/trace2chrome.cpp). Records are dumped as is, little endian
+
+// Instrumentation points
+enum TraceEvent : uint16_t {
+  TRACE_LOOP = 0,         // loop()
+  TRACE_NFC_READ = 1,     // readNFC(), arg1: tag read
+  TRACE_IR_DECODE = 2,    // IR signal decoded, arg0: code, arg1: command
+  TRACE_SOUND_BLOCK = 3,  // readSound(), arg0: samples, arg1: acoustic event
+  TRACE_PUBLISH = 4,      // MQTT publish, arg0: length, arg1: packet id
+  TRACE_COMMAND = 5,      // command executed, arg0: command
+  TRACE_LCD = 6,          // LCD update over I2C, arg0: state
+  TRACE_PN532_WRITE = 7,  // PN532_I2C::writeCommand(), arg0: command, arg1: result
+  TRACE_PN532_READ = 8,   // PN532_I2C::readResponse(), arg0: command, arg1: result
+  TRACE_EVENT_COUNT
+};
+
+// Names as shown in the trace viewer
+static const char* const TRACE_EVENT_NAMES[TRACE_EVENT_COUNT] = {
+  "loop", "nfc read", "ir decode", "sound block", "publish", "command", "lcd", "pn532 write", "pn532 read"
+};
+
+enum TracePhase : uint8_t {
+  TRACE_PHASE_INSTANT = 0,
+  TRACE_PHASE_BEGIN = 1,
+  TRACE_PHASE_END = 2
+};
+
+typedef struct s_trace_record {
+  uint32_t timestamp;  // us since boot, wraps after ~71 minutes
+  uint16_t event;      // TraceEvent
+  uint8_t phase;       // TracePhase
+  uint8_t core;        // core the record was written on
+  uint32_t arg0;
+  uint32_t arg1;
+} t_trace_record;
+
+static_assert(sizeof(t_trace_record) == 16, "Trace records have to stay 16 bytes");
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * @brief Hands the latest value from exactly one producer to one consumer,
+ *        lock free and without copying. The producer fills back() and
+ *        publishes it, the consumer takes the latest published value into
+ *        front(). Values the consumer didn't take in time are replaced, unlike
+ *        with an SpscQueue nothing newer is ever dropped.
+ *
+ * @tparam T value type, filled in place
+ */
+template <typename T>
+class TripleBuffer {
+public:
+  TripleBuffer() : writing(0), shared(1), reading(2) {}
+
+  /**
+   * @brief The buffer to fill. Producer side only.
+   */
+  T& back() {
+    return buffers[writing];
+  }
+
+  /**
+   * @brief Makes the filled back() the latest value. Producer side only.
+   */
+  void publish() {
+    writing = shared.exchange(writing | FRESH, std::memory_order_acq_rel) & INDEX;
+  }
+
+  /**
+   * @brief Takes the latest published value into front(). Consumer side only.
+   *
+   * @return false if nothing was published since the last call
+   */
+  bool take() {
+    if(!(shared.load(std::memory_order_relaxed) & FRESH)) {
+      return false;
+    }
+    reading = shared.exchange(reading, std::memory_order_acq_rel) & INDEX;
+    return true;
+  }
+
+  /**
+   * @brief The value taken last. Consumer side only.
+   */
+  const T& front() const {
+    return buffers[reading];
+  }
+
+private:
+  // The shared index carries whether it was published since it was taken
+  static const uint8_t INDEX = 0x03;
+  static const uint8_t FRESH = 0x04;
+
+  T buffers[3];
+  // Only written by the producer (writing) or the consumer (reading)
+  uint8_t writing;
+  std::atomic<uint8_t> shared;
+  uint8_t reading;
+};
+
+#endif
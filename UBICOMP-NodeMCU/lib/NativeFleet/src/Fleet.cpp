@@ -0,0 +1,431 @@
+// Load test of many nodes against a real broker, e.g. a local mosquitto
+//
+// Usage:  program fleet <nodes> [seconds] [script]
+//         starts node-1 .. node-<nodes>, each a process of this program with
+//         the firmware in real time, runs the script for seconds (60 by
+//         default) and reports the latency from each command to the state the
+//         node published for it. FLEET_LOGS=<directory> keeps the output of
+//         every node in <node>.log there
+//
+// The node of index i (from 0) is node-<i + 1> in group room-<i / 10 + 1>
+// and bit i of broadcasts. Every script line names its target, a node or *
+// for all of them:
+//   <ms> set <node>|* <command>      {"node":...,"command":...} on node/<node>/set
+//   <ms> group <group> <command>     {"command":...} on group/<group>/set
+//   <ms> broadcast <command>         {"nodes":<all>,"command":...} on broadcast/set,
+//                                    a number up to 32 nodes, hex digits beyond
+//   <ms> mqtt <topic> [payload]      any message
+//   <ms> ir|nfc|sound|wifi|broker <node>|* <argument>
+//                                    input of the node, as in NativeMain.cpp
+// e.g. "1000+100x600 set * 2" toggles every node ten times a second for a minute
+
+#include <Fleet.h>
+#include <MqttSession.h>
+#include <Script.h>
+#include <Credentials.h>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern char** environ;
+
+// Nodes per group
+#define FLEET_GROUP_SIZE 10
+// Within BROADCAST_MAX_NODES, so every node can be addressed by broadcasts
+#define FLEET_MAX_NODES 1000
+// Time the nodes get to start and connect before the script starts (ms)
+#define FLEET_STARTUP 2000
+#define FLEET_STARTUP_PER_NODE 20
+// Time the states of the last commands get after the script ended (ms)
+#define FLEET_GRACE 2000
+
+namespace {
+
+struct FleetNode {
+  std::string id;
+  std::string group;
+  uint16_t index;
+  pid_t pid;
+  bool online;
+  // Host time (us) of the commands without a state yet, oldest first
+  std::deque<uint64_t> pending;
+  std::vector<uint32_t> latencies;
+  uint32_t commands;
+  // States without a command, e.g. switched by IR or NFC
+  uint32_t unsolicited;
+};
+
+// A command of the script, at a time (us) after the epoch
+struct FleetCommand {
+  uint64_t at;
+  std::string kind;
+  std::string arguments;
+};
+
+std::vector<FleetNode> nodes;
+std::map<std::string, size_t> nodeIndex;
+// Guards nodes, states arrive on the session's reader thread
+std::mutex nodesMutex;
+uint64_t epoch = 0;
+
+bool isNodeInput(const std::string& kind) {
+  return kind == "ir" || kind == "nfc" || kind == "sound" || kind == "wifi" || kind == "broker";
+}
+
+bool parseCommand(const std::string& text, int* command) {
+  char* end;
+  *command = strtol(text.c_str(), &end, 10);
+  return !text.empty() && !*end && *command >= 0 && *command <= 2;
+}
+
+// Whether a line of the script is valid, commands are added to the schedule
+bool addLine(const t_script_line& line, std::vector<FleetCommand>& commands) {
+  const char* arguments = line.arguments;
+  std::string target = nextWord(arguments);
+  int command;
+  if(isNodeInput(line.kind)) {
+    return !target.empty() && (target == "*" || nodeIndex.count(target));
+  }
+  if(!strcmp(line.kind, "set")) {
+    if(target != "*" && !nodeIndex.count(target)) {
+      return false;
+    }
+    if(!parseCommand(nextWord(arguments), &command)) {
+      return false;
+    }
+  } else if(!strcmp(line.kind, "group")) {
+    if(target.empty() || !parseCommand(nextWord(arguments), &command)) {
+      return false;
+    }
+  } else if(!strcmp(line.kind, "broadcast")) {
+    if(!parseCommand(target, &command)) {
+      return false;
+    }
+  } else if(strcmp(line.kind, "mqtt") || target.empty()) {
+    return false;
+  }
+  for(uint32_t i = 0; i < line.count; i++) {
+    commands.push_back({ (line.at + i * line.interval) * 1000, line.kind, line.arguments });
+  }
+  return true;
+}
+
+void sleepUntil(uint64_t time) {
+  uint64_t now = fleetClock();
+  if(time > now) {
+    std::this_thread::sleep_for(std::chrono::microseconds(time - now));
+  }
+}
+
+// Sends a command to some nodes, its latency is taken for each of them
+void sendCommand(MqttSession& session, const std::string& topic, const std::string& payload,
+                 const std::vector<size_t>& addressed) {
+  {
+    std::lock_guard<std::mutex> lock(nodesMutex);
+    uint64_t now = fleetClock();
+    for(size_t node : addressed) {
+      nodes[node].pending.push_back(now);
+      nodes[node].commands++;
+    }
+  }
+  // QoS 0 like the coordinator
+  session.publish(topic.c_str(), (const uint8_t*) payload.data(), payload.size(), 0, false);
+}
+
+void execute(MqttSession& session, const FleetCommand& command) {
+  const char* arguments = command.arguments.c_str();
+  std::string target = nextWord(arguments);
+  std::vector<size_t> addressed;
+  char payload[64];
+
+  if(command.kind == "set") {
+    std::string value = nextWord(arguments);
+    for(size_t i = 0; i < nodes.size(); i++) {
+      if(target == "*" || nodes[i].id == target) {
+        snprintf(payload, sizeof(payload), "{\"node\":\"%s\",\"command\":%s}", nodes[i].id.c_str(), value.c_str());
+        sendCommand(session, "node/" + nodes[i].id + "/set", payload, { i });
+      }
+    }
+  } else if(command.kind == "group") {
+    for(size_t i = 0; i < nodes.size(); i++) {
+      if(nodes[i].group == target) {
+        addressed.push_back(i);
+      }
+    }
+    snprintf(payload, sizeof(payload), "{\"command\":%s}", nextWord(arguments).c_str());
+    sendCommand(session, "group/" + target + "/set", payload, addressed);
+  } else if(command.kind == "broadcast") {
+    // Digits of the bitset, the first four nodes in the last one
+    std::vector<uint8_t> digits(nodes.size() / 4 + 1, 0);
+    for(size_t i = 0; i < nodes.size(); i++) {
+      digits[nodes[i].index / 4] |= 1 << (nodes[i].index % 4);
+      addressed.push_back(i);
+    }
+    std::string mask;
+    for(size_t i = digits.size(); i-- > 0;) {
+      mask += "0123456789abcdef"[digits[i]];
+    }
+    if(nodes.size() <= 32) {
+      mask = std::to_string(strtoul(mask.c_str(), NULL, 16));
+    } else {
+      mask = "\"" + mask + "\"";
+    }
+    sendCommand(session, "broadcast/set", "{\"nodes\":" + mask + ",\"command\":" + target + "}", addressed);
+  } else if(command.kind == "mqtt") {
+    session.publish(target.c_str(), (const uint8_t*) arguments, strlen(arguments), 0, false);
+  }
+}
+
+// node/<id>/<leaf> of a known node, its index or -1
+int nodeOf(const char* topic, const char* leaf) {
+  const char* prefix = "node/";
+  if(strncmp(topic, prefix, strlen(prefix))) {
+    return -1;
+  }
+  const char* id = topic + strlen(prefix);
+  const char* end = strchr(id, '/');
+  if(!end || strcmp(end + 1, leaf)) {
+    return -1;
+  }
+  std::map<std::string, size_t>::iterator node = nodeIndex.find(std::string(id, end - id));
+  return node == nodeIndex.end() ? -1 : (int) node->second;
+}
+
+void onMessage(const char* topic, bool retain) {
+  // Retained messages are from before this run
+  if(retain) {
+    return;
+  }
+  uint64_t now = fleetClock();
+  std::lock_guard<std::mutex> lock(nodesMutex);
+  int node = nodeOf(topic, "boot");
+  if(node >= 0) {
+    nodes[node].online = true;
+    return;
+  }
+  node = nodeOf(topic, "state");
+  // The state published after connecting isn't caused by a command
+  if(node < 0 || now < epoch) {
+    return;
+  }
+  FleetNode& state = nodes[node];
+  if(state.pending.empty()) {
+    state.unsolicited++;
+    return;
+  }
+  state.latencies.push_back(now - state.pending.front());
+  state.pending.pop_front();
+}
+
+bool spawnNode(const char* program, FleetNode& node, const std::vector<std::string>& arguments, const char* logs) {
+  std::vector<std::string> environment;
+  for(char** variable = environ; *variable; variable++) {
+    if(strncmp(*variable, "NODE_", 5)) {
+      environment.push_back(*variable);
+    }
+  }
+  environment.push_back("NODE_ID=" + node.id);
+  environment.push_back("NODE_INDEX=" + std::to_string(node.index));
+  environment.push_back("NODE_GROUP=" + node.group);
+
+  std::vector<char*> argv;
+  for(const std::string& argument : arguments) {
+    argv.push_back((char*) argument.c_str());
+  }
+  argv.push_back(NULL);
+  std::vector<char*> envp;
+  for(const std::string& variable : environment) {
+    envp.push_back((char*) variable.c_str());
+  }
+  envp.push_back(NULL);
+
+  std::string log = logs ? std::string(logs) + "/" + node.id + ".log" : "/dev/null";
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+  // The program may have been started by a relative path or from PATH
+  int error = posix_spawn(&node.pid, "/proc/self/exe", &actions, NULL, argv.data(), envp.data());
+  posix_spawn_file_actions_destroy(&actions);
+  if(error) {
+    fprintf(stderr, "%s: %s\n", program, strerror(error));
+    return false;
+  }
+  return true;
+}
+
+void stopNodes() {
+  for(FleetNode& node : nodes) {
+    if(node.pid > 0) {
+      kill(node.pid, SIGTERM);
+    }
+  }
+  for(FleetNode& node : nodes) {
+    if(node.pid > 0) {
+      waitpid(node.pid, NULL, 0);
+      node.pid = 0;
+    }
+  }
+}
+
+// Nodes that ended early, e.g. on an invalid script line
+bool nodesAlive() {
+  bool alive = true;
+  for(FleetNode& node : nodes) {
+    int status;
+    if(node.pid > 0 && waitpid(node.pid, &status, WNOHANG) == node.pid) {
+      fprintf(stderr, "%s ended early with status %d\n", node.id.c_str(), WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+      node.pid = 0;
+      alive = false;
+    }
+  }
+  return alive;
+}
+
+double percentile(const std::vector<uint32_t>& sorted, unsigned int percent) {
+  if(sorted.empty()) {
+    return 0;
+  }
+  return sorted[std::min(sorted.size() - 1, sorted.size() * percent / 100)] / 1000.0;
+}
+
+void report() {
+  std::lock_guard<std::mutex> lock(nodesMutex);
+  std::vector<uint32_t> all;
+  uint32_t online = 0;
+  uint32_t commands = 0;
+  uint32_t lost = 0;
+  uint32_t unsolicited = 0;
+
+  printf("%-12s %8s %8s %6s %8s %8s %8s %8s\n", "node", "commands", "states", "lost", "min", "p50", "p99", "max");
+  for(FleetNode& node : nodes) {
+    std::sort(node.latencies.begin(), node.latencies.end());
+    all.insert(all.end(), node.latencies.begin(), node.latencies.end());
+    online += node.online;
+    commands += node.commands;
+    lost += node.pending.size();
+    unsolicited += node.unsolicited;
+    printf("%-12s %8u %8zu %6zu %8.2f %8.2f %8.2f %8.2f%s\n", node.id.c_str(), node.commands, node.latencies.size(),
+           node.pending.size(), percentile(node.latencies, 0), percentile(node.latencies, 50),
+           percentile(node.latencies, 99), percentile(node.latencies, 100), node.online ? "" : "  offline");
+  }
+
+  std::sort(all.begin(), all.end());
+  printf("\n%zu nodes, %u online, %u commands, %zu states, %u lost, %u unsolicited\n", nodes.size(), online,
+         commands, all.size(), lost, unsolicited);
+  printf("command -> state (ms): min %.2f p50 %.2f p90 %.2f p99 %.2f max %.2f\n", percentile(all, 0),
+         percentile(all, 50), percentile(all, 90), percentile(all, 99), percentile(all, 100));
+}
+
+int usage() {
+  fprintf(stderr, "usage: program fleet <nodes> [seconds] [script]\n");
+  return 2;
+}
+
+}  // namespace
+
+bool isFleetCommand(const char* kind) {
+  return !strcmp(kind, "set") || !strcmp(kind, "group") || !strcmp(kind, "broadcast") || !strcmp(kind, "mqtt");
+}
+
+uint64_t fleetClock() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+int runFleet(const char* program, int argc, char** argv) {
+  if(argc < 1) {
+    return usage();
+  }
+  unsigned long count = strtoul(argv[0], NULL, 10);
+  uint64_t seconds = argc > 1 ? strtoull(argv[1], NULL, 10) : 60;
+  const char* script = argc > 2 ? argv[2] : NULL;
+  if(count < 1 || count > FLEET_MAX_NODES) {
+    return usage();
+  }
+
+  for(size_t i = 0; i < count; i++) {
+    FleetNode node;
+    node.id = "node-" + std::to_string(i + 1);
+    node.group = "room-" + std::to_string(i / FLEET_GROUP_SIZE + 1);
+    node.index = i;
+    node.pid = 0;
+    node.online = false;
+    node.commands = 0;
+    node.unsolicited = 0;
+    nodeIndex[node.id] = i;
+    nodes.push_back(node);
+  }
+  std::vector<FleetCommand> commands;
+  if(script && !readScript(script, [&commands](const t_script_line& line) { return addLine(line, commands); })) {
+    return 2;
+  }
+  std::stable_sort(commands.begin(), commands.end(),
+                   [](const FleetCommand& a, const FleetCommand& b) { return a.at < b.at; });
+
+  MqttSession::Handlers handlers;
+  handlers.message = [](const char* topic, const uint8_t*, size_t, uint8_t, bool retain) { onMessage(topic, retain); };
+  MqttSession session(handlers);
+  std::string clientId = "fleet-" + std::to_string(getpid());
+  if(!session.open(MQTT_HOST, MQTT_PORT, clientId.c_str(), 60)) {
+    fprintf(stderr, "No MQTT broker at %s:%d, e.g. start mosquitto\n", MQTT_HOST, MQTT_PORT);
+    return 1;
+  }
+  session.subscribe("node/+/state", 0);
+  session.subscribe("node/+/boot", 0);
+
+  epoch = fleetClock() + (FLEET_STARTUP + count * FLEET_STARTUP_PER_NODE) * 1000ULL;
+  const char* logs = getenv("FLEET_LOGS");
+  for(FleetNode& node : nodes) {
+    std::vector<std::string> arguments = { program, "node", std::to_string(seconds), std::to_string(epoch) };
+    if(script) {
+      arguments.push_back(script);
+    }
+    if(!spawnNode(program, node, arguments, logs)) {
+      stopNodes();
+      return 1;
+    }
+  }
+
+  sleepUntil(epoch);
+  if(!nodesAlive()) {
+    stopNodes();
+    return 1;
+  }
+  {
+    std::lock_guard<std::mutex> lock(nodesMutex);
+    size_t online = std::count_if(nodes.begin(), nodes.end(), [](const FleetNode& node) { return node.online; });
+    printf("%zu of %zu nodes online, running %llu s\n", online, nodes.size(), (unsigned long long) seconds);
+    fflush(stdout);
+  }
+
+  for(const FleetCommand& command : commands) {
+    if(command.at >= seconds * 1000000) {
+      break;
+    }
+    sleepUntil(epoch + command.at);
+    execute(session, command);
+  }
+  sleepUntil(epoch + seconds * 1000000 + FLEET_GRACE * 1000ULL);
+
+  session.close();
+  stopNodes();
+  report();
+  return 0;
+}
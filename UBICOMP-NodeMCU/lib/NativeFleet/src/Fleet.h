@@ -0,0 +1,22 @@
+#ifndef NATIVE_FLEET_H
+#define NATIVE_FLEET_H
+
+#include <stdint.h>
+
+/**
+ * @brief Runs a fleet of nodes against the broker of Credentials.h and reports
+ *        the latency from each command to the state it caused, see Fleet.cpp
+ *
+ * @param program path the program was started with
+ * @param argc, argv arguments after "fleet": <nodes> [seconds] [script]
+ * @return int exit code
+ */
+int runFleet(const char* program, int argc, char** argv);
+
+// Whether a script event is published by the fleet driver, not given to a node
+bool isFleetCommand(const char* kind);
+
+// Host time (us) shared by all processes of a fleet
+uint64_t fleetClock();
+
+#endif
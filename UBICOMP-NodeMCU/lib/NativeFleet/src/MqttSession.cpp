@@ -0,0 +1,296 @@
+#include <MqttSession.h>
+
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+// Packet types, upper nibble of the fixed header
+#define MQTT_CONNECT 0x10
+#define MQTT_CONNACK 0x20
+#define MQTT_PUBLISH 0x30
+#define MQTT_PUBACK 0x40
+#define MQTT_PUBREC 0x50
+#define MQTT_PUBREL 0x60
+#define MQTT_PUBCOMP 0x70
+#define MQTT_SUBSCRIBE 0x80
+#define MQTT_SUBACK 0x90
+#define MQTT_PINGREQ 0xC0
+#define MQTT_PINGRESP 0xD0
+#define MQTT_DISCONNECT 0xE0
+
+// Time (ms) the broker has to accept a session
+#define MQTT_CONNACK_TIMEOUT 5000
+
+namespace {
+
+void appendLength(std::string& packet, size_t length) {
+  do {
+    uint8_t digit = length % 128;
+    length /= 128;
+    packet += (char) (digit | (length ? 0x80 : 0));
+  } while(length);
+}
+
+void appendShort(std::string& packet, uint16_t value) {
+  packet += (char) (value >> 8);
+  packet += (char) (value & 0xFF);
+}
+
+void appendString(std::string& packet, const char* text, size_t length) {
+  appendShort(packet, length);
+  packet.append(text, length);
+}
+
+std::string packet(uint8_t header, const std::string& body) {
+  std::string packet(1, (char) header);
+  appendLength(packet, body.size());
+  return packet + body;
+}
+
+std::string acknowledgement(uint8_t header, uint16_t packetId) {
+  std::string body;
+  appendShort(body, packetId);
+  return packet(header, body);
+}
+
+// Reads exactly length bytes, false if the connection ended
+bool readFully(int socket, uint8_t* data, size_t length) {
+  while(length) {
+    ssize_t received = recv(socket, data, length, 0);
+    if(received <= 0) {
+      if(received < 0 && errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += received;
+    length -= received;
+  }
+  return true;
+}
+
+// Reads a packet, false if the connection ended or the packet is malformed
+bool readPacket(int socket, uint8_t* header, std::vector<uint8_t>& body) {
+  if(!readFully(socket, header, 1)) {
+    return false;
+  }
+  size_t length = 0;
+  for(int shift = 0;; shift += 7) {
+    uint8_t digit;
+    if(shift > 21 || !readFully(socket, &digit, 1)) {
+      return false;
+    }
+    length |= (size_t) (digit & 0x7F) << shift;
+    if(!(digit & 0x80)) {
+      break;
+    }
+  }
+  body.resize(length);
+  return readFully(socket, body.data(), length);
+}
+
+int connectTo(const char* host, uint16_t port) {
+  addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* addresses;
+  char service[8];
+  snprintf(service, sizeof(service), "%u", port);
+  if(getaddrinfo(host, service, &hints, &addresses)) {
+    return -1;
+  }
+  int connection = -1;
+  for(addrinfo* address = addresses; address && connection < 0; address = address->ai_next) {
+    // Not inherited by the nodes a fleet starts
+    connection = ::socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+    if(connection >= 0 && ::connect(connection, address->ai_addr, address->ai_addrlen)) {
+      ::close(connection);
+      connection = -1;
+    }
+  }
+  freeaddrinfo(addresses);
+  if(connection >= 0) {
+    // Payloads are small, they go out at once like on lwIP
+    int on = 1;
+    setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  }
+  return connection;
+}
+
+}  // namespace
+
+MqttSession::~MqttSession() {
+  close();
+  if(reader.joinable()) {
+    reader.join();
+  }
+}
+
+bool MqttSession::open(const char* host, uint16_t port, const char* clientId, uint16_t keepAliveSeconds) {
+  if(reader.joinable()) {
+    reader.join();
+  }
+  int connection = connectTo(host, port);
+  if(connection < 0) {
+    return false;
+  }
+
+  // Clean session, no will, no credentials
+  std::string body;
+  appendString(body, "MQTT", 4);
+  body += (char) 4;
+  body += (char) 0x02;
+  appendShort(body, keepAliveSeconds);
+  appendString(body, clientId, strlen(clientId));
+  std::string connect = packet(MQTT_CONNECT, body);
+
+  uint8_t header;
+  std::vector<uint8_t> response;
+  pollfd readable = { connection, POLLIN, 0 };
+  if(::send(connection, connect.data(), connect.size(), MSG_NOSIGNAL) != (ssize_t) connect.size() ||
+     poll(&readable, 1, MQTT_CONNACK_TIMEOUT) != 1 || !readPacket(connection, &header, response) ||
+     (header & 0xF0) != MQTT_CONNACK || response.size() != 2 || response[1] != 0) {
+    ::close(connection);
+    return false;
+  }
+
+  keepAlive = keepAliveSeconds;
+  closing = false;
+  socket = connection;
+  reader = std::thread(&MqttSession::read, this);
+  return true;
+}
+
+void MqttSession::close() {
+  int connection = socket;
+  if(connection < 0 || closing.exchange(true)) {
+    return;
+  }
+  std::string disconnect = packet(MQTT_DISCONNECT, "");
+  {
+    std::lock_guard<std::mutex> lock(sendMutex);
+    ::send(connection, disconnect.data(), disconnect.size(), MSG_NOSIGNAL);
+  }
+  // The reader sees the end of the stream and closes the socket
+  shutdown(connection, SHUT_RDWR);
+}
+
+uint16_t MqttSession::subscribe(const char* filter, uint8_t qos) {
+  uint16_t id = nextPacketId();
+  std::string body;
+  appendShort(body, id);
+  appendString(body, filter, strlen(filter));
+  body += (char) qos;
+  return send(packet(MQTT_SUBSCRIBE | 0x02, body)) ? id : 0;
+}
+
+uint16_t MqttSession::publish(const char* topic, const uint8_t* payload, size_t length, uint8_t qos, bool retain) {
+  uint16_t id = qos ? nextPacketId() : 1;
+  std::string body;
+  appendString(body, topic, strlen(topic));
+  if(qos) {
+    appendShort(body, id);
+  }
+  body.append((const char*) payload, length);
+  return send(packet(MQTT_PUBLISH | (qos << 1) | (retain ? 1 : 0), body)) ? id : 0;
+}
+
+bool MqttSession::send(const std::string& packet) {
+  std::lock_guard<std::mutex> lock(sendMutex);
+  int connection = socket;
+  if(connection < 0 || closing) {
+    return false;
+  }
+  return ::send(connection, packet.data(), packet.size(), MSG_NOSIGNAL) == (ssize_t) packet.size();
+}
+
+uint16_t MqttSession::nextPacketId() {
+  std::lock_guard<std::mutex> lock(sendMutex);
+  if(++packetId == 0) {
+    packetId = 1;
+  }
+  return packetId;
+}
+
+void MqttSession::read() {
+  int connection = socket;
+  uint8_t header;
+  std::vector<uint8_t> body;
+  for(;;) {
+    pollfd readable = { connection, POLLIN, 0 };
+    int ready = poll(&readable, 1, keepAlive ? keepAlive * 500 : -1);
+    if(ready < 0 && errno == EINTR) {
+      continue;
+    }
+    if(ready == 0) {
+      // Idle for half the keep alive
+      if(!send(packet(MQTT_PINGREQ, ""))) {
+        break;
+      }
+      continue;
+    }
+    if(ready < 0 || !readPacket(connection, &header, body) || !dispatch(header, body.data(), body.size())) {
+      break;
+    }
+  }
+  socket = -1;
+  ::close(connection);
+  if(handlers.closed) {
+    handlers.closed();
+  }
+}
+
+bool MqttSession::dispatch(uint8_t header, const uint8_t* body, size_t length) {
+  uint16_t id = length >= 2 ? (body[0] << 8) | body[1] : 0;
+  switch(header & 0xF0) {
+    case MQTT_PUBLISH: {
+      uint8_t qos = (header >> 1) & 0x03;
+      if(length < 2) {
+        return false;
+      }
+      size_t topicLength = (body[0] << 8) | body[1];
+      size_t offset = 2 + topicLength + (qos ? 2 : 0);
+      if(offset > length) {
+        return false;
+      }
+      std::string topic((const char*) body + 2, topicLength);
+      uint16_t messageId = qos ? (body[2 + topicLength] << 8) | body[3 + topicLength] : 0;
+      if(handlers.message) {
+        handlers.message(topic.c_str(), body + offset, length - offset, qos, header & 0x01);
+      }
+      if(qos == 1) {
+        return send(acknowledgement(MQTT_PUBACK, messageId));
+      }
+      if(qos == 2) {
+        return send(acknowledgement(MQTT_PUBREC, messageId));
+      }
+      return true;
+    }
+    case MQTT_PUBREL:
+      return send(acknowledgement(MQTT_PUBCOMP, id));
+    case MQTT_PUBREC:
+      return send(acknowledgement(MQTT_PUBREL | 0x02, id));
+    case MQTT_PUBACK:
+    case MQTT_PUBCOMP:
+      if(handlers.published) {
+        handlers.published(id);
+      }
+      return true;
+    case MQTT_SUBACK:
+      if(handlers.subscribed && length >= 3) {
+        handlers.subscribed(id, body[2]);
+      }
+      return true;
+    case MQTT_PINGRESP:
+      return true;
+    default:
+      return false;
+  }
+}
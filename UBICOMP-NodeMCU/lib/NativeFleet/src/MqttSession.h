@@ -0,0 +1,64 @@
+#ifndef NATIVE_MQTT_SESSION_H
+#define NATIVE_MQTT_SESSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief MQTT 3.1.1 client over TCP, just what the node and the fleet driver
+ *        need: QoS 0-2 publish and subscribe, keep alive and no persistence.
+ *        Received packets are handled on a reader thread, the handlers run
+ *        there too
+ */
+class MqttSession {
+public:
+  struct Handlers {
+    std::function<void(const char* topic, const uint8_t* payload, size_t length, uint8_t qos, bool retain)> message;
+    std::function<void(uint16_t packetId, uint8_t qos)> subscribed;
+    // A QoS 1 or 2 publish completed
+    std::function<void(uint16_t packetId)> published;
+    // The connection was lost or closed, not called if open() failed
+    std::function<void()> closed;
+  };
+
+  explicit MqttSession(const Handlers& handlers) : handlers(handlers) {}
+  ~MqttSession();
+
+  /**
+   * @brief Connects and waits for the broker to accept the session. Blocks
+   *
+   * @param keepAlive seconds, a ping is sent after half of it without traffic
+   * @return true if the broker accepted, false if it couldn't be reached or refused
+   */
+  bool open(const char* host, uint16_t port, const char* clientId, uint16_t keepAlive);
+  // Drops the connection, closed() follows on the reader thread
+  void close();
+  bool isOpen() const { return socket >= 0 && !closing; }
+
+  // Packet id of the request, 0 if it couldn't be sent
+  uint16_t subscribe(const char* filter, uint8_t qos);
+  // Packet id of a QoS 1 or 2 publish, 1 for QoS 0, 0 if it couldn't be sent
+  uint16_t publish(const char* topic, const uint8_t* payload, size_t length, uint8_t qos, bool retain);
+
+private:
+  bool send(const std::string& packet);
+  uint16_t nextPacketId();
+  void read();
+  bool dispatch(uint8_t header, const uint8_t* body, size_t length);
+
+  Handlers handlers;
+  std::atomic<int> socket { -1 };
+  std::atomic<bool> closing { false };
+  uint16_t keepAlive = 0;
+  // Guards writes to the socket and the packet ids
+  std::mutex sendMutex;
+  uint16_t packetId = 0;
+  std::thread reader;
+};
+
+#endif
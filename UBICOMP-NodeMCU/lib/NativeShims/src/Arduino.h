@@ -0,0 +1,239 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+/*
+ * Host stand-in for the parts of the Arduino core and ESP32 FreeRTOS the node
+ * firmware and its libraries use. Time is virtual, see Native.h.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <string>
+#include <algorithm>
+
+#define ARDUINO 10800
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HEX 16
+#define DEC 10
+#define INPUT 0
+#define OUTPUT 1
+#define LOW 0
+#define HIGH 1
+
+#define F(s) (s)
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t*) (address))
+#define pgm_read_word(address) (*(const uint16_t*) (address))
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+
+long random(long max);
+long random(long min, long max);
+
+inline size_t strlcpy(char* destination, const char* source, size_t size) {
+  size_t length = strlen(source);
+  if(size) {
+    size_t copied = length < size - 1 ? length : size - 1;
+    memcpy(destination, source, copied);
+    destination[copied] = '\0';
+  }
+  return length;
+}
+
+/**
+ * @brief Arduino String on a std::string, the members the firmware uses
+ */
+class String {
+public:
+  String(const char* text = "") : value(text ? text : "") {}
+  String(const std::string& text) : value(text) {}
+  explicit String(char c) : value(1, c) {}
+  String(int number, unsigned char base = DEC) { formatSigned(number, base); }
+  String(unsigned int number, unsigned char base = DEC) { formatUnsigned(number, base); }
+  String(long number, unsigned char base = DEC) { formatSigned(number, base); }
+  String(unsigned long number, unsigned char base = DEC) { formatUnsigned(number, base); }
+
+  const char* c_str() const { return value.c_str(); }
+  unsigned int length() const { return value.size(); }
+  void reserve(unsigned int size) { value.reserve(size); }
+
+  bool equals(const String& other) const { return value == other.value; }
+  bool operator==(const String& other) const { return value == other.value; }
+  bool operator!=(const String& other) const { return value != other.value; }
+
+  String& operator+=(const String& other) { value += other.value; return *this; }
+  String& operator+=(const char* other) { value += other; return *this; }
+  String& operator+=(char other) { value += other; return *this; }
+  bool concat(const char* other) { value += other; return true; }
+  friend String operator+(const String& a, const String& b) { return String(a.value + b.value); }
+  friend String operator+(const String& a, const char* b) { return String(a.value + b); }
+
+  char charAt(unsigned int index) const { return index < value.size() ? value[index] : '\0'; }
+  char operator[](unsigned int index) const { return charAt(index); }
+  int indexOf(char c) const {
+    size_t position = value.find(c);
+    return position == std::string::npos ? -1 : (int) position;
+  }
+  String substring(unsigned int from) const { return from < value.size() ? String(value.substr(from)) : String(); }
+  String substring(unsigned int from, unsigned int to) const {
+    return from < value.size() && from < to ? String(value.substr(from, to - from)) : String();
+  }
+  void replace(const String& find, const String& replacement) {
+    if(find.value.empty()) {
+      return;
+    }
+    size_t position = 0;
+    while((position = value.find(find.value, position)) != std::string::npos) {
+      value.replace(position, find.value.size(), replacement.value);
+      position += replacement.value.size();
+    }
+  }
+  void toUpperCase() {
+    for(char& c : value) {
+      c = toupper(c);
+    }
+  }
+  long toInt() const { return atol(value.c_str()); }
+  void getBytes(unsigned char* buffer, unsigned int size) const {
+    if(!size) {
+      return;
+    }
+    size_t copied = std::min((size_t) size - 1, value.size());
+    memcpy(buffer, value.data(), copied);
+    buffer[copied] = '\0';
+  }
+
+private:
+  void formatSigned(long number, unsigned char base) {
+    if(number < 0) {
+      formatUnsigned(-(unsigned long) number, base);
+      value.insert(0, 1, '-');
+    } else {
+      formatUnsigned(number, base);
+    }
+  }
+
+  void formatUnsigned(unsigned long number, unsigned char base) {
+    char text[40];
+    snprintf(text, sizeof(text), base == HEX ? "%lx" : "%lu", number);
+    value = text;
+  }
+
+  std::string value;
+};
+
+/**
+ * @brief Arduino Print, subclasses only implement write()
+ */
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size) {
+    size_t written = 0;
+    while(size--) {
+      written += write(*buffer++);
+    }
+    return written;
+  }
+  size_t write(const char* text) { return write((const uint8_t*) text, strlen(text)); }
+
+  size_t print(const String& value) { return write(value.c_str()); }
+  size_t print(const char* value) { return write(value); }
+  size_t print(char value) { return write((uint8_t) value); }
+  size_t print(int value, int base = DEC) { return print((long) value, base); }
+  size_t print(unsigned int value, int base = DEC) { return print((unsigned long) value, base); }
+  size_t print(long value, int base = DEC) { return base == DEC ? printf("%ld", value) : print((unsigned long) value, base); }
+  size_t print(unsigned long value, int base = DEC) { return printf(base == HEX ? "%lX" : "%lu", value); }
+  size_t print(long long value, int = DEC) { return printf("%lld", value); }
+  size_t print(unsigned long long value, int = DEC) { return printf("%llu", value); }
+  size_t print(double value, int digits = 2) { return printf("%.*f", digits, value); }
+
+  size_t println() { return write("\r\n"); }
+  template <typename T>
+  size_t println(T value) { return print(value) + println(); }
+  template <typename T>
+  size_t println(T value, int base) { return print(value, base) + println(); }
+
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+/**
+ * @brief Serial monitor on stdout. Nothing is ever received, the stimuli of
+ *        the host run come from its script (see Native.h)
+ */
+class HardwareSerial : public Print {
+public:
+  void begin(unsigned long) {}
+  operator bool() const { return true; }
+  int available() { return 0; }
+  int read() { return -1; }
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+/**
+ * @brief CPU cycles are host time at 240 MHz, so the latency metrics show
+ *        how long the firmware runs on the host
+ */
+class EspClass {
+public:
+  uint32_t getCycleCount();
+  uint32_t getCpuFreqMHz() { return 240; }
+};
+
+extern EspClass ESP;
+
+int64_t esp_timer_get_time();
+
+// FreeRTOS tasks as host threads, waiting in virtual time
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef struct NativeTask* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define portMAX_DELAY 0xffffffffUL
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t) (ms))
+#define ARDUINO_RUNNING_CORE 1
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stackSize, void* parameter,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount();
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t timeout);
+BaseType_t xPortGetCoreID();
+
+// Identity of the node, from the environment variables NODE_ID, NODE_INDEX
+// and NODE_GROUP - node-1, 0 and room-1 if unset. With NODE_ID set but no
+// NODE_GROUP the node is in no group (NULL). env:native builds with
+// -D NODE_ID=nativeNodeId() etc. so every process of a fleet is another node
+const char* nativeNodeId();
+uint16_t nativeNodeIndex();
+const char* nativeNodeGroup();
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef NATIVE_ASYNC_MQTT_CLIENT_H
+#define NATIVE_ASYNC_MQTT_CLIENT_H
+
+#include <Arduino.h>
+#include <functional>
+
+enum class AsyncMqttClientDisconnectReason : int8_t {
+  TCP_DISCONNECTED = 0
+};
+
+struct AsyncMqttClientMessageProperties {
+  uint8_t qos;
+  bool dup;
+  bool retain;
+};
+
+/**
+ * @brief Client of the simulated broker, see setBrokerAvailable(), or of a
+ *        real one, see setRealBroker(). Every publish is printed as
+ *        "mqtt> <topic> <payload>", binary payloads as hex. Callbacks run on
+ *        the main thread like on the AsyncTCP task
+ */
+class AsyncMqttClient {
+public:
+  typedef std::function<void(bool sessionPresent)> OnConnect;
+  typedef std::function<void(AsyncMqttClientDisconnectReason reason)> OnDisconnect;
+  typedef std::function<void(uint16_t packetId, uint8_t qos)> OnSubscribe;
+  typedef std::function<void(uint16_t packetId)> OnUnsubscribe;
+  typedef std::function<void(char* topic, char* payload, AsyncMqttClientMessageProperties properties,
+                             size_t length, size_t index, size_t total)> OnMessage;
+  typedef std::function<void(uint16_t packetId)> OnPublish;
+
+  AsyncMqttClient();
+
+  AsyncMqttClient& onConnect(OnConnect callback) { connectCallback = callback; return *this; }
+  AsyncMqttClient& onDisconnect(OnDisconnect callback) { disconnectCallback = callback; return *this; }
+  AsyncMqttClient& onSubscribe(OnSubscribe callback) { subscribeCallback = callback; return *this; }
+  AsyncMqttClient& onUnsubscribe(OnUnsubscribe callback) { unsubscribeCallback = callback; return *this; }
+  AsyncMqttClient& onMessage(OnMessage callback) { messageCallback = callback; return *this; }
+  AsyncMqttClient& onPublish(OnPublish callback) { publishCallback = callback; return *this; }
+  // The host isn't copied, like by AsyncMqttClient
+  AsyncMqttClient& setServer(const char* server, uint16_t serverPort) { host = server; port = serverPort; return *this; }
+
+  void connect();
+  void disconnect(bool force = false);
+  bool connected() const;
+  uint16_t subscribe(const char* topic, uint8_t qos);
+  uint16_t unsubscribe(const char* topic);
+  uint16_t publish(const char* topic, uint8_t qos, bool retain, const char* payload = NULL, size_t length = 0,
+                   bool dup = false, uint16_t messageId = 0);
+
+private:
+  friend struct NativeBroker;
+
+  OnConnect connectCallback;
+  OnDisconnect disconnectCallback;
+  OnSubscribe subscribeCallback;
+  OnUnsubscribe unsubscribeCallback;
+  OnMessage messageCallback;
+  OnPublish publishCallback;
+  const char* host = NULL;
+  uint16_t port = 0;
+};
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef NATIVE_CREDENTIALS_H
+#define NATIVE_CREDENTIALS_H
+
+// The simulated network takes any credentials. include/Credentials.h, if
+// present, is found first
+#define WIFI_SSID "native"
+#define WIFI_PASSWORD "native"
+#define MQTT_HOST "127.0.0.1"
+#define MQTT_PORT 1883
+
+#endif
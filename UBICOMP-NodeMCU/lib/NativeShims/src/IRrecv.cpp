@@ -0,0 +1,50 @@
+#include <IRrecv.h>
+#include <IRutils.h>
+#include <Native.h>
+
+#include <deque>
+#include <mutex>
+
+namespace {
+
+// Injected on the main thread, decoded by the sensor task
+std::mutex codesMutex;
+std::deque<uint32_t> codes;
+
+}  // namespace
+
+void injectIrCode(uint32_t code) {
+  std::lock_guard<std::mutex> lock(codesMutex);
+  codes.push_back(code);
+}
+
+bool IRrecv::decode(decode_results* results) {
+  std::lock_guard<std::mutex> lock(codesMutex);
+  if(codes.empty()) {
+    return false;
+  }
+  uint32_t code = codes.front();
+  codes.pop_front();
+  // NEC: address, inverted address, command, inverted command - MSB first
+  results->decode_type = NEC;
+  results->value = code;
+  results->address = (code >> 24) & 0xFF;
+  results->command = (code >> 8) & 0xFF;
+  results->bits = 32;
+  results->repeat = false;
+  return true;
+}
+
+String resultToHexidecimal(const decode_results* results) {
+  char text[24];
+  snprintf(text, sizeof(text), "0x%llX", (unsigned long long) results->value);
+  return String(text);
+}
+
+String resultToHumanReadableBasic(const decode_results* results) {
+  return String("Protocol  : NEC\nCode      : ") + resultToHexidecimal(results) + " (32 Bits)\n";
+}
+
+String resultToSourceCode(const decode_results* results) {
+  return String("uint64_t data = ") + resultToHexidecimal(results) + ";\n";
+}
@@ -0,0 +1,28 @@
+#ifndef NATIVE_IRRECV_H
+#define NATIVE_IRRECV_H
+
+#include <IRremoteESP8266.h>
+
+struct decode_results {
+  decode_type_t decode_type;
+  uint64_t value;
+  uint32_t address;
+  uint32_t command;
+  uint16_t bits;
+  bool repeat;
+};
+
+/**
+ * @brief IR receiver that decodes the codes passed to injectIrCode()
+ *        (Native.h) as NEC
+ */
+class IRrecv {
+public:
+  explicit IRrecv(uint16_t pin, uint16_t bufferSize = 1024, uint8_t timeout = 15, bool saveBuffer = false) {}
+  void enableIRIn() {}
+  void disableIRIn() {}
+  bool decode(decode_results* results);
+  void resume() {}
+};
+
+#endif
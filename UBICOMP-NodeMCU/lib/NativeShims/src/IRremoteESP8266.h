@@ -0,0 +1,11 @@
+#ifndef NATIVE_IRREMOTEESP8266_H
+#define NATIVE_IRREMOTEESP8266_H
+
+#include <Arduino.h>
+
+enum decode_type_t {
+  UNKNOWN = -1,
+  NEC = 3
+};
+
+#endif
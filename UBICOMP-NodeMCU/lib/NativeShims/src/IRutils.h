@@ -0,0 +1,10 @@
+#ifndef NATIVE_IRUTILS_H
+#define NATIVE_IRUTILS_H
+
+#include <IRrecv.h>
+
+String resultToHexidecimal(const decode_results* results);
+String resultToHumanReadableBasic(const decode_results* results);
+String resultToSourceCode(const decode_results* results);
+
+#endif
@@ -0,0 +1,454 @@
+#include <Arduino.h>
+#include <Native.h>
+#include <freertos/semphr.h>
+#include <freertos/timers.h>
+
+#include <stdarg.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct NativeTask {
+  const char* name;
+  UBaseType_t priority;
+  // Order of creation, the last tie-break between tasks due together
+  uint32_t index;
+  uint32_t notifications;
+};
+
+// A thread waiting for a semaphore, NULL task for the main thread
+struct SemaphoreWaiter {
+  NativeTask* task;
+  bool granted;
+};
+
+struct NativeSemaphore {
+  bool taken;
+  std::vector<SemaphoreWaiter*> waiters;
+};
+
+struct NativeTimer {
+  const char* name;
+  TickType_t period;
+  bool autoReload;
+  void* id;
+  TimerCallbackFunction_t callback;
+  // Bumped on every start and stop, a pending expiry of an older one is void
+  uint32_t generation;
+};
+
+namespace {
+
+// Guards the clock and everything tasks wait for
+std::mutex clockMutex;
+std::condition_variable clockChanged;
+std::atomic<uint64_t> now(0);
+
+// A task waiting for virtual time or a notification
+struct Sleeper {
+  NativeTask* task;
+  bool notifiable;
+  bool timed;
+  uint64_t wake;
+  bool released;
+};
+std::vector<Sleeper*> sleepers;
+// Task threads that aren't waiting. Only one is released at a time, like on
+// the single core the tasks share, time only moves on while it's 0
+int running = 0;
+uint32_t taskCount = 0;
+// Work due at a time, ordered by time and then by when it was added
+std::multimap<uint64_t, std::function<void()>> pending;
+// Whether virtual time follows the host's, see setRealTime()
+bool realTime = false;
+std::chrono::steady_clock::time_point started;
+
+// NULL on the main thread
+thread_local NativeTask* currentTask = NULL;
+
+/**
+ * @brief Lets the current task thread wait, until virtual time reaches its
+ *        wake time or it's notified. Called with the clock locked
+ */
+void sleep(std::unique_lock<std::mutex>& lock, Sleeper* sleeper) {
+  sleepers.push_back(sleeper);
+  running--;
+  clockChanged.notify_all();
+  clockChanged.wait(lock, [sleeper] { return sleeper->released; });
+}
+
+// Whoever releases a sleeper counts it as running again, before the main
+// thread could move time on
+void release(size_t index) {
+  sleepers[index]->released = true;
+  sleepers.erase(sleepers.begin() + index);
+  running++;
+}
+
+// Whether a sleeper goes before another one: the earlier wake time, then the
+// higher priority, then the task created first. Hence tasks due together
+// always run in the same order, regardless of the host's thread scheduling
+bool precedes(const Sleeper* sleeper, const Sleeper* other) {
+  if(sleeper->wake != other->wake) {
+    return sleeper->wake < other->wake;
+  }
+  if(sleeper->task->priority != other->task->priority) {
+    return sleeper->task->priority > other->task->priority;
+  }
+  return sleeper->task->index < other->task->index;
+}
+
+bool releaseNextSleeper() {
+  size_t next = sleepers.size();
+  for(size_t i = 0; i < sleepers.size(); i++) {
+    if(sleepers[i]->timed && sleepers[i]->wake <= now && (next == sleepers.size() || precedes(sleepers[i], sleepers[next]))) {
+      next = i;
+    }
+  }
+  if(next == sleepers.size()) {
+    return false;
+  }
+  release(next);
+  clockChanged.notify_all();
+  return true;
+}
+
+void wait(uint64_t us) {
+  if(!currentTask) {
+    advanceTime(us);
+    return;
+  }
+  std::unique_lock<std::mutex> lock(clockMutex);
+  Sleeper sleeper = { currentTask, false, true, now + us, false };
+  sleep(lock, &sleeper);
+}
+
+void scheduleTimer(NativeTimer* timer) {
+  uint32_t generation = ++timer->generation;
+  runAt(now + timer->period * 1000ULL, [timer, generation] {
+    if(timer->generation != generation) {
+      return;
+    }
+    if(timer->autoReload) {
+      scheduleTimer(timer);
+    }
+    timer->callback(timer);
+  });
+}
+
+}  // namespace
+
+/***** Virtual time ******/
+
+uint64_t nativeTime() {
+  return now;
+}
+
+void advanceTime(uint64_t us) {
+  std::unique_lock<std::mutex> lock(clockMutex);
+  uint64_t target = now + us;
+  for(;;) {
+    clockChanged.wait(lock, [] { return running == 0; });
+    if(realTime) {
+      uint64_t host = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count();
+      now = std::max(now.load(), host);
+    }
+    // Work due now runs before time moves on, it may start further work
+    if(!pending.empty() && pending.begin()->first <= now) {
+      std::function<void()> work = pending.begin()->second;
+      pending.erase(pending.begin());
+      lock.unlock();
+      work();
+      lock.lock();
+      continue;
+    }
+    if(releaseNextSleeper()) {
+      continue;
+    }
+    if(now >= target) {
+      break;
+    }
+    uint64_t next = target;
+    if(!pending.empty() && pending.begin()->first < next) {
+      next = pending.begin()->first;
+    }
+    for(const Sleeper* sleeper : sleepers) {
+      if(sleeper->timed && sleeper->wake < next) {
+        next = sleeper->wake;
+      }
+    }
+    if(realTime) {
+      // Work may be added meanwhile by another thread, e.g. a socket reader
+      clockChanged.wait_until(lock, started + std::chrono::microseconds(next));
+    } else {
+      now = next;
+    }
+  }
+}
+
+void runAt(uint64_t at, std::function<void()> work) {
+  std::lock_guard<std::mutex> lock(clockMutex);
+  pending.emplace(at, std::move(work));
+  clockChanged.notify_all();
+}
+
+void setRealTime(bool enabled) {
+  std::lock_guard<std::mutex> lock(clockMutex);
+  realTime = enabled;
+  started = std::chrono::steady_clock::now() - std::chrono::microseconds(now);
+}
+
+unsigned long millis() {
+  return now / 1000;
+}
+
+unsigned long micros() {
+  return now;
+}
+
+int64_t esp_timer_get_time() {
+  return now;
+}
+
+void delay(unsigned long ms) {
+  wait(ms * 1000ULL);
+}
+
+void delayMicroseconds(unsigned int us) {
+  wait(us);
+}
+
+/***** Tasks ******/
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t, void* parameter,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t) {
+  NativeTask* task;
+  {
+    std::lock_guard<std::mutex> lock(clockMutex);
+    task = new NativeTask { name, priority, taskCount++, 0 };
+    running++;
+  }
+  if(handle) {
+    *handle = task;
+  }
+  std::thread([function, parameter, task] {
+    currentTask = task;
+    {
+      // Starts once the creator waits, at the time it was created
+      std::unique_lock<std::mutex> lock(clockMutex);
+      Sleeper start = { task, false, true, now, false };
+      sleep(lock, &start);
+    }
+    function(parameter);
+    // Returning from a task is an error on the device, it just stops here
+    std::lock_guard<std::mutex> lock(clockMutex);
+    running--;
+    clockChanged.notify_all();
+  }).detach();
+  return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  if(task && task != currentTask) {
+    return;
+  }
+  // A thread can't be ended from outside, the task waits for good instead
+  std::unique_lock<std::mutex> lock(clockMutex);
+  Sleeper sleeper = { currentTask, false, false, 0, false };
+  sleep(lock, &sleeper);
+}
+
+void vTaskDelay(TickType_t ticks) {
+  wait(ticks * portTICK_PERIOD_MS * 1000ULL);
+}
+
+TickType_t xTaskGetTickCount() {
+  return millis() / portTICK_PERIOD_MS;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  std::lock_guard<std::mutex> lock(clockMutex);
+  task->notifications++;
+  // The task is due now, it runs once the notifier waits
+  for(Sleeper* sleeper : sleepers) {
+    if(sleeper->task == task && sleeper->notifiable) {
+      sleeper->timed = true;
+      sleeper->wake = now;
+      sleeper->notifiable = false;
+    }
+  }
+  return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t timeout) {
+  std::unique_lock<std::mutex> lock(clockMutex);
+  NativeTask* task = currentTask;
+  if(!task->notifications && timeout) {
+    Sleeper sleeper = { task, true, timeout != portMAX_DELAY, now + timeout * portTICK_PERIOD_MS * 1000ULL, false };
+    sleep(lock, &sleeper);
+  }
+  uint32_t value = task->notifications;
+  if(clear) {
+    task->notifications = 0;
+  } else if(value) {
+    task->notifications--;
+  }
+  return value;
+}
+
+BaseType_t xPortGetCoreID() {
+  return currentTask ? 0 : ARDUINO_RUNNING_CORE;
+}
+
+/***** Semaphores ******/
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  return new NativeSemaphore { false, {} };
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t timeout) {
+  std::unique_lock<std::mutex> lock(clockMutex);
+  if(!semaphore->taken) {
+    semaphore->taken = true;
+    return pdTRUE;
+  }
+  if(timeout != portMAX_DELAY) {
+    // Only waiting for good is used by the firmware
+    return pdFALSE;
+  }
+  // A task waiting here doesn't hold up time, the holder may wait for it
+  SemaphoreWaiter waiter = { currentTask, false };
+  semaphore->waiters.push_back(&waiter);
+  if(currentTask) {
+    running--;
+    clockChanged.notify_all();
+  }
+  clockChanged.wait(lock, [&waiter] { return waiter.granted; });
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+  std::lock_guard<std::mutex> lock(clockMutex);
+  std::vector<SemaphoreWaiter*>& waiters = semaphore->waiters;
+  if(waiters.empty()) {
+    semaphore->taken = false;
+    return pdTRUE;
+  }
+  // Handed over to the waiter of the highest priority (the main thread is
+  // loop() at 1), the first of them. It counts as running right away, so
+  // time doesn't move on before it got the semaphore
+  size_t next = 0;
+  for(size_t i = 1; i < waiters.size(); i++) {
+    UBaseType_t priority = waiters[i]->task ? waiters[i]->task->priority : 1;
+    UBaseType_t nextPriority = waiters[next]->task ? waiters[next]->task->priority : 1;
+    if(priority > nextPriority) {
+      next = i;
+    }
+  }
+  SemaphoreWaiter* waiter = waiters[next];
+  waiters.erase(waiters.begin() + next);
+  waiter->granted = true;
+  if(waiter->task) {
+    running++;
+  }
+  clockChanged.notify_all();
+  return pdTRUE;
+}
+
+/***** Timers ******/
+
+TimerHandle_t xTimerCreate(const char* name, TickType_t period, UBaseType_t autoReload, void* id,
+                           TimerCallbackFunction_t callback) {
+  return new NativeTimer { name, period, autoReload != pdFALSE, id, callback, 0 };
+}
+
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t) {
+  scheduleTimer(timer);
+  return pdPASS;
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t) {
+  timer->generation++;
+  return pdPASS;
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t) {
+  timer->period = period;
+  scheduleTimer(timer);
+  return pdPASS;
+}
+
+void* pvTimerGetTimerID(TimerHandle_t timer) {
+  return timer->id;
+}
+
+/***** Board ******/
+
+HardwareSerial Serial;
+EspClass ESP;
+
+size_t Print::printf(const char* format, ...) {
+  char buffer[256];
+  va_list arguments;
+  va_start(arguments, format);
+  int length = vsnprintf(buffer, sizeof(buffer), format, arguments);
+  va_end(arguments);
+  if(length < 0) {
+    return 0;
+  }
+  return write((const uint8_t*) buffer, std::min((size_t) length, sizeof(buffer) - 1));
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  return fputc(c, stdout) == EOF ? 0 : 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+  return fwrite(buffer, 1, size, stdout);
+}
+
+uint32_t EspClass::getCycleCount() {
+  static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  return (uint32_t) (ns * getCpuFreqMHz() / 1000);
+}
+
+const char* nativeNodeId() {
+  const char* id = getenv("NODE_ID");
+  return id ? id : "node-1";
+}
+
+uint16_t nativeNodeIndex() {
+  const char* index = getenv("NODE_INDEX");
+  return index ? atoi(index) : 0;
+}
+
+const char* nativeNodeGroup() {
+  // Like the firmware, only node-1 defaults to a group
+  const char* group = getenv("NODE_GROUP");
+  return group || getenv("NODE_ID") ? group : "room-1";
+}
+
+void pinMode(uint8_t, uint8_t) {}
+
+void digitalWrite(uint8_t, uint8_t) {}
+
+int digitalRead(uint8_t) {
+  return LOW;
+}
+
+uint16_t analogRead(uint8_t) {
+  return 0;
+}
+
+long random(long max) {
+  return max > 0 ? rand() % max : 0;
+}
+
+long random(long min, long max) {
+  return max > min ? min + rand() % (max - min) : min;
+}
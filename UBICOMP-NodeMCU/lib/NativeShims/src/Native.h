@@ -0,0 +1,119 @@
+#ifndef NATIVE_H
+#define NATIVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+
+/*
+ * Control of the host run of the firmware (env:native).
+ *
+ * Time is virtual. It's only moved on by the thread running setup() and
+ * loop() - through delay(), vTaskDelay() and advanceTime() - and only once
+ * every task is waiting (vTaskDelay(), ulTaskNotifyTake() or a taken
+ * semaphore). Tasks and callbacks then run at the time they're due, one at
+ * a time and tasks due together by priority, so a run of the same script
+ * always gives the same output regardless of the host speed.
+ * Only the CPU cycle counter (ESP.getCycleCount()) is real host time.
+ *
+ * WiFi, MQTT broker, IR and I2C devices are simulated, the run is driven
+ * by a script, see NativeMain.cpp. A fleet of nodes runs in real time against
+ * a real broker instead, see setRealTime(), setRealBroker() and lib/NativeFleet.
+ */
+
+/**
+ * @brief Moves virtual time on, running the tasks, timers and callbacks due
+ *        meanwhile. Only called by the main thread
+ *
+ * @param us microseconds
+ */
+void advanceTime(uint64_t us);
+
+/**
+ * @brief Virtual time since start (us)
+ */
+uint64_t nativeTime();
+
+/**
+ * @brief Runs a function on the main thread once virtual time reaches at, like
+ *        a callback of the WiFi or MQTT stack or a timer on the device
+ *
+ * @param at virtual time (us)
+ */
+void runAt(uint64_t at, std::function<void()> work);
+
+/**
+ * @brief Lets virtual time follow the host's from now on, for runs against
+ *        the outside world. Tasks and callbacks still run one at a time, but
+ *        runs are no longer repeatable. Called before setup()
+ */
+void setRealTime(bool enabled);
+
+/**
+ * @brief Lets the MQTT client connect to the broker passed to setServer()
+ *        over TCP, e.g. a local mosquitto, instead of the simulated one.
+ *        Needs real time. Called before setup()
+ */
+void setRealBroker(bool enabled);
+
+/**
+ * @brief Whether the access point can be reached. Going down drops the
+ *        connection and with it the broker's
+ */
+void setWifiAvailable(bool available);
+
+/**
+ * @brief Whether the MQTT broker can be reached. Going down drops the connection
+ */
+void setBrokerAvailable(bool available);
+
+/**
+ * @brief Delivers a message from the broker, if the client subscribed to the topic
+ */
+void injectMqttMessage(const char* topic, const char* payload, bool retain);
+
+/**
+ * @brief Lets the IR receiver decode an NEC code
+ */
+void injectIrCode(uint32_t code);
+
+/**
+ * @brief Sets the level at the microphone, a square wave around the ADC's
+ *        midpoint. It stays until the next call
+ *
+ * @param amplitude 0 for silence up to 2047
+ */
+void setSoundLevel(uint16_t amplitude);
+
+/**
+ * @brief Puts a simulated PN532 on the I2C bus, see setNfcTag()
+ */
+void attachPn532();
+
+/**
+ * @brief Holds a tag against the antenna of the PN532, it stays there until
+ *        the next call
+ *
+ * @param uid UID of the tag, 4 bytes for MIFARE Classic, 7 for NTAG/Ultralight
+ * @param length bytes of the UID, 0 to take the tag away
+ */
+void setNfcTag(const uint8_t* uid, uint8_t length);
+
+/**
+ * @brief Device on the simulated I2C bus, see TwoWire
+ */
+class I2cTarget {
+public:
+  virtual ~I2cTarget() {}
+  // A write transaction, false to NACK it
+  virtual bool receive(const uint8_t* data, size_t length) = 0;
+  // A read transaction, fills up to length bytes and returns how many
+  virtual size_t request(uint8_t* data, size_t length) = 0;
+};
+
+/**
+ * @brief Puts a device on the bus. Addresses without a device NACK
+ */
+void attachI2cTarget(uint8_t address, I2cTarget* target);
+
+#endif
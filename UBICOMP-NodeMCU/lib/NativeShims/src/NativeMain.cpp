@@ -0,0 +1,175 @@
+// Entry point of the host run of the firmware (env:native)
+//
+// Usage:  program [seconds] [script]
+//         runs setup() and loop() for seconds of virtual time, 10 by default
+//         program fleet <nodes> [seconds] [script]
+//         runs a fleet of nodes against a real broker, see lib/NativeFleet
+//
+// Every line of the script is an event at a virtual time (ms), see Script.h:
+//   <ms> ir <code>                  NEC code decoded by the IR receiver, e.g. 0xFFA25D
+//   <ms> nfc <uid>|off              tag held against the PN532 (hex UID) or taken away
+//   <ms> sound <amplitude>          level at the microphone from now on, 0 for silence
+//   <ms> mqtt <topic> [payload]     message from the broker
+//   <ms> wifi up|down               access point in or out of reach
+//   <ms> broker up|down             broker in or out of reach
+//
+// Left out of `pio test`, the test runner brings its own main()
+
+#ifndef PIO_UNIT_TESTING
+
+#include <Arduino.h>
+#include <Native.h>
+#include <Fleet.h>
+#include <Script.h>
+
+#include <stdio.h>
+#include <string.h>
+
+void setup();
+void loop();
+
+namespace {
+
+// Virtual time moved on when loop() returned without waiting (us)
+const uint64_t LOOP_STEP = 100;
+
+bool parseUid(const std::string& text, std::string& uid) {
+  if(text.size() % 2 || text.size() / 2 > 10) {
+    return false;
+  }
+  uid.clear();
+  for(size_t i = 0; i < text.size(); i += 2) {
+    char* end;
+    std::string digits = text.substr(i, 2);
+    unsigned long byte = strtoul(digits.c_str(), &end, 16);
+    if(*end) {
+      return false;
+    }
+    uid += (char) byte;
+  }
+  return true;
+}
+
+bool parseUpDown(const std::string& text, bool* up) {
+  *up = text == "up";
+  return *up || text == "down";
+}
+
+/**
+ * @brief Schedules an input of the node at a time (us)
+ *
+ * @return false if the kind or its arguments are invalid
+ */
+bool scheduleInput(uint64_t at, const std::string& kind, const char* arguments) {
+  std::string argument = nextWord(arguments);
+  if(argument.empty()) {
+    return false;
+  }
+
+  if(kind == "ir") {
+    uint32_t code = strtoul(argument.c_str(), NULL, 0);
+    runAt(at, [code] { injectIrCode(code); });
+  } else if(kind == "nfc") {
+    std::string uid;
+    if(argument != "off" && !parseUid(argument, uid)) {
+      return false;
+    }
+    runAt(at, [uid] { setNfcTag((const uint8_t*) uid.data(), uid.size()); });
+  } else if(kind == "sound") {
+    uint16_t amplitude = strtoul(argument.c_str(), NULL, 0);
+    runAt(at, [amplitude] { setSoundLevel(amplitude); });
+  } else if(kind == "mqtt") {
+    std::string payload(arguments);
+    runAt(at, [argument, payload] { injectMqttMessage(argument.c_str(), payload.c_str(), false); });
+  } else if(kind == "wifi" || kind == "broker") {
+    bool up;
+    if(!parseUpDown(argument, &up)) {
+      return false;
+    }
+    if(kind == "wifi") {
+      runAt(at, [up] { setWifiAvailable(up); });
+    } else {
+      runAt(at, [up] { setBrokerAvailable(up); });
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool scheduleLine(const t_script_line& line, uint64_t offset) {
+  for(uint32_t i = 0; i < line.count; i++) {
+    if(!scheduleInput(offset + (line.at + i * line.interval) * 1000, line.kind, line.arguments)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void run(uint64_t until) {
+  attachPn532();
+  setup();
+  while(nativeTime() < until) {
+    uint64_t before = nativeTime();
+    loop();
+    if(nativeTime() == before) {
+      advanceTime(LOOP_STEP);
+    }
+  }
+
+  // The tasks never return, they end with the process
+  fflush(stdout);
+  _Exit(0);
+}
+
+/**
+ * @brief A node of a fleet, started by runFleet(): real time, the broker of
+ *        Credentials.h and the inputs of the script addressed to this node
+ *
+ * @param epoch host time (us, CLOCK_MONOTONIC) of the script's time 0
+ */
+int runNode(uint64_t seconds, uint64_t epoch, const char* path) {
+  setRealTime(true);
+  setRealBroker(true);
+  int64_t offset = (int64_t) epoch - (int64_t) fleetClock() + (int64_t) nativeTime();
+  if(offset < 0) {
+    offset = 0;
+  }
+  if(path && !readScript(path, [offset](const t_script_line& line) {
+    if(isFleetCommand(line.kind)) {
+      return true;
+    }
+    const char* arguments = line.arguments;
+    std::string target = nextWord(arguments);
+    if(target != "*" && target != nativeNodeId()) {
+      return true;
+    }
+    t_script_line input = line;
+    input.arguments = arguments;
+    return scheduleLine(input, offset);
+  })) {
+    return 2;
+  }
+  run(offset + seconds * 1000000);
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if(argc > 1 && !strcmp(argv[1], "fleet")) {
+    return runFleet(argv[0], argc - 2, argv + 2);
+  }
+  if(argc > 3 && !strcmp(argv[1], "node")) {
+    return runNode(strtoull(argv[2], NULL, 10), strtoull(argv[3], NULL, 10), argc > 4 ? argv[4] : NULL);
+  }
+
+  uint64_t duration = (argc > 1 ? strtoull(argv[1], NULL, 10) : 10) * 1000000;
+  if(argc > 2 && !readScript(argv[2], [](const t_script_line& line) { return scheduleLine(line, 0); })) {
+    return 2;
+  }
+  run(duration);
+  return 0;
+}
+
+#endif
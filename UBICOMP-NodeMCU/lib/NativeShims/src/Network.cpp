@@ -0,0 +1,362 @@
+#include <WiFi.h>
+#include <AsyncMqttClient.h>
+#include <MqttSession.h>
+#include <Native.h>
+
+#include <unistd.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Delays (us) of the simulated network
+#define WIFI_CONNECT_DELAY 100000
+#define WIFI_FAIL_DELAY 3000000
+#define MQTT_CONNECT_DELAY 20000
+#define MQTT_FAIL_DELAY 1000000
+// Keep alive (s) of sessions with a real broker, as AsyncMqttClient's
+#define MQTT_KEEP_ALIVE 15
+
+WiFiClass WiFi;
+
+struct NativeBroker {
+  AsyncMqttClient* client = NULL;
+  std::atomic<bool> connected { false };
+  bool available = true;
+  // Guards the subscriptions and packet ids, publish() runs on any task
+  std::mutex mutex;
+  std::vector<std::string> subscriptions;
+  uint16_t packetId = 0;
+  // TCP session with a real broker, see setRealBroker()
+  MqttSession* session = NULL;
+
+  uint16_t nextPacketId() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(++packetId == 0) {
+      packetId = 1;
+    }
+    return packetId;
+  }
+
+  void open();
+  void drop();
+  bool subscribed(const char* topic);
+  void deliver(const char* topic, const char* payload, size_t length, uint8_t qos, bool retain);
+};
+
+namespace {
+
+NativeBroker broker;
+
+// See setRealBroker()
+bool realBroker = false;
+
+WiFiEventCb wifiHandler = NULL;
+bool wifiAvailable = true;
+bool wifiConnected = false;
+
+void raise(system_event_id_t event) {
+  if(wifiHandler) {
+    wifiHandler(event);
+  }
+}
+
+// MQTT topic filter matching with + and #
+bool matches(const char* filter, const char* topic) {
+  while(*filter) {
+    if(*filter == '#') {
+      return true;
+    }
+    if(*filter == '+') {
+      while(*topic && *topic != '/') {
+        topic++;
+      }
+      filter++;
+      continue;
+    }
+    if(*filter != *topic) {
+      return false;
+    }
+    filter++;
+    topic++;
+  }
+  return !*topic;
+}
+
+void printPayload(const char* topic, const char* payload, size_t length) {
+  bool text = true;
+  for(size_t i = 0; i < length; i++) {
+    if(payload[i] < 0x20 || payload[i] > 0x7E) {
+      text = false;
+      break;
+    }
+  }
+  std::string line = std::string("mqtt> ") + topic + " ";
+  if(text) {
+    line.append(payload, length);
+  } else {
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    for(size_t i = 0; i < length; i++) {
+      line += HEX_DIGITS[(uint8_t) payload[i] >> 4];
+      line += HEX_DIGITS[payload[i] & 0x0F];
+    }
+  }
+  line += "\n";
+  fwrite(line.data(), 1, line.size(), stdout);
+}
+
+}  // namespace
+
+/***** WiFi ******/
+
+void WiFiClass::onEvent(WiFiEventCb handler) {
+  wifiHandler = handler;
+}
+
+void WiFiClass::begin(const char*, const char*) {
+  if(wifiAvailable) {
+    runAt(nativeTime() + WIFI_CONNECT_DELAY, [] {
+      if(wifiAvailable && !wifiConnected) {
+        wifiConnected = true;
+        raise(SYSTEM_EVENT_STA_GOT_IP);
+      }
+    });
+  } else {
+    runAt(nativeTime() + WIFI_FAIL_DELAY, [] { raise(SYSTEM_EVENT_STA_DISCONNECTED); });
+  }
+}
+
+void WiFiClass::disconnect(bool) {
+  if(wifiConnected) {
+    wifiConnected = false;
+    broker.drop();
+    runAt(nativeTime(), [] { raise(SYSTEM_EVENT_STA_DISCONNECTED); });
+  }
+}
+
+void WiFiClass::reconnect() {
+  begin(NULL, NULL);
+}
+
+bool WiFiClass::isConnected() {
+  return wifiConnected;
+}
+
+String WiFiClass::localIP() {
+  return "10.0.0.2";
+}
+
+String WiFiClass::macAddress() {
+  return "24:0A:C4:00:00:01";
+}
+
+void setWifiAvailable(bool available) {
+  wifiAvailable = available;
+  if(!available) {
+    WiFi.disconnect();
+  }
+}
+
+/***** MQTT ******/
+
+void NativeBroker::open() {
+  if(!session) {
+    MqttSession::Handlers handlers;
+    // Everything from the reader thread is handed to the main thread, as
+    // AsyncTCP hands it to its task on the device
+    handlers.message = [this](const char* topic, const uint8_t* payload, size_t length, uint8_t qos, bool retain) {
+      std::string topicCopy(topic);
+      std::string payloadCopy((const char*) payload, length);
+      runAt(nativeTime(), [this, topicCopy, payloadCopy, qos, retain] {
+        deliver(topicCopy.c_str(), payloadCopy.data(), payloadCopy.size(), qos, retain);
+      });
+    };
+    handlers.subscribed = [this](uint16_t packetId, uint8_t qos) {
+      runAt(nativeTime(), [this, packetId, qos] {
+        if(client->subscribeCallback) {
+          client->subscribeCallback(packetId, qos);
+        }
+      });
+    };
+    handlers.published = [this](uint16_t packetId) {
+      runAt(nativeTime(), [this, packetId] {
+        if(client->publishCallback) {
+          client->publishCallback(packetId);
+        }
+      });
+    };
+    handlers.closed = [this] {
+      runAt(nativeTime(), [this] { drop(); });
+    };
+    session = new MqttSession(handlers);
+  }
+
+  // Connecting blocks, AsyncTCP doesn't
+  std::thread([this] {
+    char clientId[24];
+    snprintf(clientId, sizeof(clientId), "native-%d", (int) getpid());
+    bool opened = session->open(client->host, client->port, clientId, MQTT_KEEP_ALIVE);
+    runAt(nativeTime(), [this, opened] {
+      // The session may have been lost or dropped again meanwhile
+      if(opened && session->isOpen() && wifiConnected && available) {
+        if(!connected.exchange(true) && client->connectCallback) {
+          client->connectCallback(false);
+        }
+        return;
+      }
+      session->close();
+      if(!connected && client->disconnectCallback) {
+        client->disconnectCallback(AsyncMqttClientDisconnectReason::TCP_DISCONNECTED);
+      }
+    });
+  }).detach();
+}
+
+void NativeBroker::drop() {
+  if(session) {
+    session->close();
+  }
+  if(!connected.exchange(false)) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    subscriptions.clear();
+  }
+  if(client->disconnectCallback) {
+    client->disconnectCallback(AsyncMqttClientDisconnectReason::TCP_DISCONNECTED);
+  }
+}
+
+bool NativeBroker::subscribed(const char* topic) {
+  std::lock_guard<std::mutex> lock(mutex);
+  for(const std::string& filter : subscriptions) {
+    if(matches(filter.c_str(), topic)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void NativeBroker::deliver(const char* topic, const char* payload, size_t length, uint8_t qos, bool retain) {
+  if(!connected || !client->messageCallback || !subscribed(topic)) {
+    return;
+  }
+  // The client may modify both, like the buffers of AsyncMqttClient
+  std::string topicCopy(topic);
+  std::string payloadCopy(payload, length);
+  AsyncMqttClientMessageProperties properties = { qos, false, retain };
+  client->messageCallback(&topicCopy[0], &payloadCopy[0], properties, length, 0, length);
+}
+
+AsyncMqttClient::AsyncMqttClient() {
+  broker.client = this;
+}
+
+void AsyncMqttClient::connect() {
+  if(realBroker && wifiConnected && broker.available) {
+    broker.open();
+  } else if(wifiConnected && broker.available) {
+    runAt(nativeTime() + MQTT_CONNECT_DELAY, [this] {
+      if(wifiConnected && broker.available && !broker.connected.exchange(true) && connectCallback) {
+        connectCallback(false);
+      }
+    });
+  } else {
+    runAt(nativeTime() + MQTT_FAIL_DELAY, [this] {
+      if(!broker.connected && disconnectCallback) {
+        disconnectCallback(AsyncMqttClientDisconnectReason::TCP_DISCONNECTED);
+      }
+    });
+  }
+}
+
+void AsyncMqttClient::disconnect(bool) {
+  runAt(nativeTime(), [] { broker.drop(); });
+}
+
+bool AsyncMqttClient::connected() const {
+  return broker.connected;
+}
+
+uint16_t AsyncMqttClient::subscribe(const char* topic, uint8_t qos) {
+  if(!broker.connected) {
+    return 0;
+  }
+  {
+    std::lock_guard<std::mutex> lock(broker.mutex);
+    broker.subscriptions.push_back(topic);
+  }
+  if(realBroker) {
+    return broker.session->subscribe(topic, qos);
+  }
+  uint16_t packetId = broker.nextPacketId();
+  runAt(nativeTime(), [this, packetId, qos] {
+    if(subscribeCallback) {
+      subscribeCallback(packetId, qos);
+    }
+  });
+  return packetId;
+}
+
+uint16_t AsyncMqttClient::unsubscribe(const char* topic) {
+  if(!broker.connected) {
+    return 0;
+  }
+  // A real broker keeps sending, the messages aren't delivered any more
+  uint16_t packetId = broker.nextPacketId();
+  {
+    std::lock_guard<std::mutex> lock(broker.mutex);
+    for(size_t i = 0; i < broker.subscriptions.size(); i++) {
+      if(broker.subscriptions[i] == topic) {
+        broker.subscriptions.erase(broker.subscriptions.begin() + i);
+        break;
+      }
+    }
+  }
+  runAt(nativeTime(), [this, packetId] {
+    if(unsubscribeCallback) {
+      unsubscribeCallback(packetId);
+    }
+  });
+  return packetId;
+}
+
+uint16_t AsyncMqttClient::publish(const char* topic, uint8_t qos, bool retain, const char* payload, size_t length,
+                                  bool, uint16_t) {
+  if(!broker.connected) {
+    return 0;
+  }
+  if(payload && !length) {
+    length = strlen(payload);
+  }
+  printPayload(topic, payload ? payload : "", length);
+  if(realBroker) {
+    return broker.session->publish(topic, (const uint8_t*) payload, length, qos, retain);
+  }
+  uint16_t packetId = broker.nextPacketId();
+  if(qos > 0) {
+    runAt(nativeTime(), [this, packetId] {
+      if(publishCallback) {
+        publishCallback(packetId);
+      }
+    });
+  }
+  return packetId;
+}
+
+void setRealBroker(bool enabled) {
+  realBroker = enabled;
+}
+
+void setBrokerAvailable(bool available) {
+  broker.available = available;
+  if(!available) {
+    broker.drop();
+  }
+}
+
+void injectMqttMessage(const char* topic, const char* payload, bool retain) {
+  broker.deliver(topic, payload, strlen(payload), 0, retain);
+}
@@ -0,0 +1,134 @@
+#include <Native.h>
+
+#include <mutex>
+#include <string.h>
+#include <vector>
+
+// 7 bit address of the PN532
+#define PN532_ADDRESS 0x24
+#define PN532_HOST_TO_PN532 0xD4
+#define PN532_PN532_TO_HOST 0xD5
+#define PN532_COMMAND_GET_FIRMWARE_VERSION 0x02
+#define PN532_COMMAND_IN_LIST_PASSIVE_TARGET 0x4A
+
+namespace {
+
+const uint8_t ACK[] = { 0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00 };
+const uint8_t NACK[] = { 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00 };
+// IC, version, revision, supported cards of a PN532 v1.6
+const uint8_t FIRMWARE_VERSION[] = { 0x32, 0x01, 0x06, 0x07 };
+
+/**
+ * @brief PN532 behind the I2C frame protocol of PN532_I2C. Commands are
+ *        acknowledged and answered at once, except for InListPassiveTarget
+ *        that waits until a tag is held against the antenna
+ */
+class Pn532 : public I2cTarget {
+public:
+  bool receive(const uint8_t* data, size_t length) override {
+    std::lock_guard<std::mutex> lock(mutex);
+    // The host asks for the last response again
+    if(length == sizeof(NACK) && !memcmp(data, NACK, sizeof(NACK))) {
+      responseRead = false;
+      return true;
+    }
+    // 00 00 FF LEN LCS D4 CMD ... DCS 00
+    if(length < 8 || data[2] != 0xFF || (uint8_t) (data[3] + data[4]) || data[5] != PN532_HOST_TO_PN532) {
+      return true;
+    }
+    command = data[6];
+    acknowledge = true;
+    response.clear();
+    responseRead = false;
+    waiting = command == PN532_COMMAND_IN_LIST_PASSIVE_TARGET;
+    if(command == PN532_COMMAND_GET_FIRMWARE_VERSION) {
+      respond(FIRMWARE_VERSION, sizeof(FIRMWARE_VERSION));
+    } else if(waiting) {
+      detect();
+    } else {
+      // SAMConfiguration and the rest have no response data
+      respond(NULL, 0);
+    }
+    return true;
+  }
+
+  size_t request(uint8_t* data, size_t length) override {
+    std::lock_guard<std::mutex> lock(mutex);
+    memset(data, 0, length);
+    if(acknowledge) {
+      // Ready, then the ACK frame
+      data[0] = 0x01;
+      memcpy(data + 1, ACK, std::min(length - 1, sizeof(ACK)));
+      acknowledge = false;
+      return length;
+    }
+    if(response.empty() || responseRead) {
+      // Status byte 0, busy
+      return length;
+    }
+    data[0] = 0x01;
+    size_t copied = std::min(length - 1, response.size());
+    memcpy(data + 1, response.data(), copied);
+    // Reading the whole frame takes it, a status or header read doesn't
+    responseRead = copied == response.size();
+    return length;
+  }
+
+  void setTag(const uint8_t* uid, uint8_t length) {
+    std::lock_guard<std::mutex> lock(mutex);
+    tag.assign(uid, uid + length);
+    if(waiting) {
+      detect();
+    }
+  }
+
+private:
+  // Answers a pending InListPassiveTarget if a tag is there
+  void detect() {
+    if(tag.empty()) {
+      return;
+    }
+    // Tags found, tag number, SENS_RES, SEL_RES, NFCID length, NFCID
+    std::vector<uint8_t> target = { 0x01, 0x01, 0x00, (uint8_t) (tag.size() == 4 ? 0x04 : 0x44), 0x00, (uint8_t) tag.size() };
+    target.insert(target.end(), tag.begin(), tag.end());
+    respond(target.data(), target.size());
+    waiting = false;
+  }
+
+  // 00 00 FF LEN LCS D5 CMD+1 ... DCS 00
+  void respond(const uint8_t* data, size_t length) {
+    uint8_t frameLength = length + 2;
+    uint8_t sum = PN532_PN532_TO_HOST + command + 1;
+    response = { 0x00, 0x00, 0xFF, frameLength, (uint8_t) -frameLength, PN532_PN532_TO_HOST, (uint8_t) (command + 1) };
+    for(size_t i = 0; i < length; i++) {
+      response.push_back(data[i]);
+      sum += data[i];
+    }
+    response.push_back((uint8_t) -sum);
+    response.push_back(0x00);
+    responseRead = false;
+  }
+
+  std::mutex mutex;
+  uint8_t command = 0;
+  // Whether the ACK of the last command wasn't read yet
+  bool acknowledge = false;
+  // Whether InListPassiveTarget waits for a tag
+  bool waiting = false;
+  std::vector<uint8_t> response;
+  bool responseRead = false;
+  // UID of the tag on the antenna, empty if there is none
+  std::vector<uint8_t> tag;
+};
+
+Pn532 pn532;
+
+}  // namespace
+
+void attachPn532() {
+  attachI2cTarget(PN532_ADDRESS, &pn532);
+}
+
+void setNfcTag(const uint8_t* uid, uint8_t length) {
+  pn532.setTag(uid, length);
+}
@@ -0,0 +1,50 @@
+#include <Preferences.h>
+
+#include <map>
+#include <vector>
+
+namespace {
+
+std::map<std::string, std::vector<uint8_t>> entries;
+
+}  // namespace
+
+bool Preferences::begin(const char* name, bool) {
+  space = std::string(name) + "/";
+  return true;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+  std::map<std::string, std::vector<uint8_t>>::iterator entry = entries.find(space + key);
+  return entry == entries.end() ? 0 : entry->second.size();
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t length) {
+  std::map<std::string, std::vector<uint8_t>>::iterator entry = entries.find(space + key);
+  if(entry == entries.end() || entry->second.size() > length) {
+    return 0;
+  }
+  memcpy(buffer, entry->second.data(), entry->second.size());
+  return entry->second.size();
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) {
+  const uint8_t* bytes = (const uint8_t*) value;
+  entries[space + key].assign(bytes, bytes + length);
+  return length;
+}
+
+bool Preferences::remove(const char* key) {
+  return entries.erase(space + key) > 0;
+}
+
+bool Preferences::clear() {
+  for(std::map<std::string, std::vector<uint8_t>>::iterator entry = entries.begin(); entry != entries.end();) {
+    if(entry->first.compare(0, space.size(), space) == 0) {
+      entry = entries.erase(entry);
+    } else {
+      entry++;
+    }
+  }
+  return true;
+}
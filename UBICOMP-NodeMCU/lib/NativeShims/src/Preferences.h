@@ -0,0 +1,23 @@
+#ifndef NATIVE_PREFERENCES_H
+#define NATIVE_PREFERENCES_H
+
+#include <Arduino.h>
+
+/**
+ * @brief NVS namespace in memory, it's empty on every start
+ */
+class Preferences {
+public:
+  bool begin(const char* name, bool readOnly = false);
+  void end() {}
+  size_t getBytesLength(const char* key);
+  size_t getBytes(const char* key, void* buffer, size_t length);
+  size_t putBytes(const char* key, const void* value, size_t length);
+  bool remove(const char* key);
+  bool clear();
+
+private:
+  std::string space;
+};
+
+#endif
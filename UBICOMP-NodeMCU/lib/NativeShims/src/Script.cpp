@@ -0,0 +1,68 @@
+#include <Script.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+bool parseLine(char* line, const std::function<bool(const t_script_line&)>& handle) {
+  line[strcspn(line, "\r\n")] = '\0';
+  const char* text = line + strspn(line, " \t");
+  if(!*text || *text == '#') {
+    return true;
+  }
+
+  t_script_line event = { 0, 0, 1, NULL, NULL };
+  char* end;
+  event.at = strtoull(text, &end, 10);
+  if(end == text) {
+    return false;
+  }
+  if(*end == '+') {
+    event.interval = strtoull(end + 1, &end, 10);
+    if(*end != 'x') {
+      return false;
+    }
+    event.count = strtoul(end + 1, &end, 10);
+  }
+  if(*end != ' ' && *end != '\t') {
+    return false;
+  }
+  text = end;
+  std::string kind = nextWord(text);
+  event.kind = kind.c_str();
+  event.arguments = text;
+  return handle(event);
+}
+
+}  // namespace
+
+std::string nextWord(const char*& text) {
+  text += strspn(text, " \t");
+  size_t length = strcspn(text, " \t");
+  std::string word(text, length);
+  text += length;
+  text += strspn(text, " \t");
+  return word;
+}
+
+bool readScript(const char* path, const std::function<bool(const t_script_line&)>& handle) {
+  FILE* script = fopen(path, "r");
+  if(!script) {
+    perror(path);
+    return false;
+  }
+  char line[512];
+  unsigned int number = 0;
+  bool valid = true;
+  while(fgets(line, sizeof(line), script)) {
+    number++;
+    if(!parseLine(line, handle)) {
+      fprintf(stderr, "%s:%u: invalid event\n", path, number);
+      valid = false;
+    }
+  }
+  fclose(script);
+  return valid;
+}
@@ -0,0 +1,37 @@
+#ifndef NATIVE_SCRIPT_H
+#define NATIVE_SCRIPT_H
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+
+/**
+ * @brief A line of a run script, "<time> <kind> [arguments]". The time is
+ *        <ms> or <ms>+<interval>x<count> for count events interval ms apart,
+ *        e.g. "1000+500x20 ir 0xFFB04F". Empty lines and lines starting with
+ *        # are skipped
+ */
+typedef struct s_script_line {
+  uint64_t at;  // ms
+  uint64_t interval;  // ms
+  uint32_t count;
+  const char* kind;
+  const char* arguments;  // rest of the line, maybe empty
+} t_script_line;
+
+/**
+ * @brief Reads a script and hands every line to handle(), which returns
+ *        false if it's invalid. Invalid lines are reported on stderr
+ *
+ * @return true if the script was read and every line was valid
+ */
+bool readScript(const char* path, const std::function<bool(const t_script_line&)>& handle);
+
+/**
+ * @brief Splits the next word off text
+ *
+ * @return the word, empty at the end of text
+ */
+std::string nextWord(const char*& text);
+
+#endif
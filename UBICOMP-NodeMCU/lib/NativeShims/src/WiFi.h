@@ -0,0 +1,32 @@
+#ifndef NATIVE_WIFI_H
+#define NATIVE_WIFI_H
+
+#include <Arduino.h>
+
+typedef enum {
+  SYSTEM_EVENT_STA_START = 2,
+  SYSTEM_EVENT_STA_CONNECTED = 4,
+  SYSTEM_EVENT_STA_DISCONNECTED = 5,
+  SYSTEM_EVENT_STA_GOT_IP = 7
+} system_event_id_t;
+typedef system_event_id_t WiFiEvent_t;
+typedef void (*WiFiEventCb)(system_event_id_t event);
+
+/**
+ * @brief Station of the simulated access point, see setWifiAvailable().
+ *        Events are raised on the main thread like by the WiFi stack
+ */
+class WiFiClass {
+public:
+  void onEvent(WiFiEventCb handler);
+  void begin(const char* ssid, const char* password);
+  void disconnect(bool wifiOff = false);
+  void reconnect();
+  bool isConnected();
+  String localIP();
+  String macAddress();
+};
+
+extern WiFiClass WiFi;
+
+#endif
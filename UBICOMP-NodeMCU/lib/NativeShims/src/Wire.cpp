@@ -0,0 +1,62 @@
+#include <Wire.h>
+#include <Native.h>
+
+#include <map>
+
+TwoWire Wire;
+
+namespace {
+
+std::map<uint8_t, I2cTarget*> targets;
+
+I2cTarget* targetAt(uint8_t address) {
+  std::map<uint8_t, I2cTarget*>::iterator target = targets.find(address);
+  return target == targets.end() ? NULL : target->second;
+}
+
+}  // namespace
+
+void attachI2cTarget(uint8_t address, I2cTarget* target) {
+  targets[address] = target;
+}
+
+void TwoWire::beginTransmission(uint8_t target) {
+  address = target;
+  transmitLength = 0;
+}
+
+size_t TwoWire::write(uint8_t data) {
+  if(transmitLength >= sizeof(transmit)) {
+    return 0;
+  }
+  transmit[transmitLength++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t length) {
+  size_t written = 0;
+  while(written < length && write(data[written])) {
+    written++;
+  }
+  return written;
+}
+
+uint8_t TwoWire::endTransmission(bool) {
+  I2cTarget* target = targetAt(address);
+  return target && target->receive(transmit, transmitLength) ? 0 : 2;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t target, uint8_t length, bool) {
+  I2cTarget* device = targetAt(target);
+  receiveIndex = 0;
+  receiveLength = device ? device->request(receive, std::min((size_t) length, sizeof(receive))) : 0;
+  return receiveLength;
+}
+
+int TwoWire::available() {
+  return receiveLength - receiveIndex;
+}
+
+int TwoWire::read() {
+  return receiveIndex < receiveLength ? receive[receiveIndex++] : -1;
+}
@@ -0,0 +1,38 @@
+#ifndef NATIVE_WIRE_H
+#define NATIVE_WIRE_H
+
+#include <Arduino.h>
+
+/**
+ * @brief I2C master on the simulated bus. Transactions go to the I2cTarget
+ *        attached at their address (Native.h), others are NACKed
+ */
+class TwoWire {
+public:
+  void begin() {}
+  void setClock(uint32_t) {}
+
+  void beginTransmission(uint8_t address);
+  void beginTransmission(int address) { beginTransmission((uint8_t) address); }
+  size_t write(uint8_t data);
+  size_t write(const uint8_t* data, size_t length);
+  // 0 on success, 2 if the address was NACKed
+  uint8_t endTransmission(bool stop = true);
+
+  uint8_t requestFrom(uint8_t address, uint8_t length, bool stop = true);
+  uint8_t requestFrom(int address, int length, int stop = 1) { return requestFrom((uint8_t) address, (uint8_t) length, stop != 0); }
+  int available();
+  int read();
+
+private:
+  uint8_t address = 0;
+  uint8_t transmit[128];
+  size_t transmitLength = 0;
+  uint8_t receive[128];
+  size_t receiveLength = 0;
+  size_t receiveIndex = 0;
+};
+
+extern TwoWire Wire;
+
+#endif
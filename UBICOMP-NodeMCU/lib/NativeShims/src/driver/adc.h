@@ -0,0 +1,17 @@
+#ifndef NATIVE_DRIVER_ADC_H
+#define NATIVE_DRIVER_ADC_H
+
+typedef enum {
+  ADC_UNIT_1 = 1
+} adc_unit_t;
+
+typedef enum {
+  ADC1_CHANNEL_0 = 0,
+  ADC1_CHANNEL_3 = 3,
+  ADC1_CHANNEL_4 = 4,
+  ADC1_CHANNEL_5 = 5,
+  ADC1_CHANNEL_6 = 6,
+  ADC1_CHANNEL_7 = 7
+} adc1_channel_t;
+
+#endif
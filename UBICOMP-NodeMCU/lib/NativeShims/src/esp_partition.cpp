@@ -0,0 +1,80 @@
+#include <esp_partition.h>
+#include <esp_system.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// Erase unit of the flash
+#define FLASH_SECTOR_SIZE 4096
+
+namespace {
+
+// As in partitions.csv
+const esp_partition_t PARTITIONS[] = {
+  { ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t) 0x02, 0x9000, 0x5000, "nvs", false },
+  { ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t) 0x40, 0x290000, 0x40000, "eventlog", false },
+};
+const size_t PARTITION_COUNT = sizeof(PARTITIONS) / sizeof(PARTITIONS[0]);
+
+std::vector<uint8_t>& contents(const esp_partition_t* partition) {
+  static std::vector<uint8_t> flash[PARTITION_COUNT];
+  size_t index = partition - PARTITIONS;
+  if(flash[index].empty()) {
+    flash[index].assign(partition->size, 0xFF);
+  }
+  return flash[index];
+}
+
+bool valid(const esp_partition_t* partition, size_t offset, size_t size) {
+  return partition >= PARTITIONS && partition < PARTITIONS + PARTITION_COUNT &&
+         offset <= partition->size && size <= partition->size - offset;
+}
+
+}  // namespace
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char* label) {
+  for(size_t i = 0; i < PARTITION_COUNT; i++) {
+    const esp_partition_t* partition = &PARTITIONS[i];
+    if(partition->type == type && (subtype == ESP_PARTITION_SUBTYPE_ANY || partition->subtype == subtype) &&
+       (!label || !strcmp(partition->label, label))) {
+      return partition;
+    }
+  }
+  return NULL;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t offset, void* data, size_t size) {
+  if(!valid(partition, offset, size)) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  memcpy(data, &contents(partition)[offset], size);
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t offset, const void* data, size_t size) {
+  if(!valid(partition, offset, size)) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  const uint8_t* bytes = (const uint8_t*) data;
+  std::vector<uint8_t>& flash = contents(partition);
+  for(size_t i = 0; i < size; i++) {
+    flash[offset + i] &= bytes[i];
+  }
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+  if(!valid(partition, offset, size)) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  if(offset % FLASH_SECTOR_SIZE || size % FLASH_SECTOR_SIZE) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  memset(&contents(partition)[offset], 0xFF, size);
+  return ESP_OK;
+}
+
+uint32_t esp_random(void) {
+  return ((uint32_t) rand() << 16) ^ (uint32_t) rand();
+}
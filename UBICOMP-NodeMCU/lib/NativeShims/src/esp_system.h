@@ -0,0 +1,8 @@
+#ifndef NATIVE_ESP_SYSTEM_H
+#define NATIVE_ESP_SYSTEM_H
+
+#include <stdint.h>
+
+uint32_t esp_random(void);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef NATIVE_FREERTOS_TIMERS_H
+#define NATIVE_FREERTOS_TIMERS_H
+
+#include <Arduino.h>
+
+// Software timers, their callbacks run on the main thread when due
+typedef struct NativeTimer* TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t timer);
+
+TimerHandle_t xTimerCreate(const char* name, TickType_t period, UBaseType_t autoReload, void* id,
+                           TimerCallbackFunction_t callback);
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t wait);
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t wait);
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t wait);
+void* pvTimerGetTimerID(TimerHandle_t timer);
+
+#endif
@@ -0,0 +1,53 @@
+#include <driver/i2s.h>
+#include <Arduino.h>
+#include <Native.h>
+
+#include <atomic>
+
+namespace {
+
+uint32_t sampleRate = 0;
+adc1_channel_t channel = ADC1_CHANNEL_0;
+// Virtual time (us) up to which samples were read
+uint64_t sampled = 0;
+// Samples read so far, the phase of the square wave
+uint64_t sampleCount = 0;
+std::atomic<uint16_t> amplitude(0);
+
+}  // namespace
+
+esp_err_t i2s_driver_install(i2s_port_t, const i2s_config_t* config, int, void*) {
+  sampleRate = config->sample_rate;
+  sampled = micros();
+  return ESP_OK;
+}
+
+esp_err_t i2s_set_adc_mode(adc_unit_t, adc1_channel_t adcChannel) {
+  channel = adcChannel;
+  return ESP_OK;
+}
+
+esp_err_t i2s_adc_enable(i2s_port_t) {
+  return ESP_OK;
+}
+
+esp_err_t i2s_read(i2s_port_t, void* data, size_t size, size_t* bytesRead, uint32_t) {
+  // The samples that came in since the last read, as the DMA would have them
+  uint64_t now = micros();
+  size_t available = sampleRate ? (now - sampled) * sampleRate / 1000000 : 0;
+  size_t count = std::min(available, size / sizeof(uint16_t));
+  uint16_t* samples = (uint16_t*) data;
+  uint16_t level = amplitude;
+  for(size_t i = 0; i < count; i++, sampleCount++) {
+    // The upper 4 bits carry the channel
+    uint16_t sample = sampleCount & 1 ? 0x0800 - level : 0x0800 + level;
+    samples[i] = (uint16_t) (channel << 12) | std::min<uint16_t>(sample, 0x0FFF);
+  }
+  sampled += sampleRate ? (uint64_t) count * 1000000 / sampleRate : 0;
+  *bytesRead = count * sizeof(uint16_t);
+  return ESP_OK;
+}
+
+void setSoundLevel(uint16_t level) {
+  amplitude = std::min<uint16_t>(level, 0x07FF);
+}
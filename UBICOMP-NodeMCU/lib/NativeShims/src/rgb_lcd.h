@@ -0,0 +1,52 @@
+#ifndef NATIVE_RGB_LCD_H
+#define NATIVE_RGB_LCD_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Grove RGB LCD that keeps its contents, for checks of what is shown
+ */
+class rgb_lcd : public Print {
+public:
+  void begin(uint8_t columns, uint8_t rows) {
+    (void) columns;
+    (void) rows;
+    clear();
+    setRGB(255, 255, 255);
+  }
+  void display() {}
+  void noDisplay() {}
+  void clear() {
+    memset(cells, ' ', sizeof(cells));
+    setCursor(0, 0);
+  }
+  void setCursor(uint8_t column, uint8_t row) {
+    cursorColumn = column;
+    cursorRow = row;
+  }
+  void setRGB(unsigned char red, unsigned char green, unsigned char blue) {
+    color[0] = red;
+    color[1] = green;
+    color[2] = blue;
+  }
+  size_t write(uint8_t c) override {
+    if(cursorRow < 2 && cursorColumn < 16) {
+      cells[cursorRow][cursorColumn] = c;
+    }
+    cursorColumn++;
+    return 1;
+  }
+  using Print::write;
+
+  // Contents of a row, not terminated
+  const char* row(uint8_t row) const { return cells[row]; }
+  const uint8_t* rgb() const { return color; }
+
+private:
+  char cells[2][16];
+  uint8_t cursorColumn = 0;
+  uint8_t cursorRow = 0;
+  uint8_t color[3] = { 0, 0, 0 };
+};
+
+#endif
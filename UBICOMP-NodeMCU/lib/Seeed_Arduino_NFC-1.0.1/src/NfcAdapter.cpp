@@ -31,6 +31,19 @@ void NfcAdapter::begin(boolean verbose) {
     shield->SAMConfig();
 }
 
+void NfcAdapter::startBegin() {
+    shield->beginBus();
+}
+
+boolean NfcAdapter::beginReady(uint16_t timeout) {
+    // the PN532 doesn't acknowledge any command before it woke up
+    if (!shield->getFirmwareVersion(timeout)) {
+        return false;
+    }
+    // configure board to read RFID tags
+    return shield->SAMConfig(timeout);
+}
+
 boolean NfcAdapter::tagPresent(unsigned long timeout) {
     uint8_t success;
     uidLength = 0;
@@ -43,6 +56,21 @@ boolean NfcAdapter::tagPresent(unsigned long timeout) {
     return success;
 }
 
+boolean NfcAdapter::startTagDetection() {
+    uidLength = 0;
+    return shield->startPassiveTargetIDDetection(PN532_MIFARE_ISO14443A);
+}
+
+boolean NfcAdapter::tagDetectionReady() {
+    return shield->isResponseReady();
+}
+
+boolean NfcAdapter::readDetectedTag() {
+    uidLength = 0;
+    // the response is ready, so there is nothing to wait for
+    return shield->readDetectedPassiveTargetID(uid, (uint8_t*)&uidLength, 1);
+}
+
 boolean NfcAdapter::erase() {
     NdefMessage message = NdefMessage();
     message.addEmptyRecord();
@@ -125,6 +153,21 @@ NfcTag NfcAdapter::read() {
 
 }
 
+NfcTag NfcAdapter::identify() {
+    if (guessTagType() == TAG_TYPE_MIFARE_CLASSIC) {
+        return NfcTag(uid, uidLength, "Mifare Classic");
+    }
+    return NfcTag(uid, uidLength, "NFC Forum Type 2");
+}
+
+uint8_t NfcAdapter::getUidLength() {
+    return uidLength;
+}
+
+void NfcAdapter::getUid(byte* uid, unsigned int uidLength) {
+    memcpy(uid, this->uid, this->uidLength < uidLength ? this->uidLength : uidLength);
+}
+
 boolean NfcAdapter::write(NdefMessage& ndefMessage) {
     boolean success;
     uint8_t type = guessTagType();
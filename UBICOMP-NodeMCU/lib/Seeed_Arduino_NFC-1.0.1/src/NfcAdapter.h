@@ -26,8 +26,21 @@ class NfcAdapter {
 
     ~NfcAdapter(void);
     void begin(boolean verbose = true);
+    // split-phase begin(): start the bus without waiting and poll until the PN532 answers
+    void startBegin();
+    boolean beginReady(uint16_t timeout = 1000);
     boolean tagPresent(unsigned long timeout = 0); // tagAvailable
+    // split-phase tagPresent(): start the detection and collect the result later
+    boolean startTagDetection();
+    boolean tagDetectionReady();
+    boolean readDetectedTag();
     NfcTag read();
+    // uid and guessed tag type only, without reading the NDEF message
+    NfcTag identify();
+    // uid of the last detected tag, without constructing an NfcTag
+    uint8_t getUidLength();
+    void getUid(byte* uid, unsigned int uidLength);
+    unsigned int guessTagType();
     boolean write(NdefMessage& ndefMessage);
     // erase tag by writing an empty NDEF record
     boolean erase();
@@ -39,7 +52,6 @@ class NfcAdapter {
     PN532* shield;
     byte uid[7];  // Buffer to store the returned UID
     unsigned int uidLength; // Length of the UID (4 or 7 bytes depending on ISO14443A card type)
-    unsigned int guessTagType();
 };
 
 #endif
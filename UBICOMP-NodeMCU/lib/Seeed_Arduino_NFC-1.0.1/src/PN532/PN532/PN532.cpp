@@ -27,6 +27,16 @@ void PN532::begin() {
     HAL(wakeup)();
 }
 
+/**************************************************************************/
+/*!
+    @brief  Setups the HW without waiting for the PN532 to wake up. Poll
+            getFirmwareVersion() until it answers instead
+*/
+/**************************************************************************/
+void PN532::beginBus() {
+    HAL(begin)();
+}
+
 /**************************************************************************/
 /*!
     @brief  Prints a hexadecimal value in plain characters
@@ -106,10 +116,12 @@ void PN532::PrintHexChar(const uint8_t* data, const uint32_t numBytes) {
 /*!
     @brief  Checks the firmware version of the PN5xx chip
 
+    @param  timeout   max time to wait for the response (ms)
+
     @returns  The chip's firmware version and ID
 */
 /**************************************************************************/
-uint32_t PN532::getFirmwareVersion(void) {
+uint32_t PN532::getFirmwareVersion(uint16_t timeout) {
     uint32_t response;
 
     pn532_packetbuffer[0] = PN532_COMMAND_GETFIRMWAREVERSION;
@@ -119,7 +131,7 @@ uint32_t PN532::getFirmwareVersion(void) {
     }
 
     // read data packet
-    int16_t status = HAL(readResponse)(pn532_packetbuffer, sizeof(pn532_packetbuffer));
+    int16_t status = HAL(readResponse)(pn532_packetbuffer, sizeof(pn532_packetbuffer), timeout);
     if (0 > status) {
         return 0;
     }
@@ -286,9 +298,11 @@ uint8_t PN532::readGPIO(void) {
 /**************************************************************************/
 /*!
     @brief  Configures the SAM (Secure Access Module)
+
+    @param  timeout   max time to wait for the response (ms)
 */
 /**************************************************************************/
-bool PN532::SAMConfig(void) {
+bool PN532::SAMConfig(uint16_t timeout) {
     pn532_packetbuffer[0] = PN532_COMMAND_SAMCONFIGURATION;
     pn532_packetbuffer[1] = 0x01; // normal mode;
     pn532_packetbuffer[2] = 0x14; // timeout 50ms * 20 = 1 second
@@ -300,7 +314,8 @@ bool PN532::SAMConfig(void) {
         return false;
     }
 
-    return (0 < HAL(readResponse)(pn532_packetbuffer, sizeof(pn532_packetbuffer)));
+    // the response has no data, its length is 0
+    return (0 <= HAL(readResponse)(pn532_packetbuffer, sizeof(pn532_packetbuffer), timeout));
 }
 
 /**************************************************************************/
@@ -374,14 +389,59 @@ bool PN532::setRFField(uint8_t autoRFCA, uint8_t rFOnOff) {
 */
 /**************************************************************************/
 bool PN532::readPassiveTargetID(uint8_t cardbaudrate, uint8_t* uid, uint8_t* uidLength, uint16_t timeout, bool inlist) {
+    if (!startPassiveTargetIDDetection(cardbaudrate)) {
+        return 0x0;  // command failed
+    }
+
+    return readDetectedPassiveTargetID(uid, uidLength, timeout, inlist);
+}
+
+/**************************************************************************/
+/*!
+    Asks the PN532 to wait for an ISO14443A target without waiting for
+    the response. Poll isResponseReady() and fetch the target with
+    readDetectedPassiveTargetID() afterwards.
+
+    @param  cardBaudRate  Baud rate of the card
+
+    @returns 1 if the command was acknowledged, 0 for an error
+*/
+/**************************************************************************/
+bool PN532::startPassiveTargetIDDetection(uint8_t cardbaudrate) {
     pn532_packetbuffer[0] = PN532_COMMAND_INLISTPASSIVETARGET;
     pn532_packetbuffer[1] = 1;  // max 1 cards at once (we can set this to 2 later)
     pn532_packetbuffer[2] = cardbaudrate;
 
-    if (HAL(writeCommand)(pn532_packetbuffer, 3)) {
-        return 0x0;  // command failed
-    }
+    return HAL(writeCommand)(pn532_packetbuffer, 3) == 0;
+}
+
+/**************************************************************************/
+/*!
+    Checks without blocking whether the response of the pending command
+    can be read
+
+    @returns 1 if the response is ready, 0 if the PN532 is still busy
+*/
+/**************************************************************************/
+bool PN532::isResponseReady() {
+    return HAL(available)();
+}
 
+/**************************************************************************/
+/*!
+    Reads the response of startPassiveTargetIDDetection()
+
+    @param  uid           Pointer to the array that will be populated
+                          with the card's UID (up to 7 bytes)
+    @param  uidLength     Pointer to the variable that will hold the
+                          length of the card's UID.
+    @param  timeout       The number of tries before timing out
+    @param  inlist        If set to true, the card will be inlisted
+
+    @returns 1 if a card was detected, 0 for an error
+*/
+/**************************************************************************/
+bool PN532::readDetectedPassiveTargetID(uint8_t* uid, uint8_t* uidLength, uint16_t timeout, bool inlist) {
     // read data packet
     if (HAL(readResponse)(pn532_packetbuffer, sizeof(pn532_packetbuffer), timeout) < 0) {
         return 0x0;
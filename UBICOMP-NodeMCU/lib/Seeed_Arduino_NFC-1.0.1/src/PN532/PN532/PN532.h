@@ -129,10 +129,11 @@ class PN532 {
     PN532(PN532Interface& interface);
 
     void begin(void);
+    void beginBus(void);
 
     // Generic PN532 functions
-    bool SAMConfig(void);
-    uint32_t getFirmwareVersion(void);
+    bool SAMConfig(uint16_t timeout = 1000);
+    uint32_t getFirmwareVersion(uint16_t timeout = 1000);
     uint32_t readRegister(uint16_t reg);
     uint32_t writeRegister(uint16_t reg, uint8_t val);
     bool writeGPIO(uint8_t pinstate);
@@ -159,6 +160,9 @@ class PN532 {
     bool inListPassiveTarget();
     bool readPassiveTargetID(uint8_t cardbaudrate, uint8_t* uid, uint8_t* uidLength, uint16_t timeout = 1000,
                              bool inlist = false);
+    bool startPassiveTargetIDDetection(uint8_t cardbaudrate);
+    bool isResponseReady();
+    bool readDetectedPassiveTargetID(uint8_t* uid, uint8_t* uidLength, uint16_t timeout = 1000, bool inlist = false);
     bool inDataExchange(uint8_t* send, uint8_t sendLength, uint8_t* response, uint8_t* responseLength);
 
     // Mifare Classic functions
@@ -49,6 +49,16 @@ class PN532Interface {
                 <0      failed to read response
     */
     virtual int16_t readResponse(uint8_t buf[], uint8_t len, uint16_t timeout = 1000) = 0;
+
+    /**
+        @brief    check without blocking whether the response of the last command is ready
+        @return   true    readResponse() will not have to wait for the PN532
+                false   the PN532 is still busy
+        @note     interfaces which can not poll the status report ready and block in readResponse()
+    */
+    virtual bool available() {
+        return true;
+    }
 };
 
 #endif
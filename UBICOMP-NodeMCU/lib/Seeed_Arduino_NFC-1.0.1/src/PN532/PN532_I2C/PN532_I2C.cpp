@@ -5,6 +5,8 @@
 #include "PN532/PN532_I2C/PN532_I2C.h"
 #include "PN532/PN532/PN532_debug.h"
 #include "Arduino.h"
+// Instrumentation points of the node firmware, compiled out without -D TRACING
+#include <Trace.h>
 
 #define PN532_I2C_ADDRESS (0x48 >> 1)
 
@@ -22,6 +24,13 @@ void PN532_I2C::wakeup() {
 }
 
 int8_t PN532_I2C::writeCommand(const uint8_t* header, uint8_t hlen, const uint8_t* body, uint8_t blen) {
+    TRACE_BEGIN(TRACE_PN532_WRITE, header[0], 0);
+    int8_t result = sendCommand(header, hlen, body, blen);
+    TRACE_END(TRACE_PN532_WRITE, header[0], result);
+    return result;
+}
+
+int8_t PN532_I2C::sendCommand(const uint8_t* header, uint8_t hlen, const uint8_t* body, uint8_t blen) {
     command = header[0];
     _wire->beginTransmission(PN532_I2C_ADDRESS);
 
@@ -86,7 +95,7 @@ int16_t PN532_I2C::getResponseLength(uint8_t buf[], uint8_t len, uint16_t timeou
         delay(1);
         time++;
         if ((0 != timeout) && (time > timeout)) {
-            return -1;
+            return PN532_TIMEOUT;
         }
     } while (1);
 
@@ -111,10 +120,21 @@ int16_t PN532_I2C::getResponseLength(uint8_t buf[], uint8_t len, uint16_t timeou
 }
 
 int16_t PN532_I2C::readResponse(uint8_t buf[], uint8_t len, uint16_t timeout) {
+    TRACE_BEGIN(TRACE_PN532_READ, command, 0);
+    int16_t result = receiveResponse(buf, len, timeout);
+    TRACE_END(TRACE_PN532_READ, command, result);
+    return result;
+}
+
+int16_t PN532_I2C::receiveResponse(uint8_t buf[], uint8_t len, uint16_t timeout) {
     uint16_t time = 0;
     uint8_t length;
 
-    length = getResponseLength(buf, len, timeout);
+    int16_t status = getResponseLength(buf, len, timeout);
+    if (status < 0) {
+        return status;
+    }
+    length = status;
 
     // [RDY] 00 00 FF LEN LCS (TFI PD0 ... PDn) DCS 00
     do {
@@ -179,6 +199,14 @@ int16_t PN532_I2C::readResponse(uint8_t buf[], uint8_t len, uint16_t timeout) {
     return length;
 }
 
+bool PN532_I2C::available() {
+    // a single status byte read does not consume the pending response frame
+    if (_wire->requestFrom(PN532_I2C_ADDRESS, 1)) {
+        return read() & 1;
+    }
+    return false;
+}
+
 int8_t PN532_I2C::readAckFrame() {
     const uint8_t PN532_ACK[] = {0, 0, 0xFF, 0, 0xFF, 0};
     uint8_t ackBuf[sizeof(PN532_ACK)];
@@ -16,11 +16,14 @@ class PN532_I2C : public PN532Interface {
     void wakeup();
     virtual int8_t writeCommand(const uint8_t* header, uint8_t hlen, const uint8_t* body = 0, uint8_t blen = 0);
     int16_t readResponse(uint8_t buf[], uint8_t len, uint16_t timeout);
+    bool available();
 
   private:
     TwoWire* _wire;
     uint8_t command;
 
+    int8_t sendCommand(const uint8_t* header, uint8_t hlen, const uint8_t* body, uint8_t blen);
+    int16_t receiveResponse(uint8_t buf[], uint8_t len, uint16_t timeout);
     int8_t readAckFrame();
     int16_t getResponseLength(uint8_t buf[], uint8_t len, uint16_t timeout);
 
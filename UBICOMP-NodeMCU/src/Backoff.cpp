@@ -0,0 +1,24 @@
+#include <Backoff.h>
+
+void initBackoff(t_backoff* backoff, uint32_t minDelay, uint32_t maxDelay) {
+  backoff->minDelay = minDelay;
+  backoff->maxDelay = maxDelay < minDelay ? minDelay : maxDelay;
+  backoff->attempt = 0;
+}
+
+uint32_t nextBackoff(t_backoff* backoff, uint32_t random) {
+  // Double until the maximum, without shifting the delay out of range
+  uint32_t delay = backoff->minDelay;
+  for(uint8_t i = 0; i < backoff->attempt && delay < backoff->maxDelay; i++) {
+    delay = delay > backoff->maxDelay / 2 ? backoff->maxDelay : delay * 2;
+  }
+  if(delay > backoff->maxDelay) {
+    delay = backoff->maxDelay;
+  }
+  if(backoff->attempt < UINT8_MAX) {
+    backoff->attempt++;
+  }
+
+  uint32_t half = delay / 2;
+  return delay - half + random % (half + 1);
+}
@@ -0,0 +1,296 @@
+#include <EventLog.h>
+
+#include <string.h>
+
+namespace {
+
+enum RecordStatus {
+  RECORD_VALID,    // complete record
+  RECORD_CORRUPT,  // its write was cut off, it's skipped by its length
+  RECORD_END       // no further record in this sector
+};
+
+uint32_t sectorOf(uint32_t offset) {
+  return offset - offset % LOG_SECTOR_SIZE;
+}
+
+// Records never start at the beginning of a sector, so the sector a record
+// offset belongs to is that of the byte before - even at the end of a sector
+uint32_t sectorOfRecord(uint32_t offset) {
+  return sectorOf(offset - 1);
+}
+
+uint32_t firstRecord(uint32_t sector) {
+  return sector + sizeof(t_log_sector_header);
+}
+
+uint32_t nextSector(const t_event_log* log, uint32_t sector) {
+  return (sector + LOG_SECTOR_SIZE) % log->flash->size;
+}
+
+size_t recordSize(size_t length) {
+  return sizeof(t_log_record_header) + ((length + 3) & ~(size_t) 3);
+}
+
+uint32_t recordCrc(uint16_t length, const void* data) {
+  uint8_t bytes[2] = { (uint8_t) length, (uint8_t) (length >> 8) };
+  return logCrc(logCrc(0, bytes, sizeof(bytes)), data, length);
+}
+
+bool readSectorHeader(const t_event_log* log, uint32_t sector, t_log_sector_header* header) {
+  return log->flash->read(log->flash->context, sector, header, sizeof(*header)) && header->magic == LOG_MAGIC;
+}
+
+/**
+ * @brief Reads and checks the record at an offset
+ *
+ * @param header filled with the header of the record
+ * @param payload buffer of LOG_RECORD_MAX_SIZE, filled with the payload
+ */
+RecordStatus readRecord(const t_event_log* log, uint32_t offset, t_log_record_header* header, uint8_t* payload) {
+  uint32_t end = sectorOfRecord(offset) + LOG_SECTOR_SIZE;
+  if(offset + sizeof(*header) > end || !log->flash->read(log->flash->context, offset, header, sizeof(*header))) {
+    return RECORD_END;
+  }
+  // Nothing written here, or a length that can't be skipped
+  if(header->length == 0xFFFF || header->length > LOG_RECORD_MAX_SIZE || offset + recordSize(header->length) > end) {
+    return RECORD_END;
+  }
+  if(!log->flash->read(log->flash->context, offset + sizeof(*header), payload, header->length)) {
+    return RECORD_END;
+  }
+  return recordCrc(header->length, payload) == header->crc ? RECORD_VALID : RECORD_CORRUPT;
+}
+
+/**
+ * @brief Erases a sector and makes it the one written to. Records in it
+ *        that weren't consumed yet are dropped
+ */
+bool startSector(t_event_log* log, uint32_t sector, uint32_t sequence) {
+  t_log_sector_header header;
+  if(readSectorHeader(log, sector, &header)) {
+    t_log_record_header record;
+    uint8_t payload[LOG_RECORD_MAX_SIZE];
+    uint32_t offset = firstRecord(sector);
+    RecordStatus status;
+    while((status = readRecord(log, offset, &record, payload)) != RECORD_END) {
+      if(status == RECORD_VALID && record.state == LOG_RECORD_PENDING && log->pending) {
+        log->pending--;
+        log->dropped++;
+      }
+      offset += recordSize(record.length);
+    }
+  }
+
+  // The oldest remaining records are those of the following sector
+  if(sectorOfRecord(log->readOffset) == sector) {
+    log->readOffset = log->pending ? firstRecord(nextSector(log, sector)) : firstRecord(sector);
+  }
+
+  if(!log->flash->erase(log->flash->context, sector)) {
+    return false;
+  }
+  // The magic is written last, a sector with a cut off header isn't used
+  header.sequence = sequence;
+  header.magic = LOG_MAGIC;
+  if(!log->flash->write(log->flash->context, sector + offsetof(t_log_sector_header, sequence), &header.sequence, sizeof(header.sequence)) ||
+     !log->flash->write(log->flash->context, sector + offsetof(t_log_sector_header, magic), &header.magic, sizeof(header.magic))) {
+    return false;
+  }
+
+  log->sequence = sequence;
+  log->writeOffset = firstRecord(sector);
+  log->pageOffset = log->writeOffset;
+  return true;
+}
+
+}  // namespace
+
+uint32_t logCrc(uint32_t crc, const void* data, size_t length) {
+  // Half-byte table, small enough to not need flash for a full table
+  static const uint32_t TABLE[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+  };
+  const uint8_t* bytes = (const uint8_t*) data;
+  crc = ~crc;
+  for(size_t i = 0; i < length; i++) {
+    crc = TABLE[(crc ^ bytes[i]) & 0x0F] ^ (crc >> 4);
+    crc = TABLE[(crc ^ (bytes[i] >> 4)) & 0x0F] ^ (crc >> 4);
+  }
+  return ~crc;
+}
+
+bool mountLog(t_event_log* log, const t_log_flash* flash) {
+  log->flash = flash;
+  log->sectors = flash->size / LOG_SECTOR_SIZE;
+  log->pageLength = 0;
+  log->pending = 0;
+  log->dropped = 0;
+  log->readOffset = 0;
+  if(log->sectors < 2) {
+    return false;
+  }
+
+  // The sector written last has the highest sequence
+  bool found = false;
+  uint32_t head = 0;
+  t_log_sector_header header;
+  for(uint32_t i = 0; i < log->sectors; i++) {
+    uint32_t sector = i * LOG_SECTOR_SIZE;
+    if(readSectorHeader(log, sector, &header) && (!found || (int32_t) (header.sequence - log->sequence) > 0)) {
+      found = true;
+      head = sector;
+      log->sequence = header.sequence;
+    }
+  }
+  if(!found) {
+    // Reading starts where the first record goes, also after the first sector
+    // was dropped on a wrap
+    if(!startSector(log, 0, 1)) {
+      return false;
+    }
+    log->readOffset = log->writeOffset;
+    return true;
+  }
+
+  // Sectors are written in turns, so the first one in use after the head
+  // is the oldest
+  uint32_t oldest = head;
+  for(uint32_t sector = nextSector(log, head); sector != head; sector = nextSector(log, sector)) {
+    if(readSectorHeader(log, sector, &header)) {
+      oldest = sector;
+      break;
+    }
+  }
+
+  bool readFound = false;
+  t_log_record_header record;
+  uint8_t payload[LOG_RECORD_MAX_SIZE];
+  for(uint32_t sector = oldest;; sector = nextSector(log, sector)) {
+    uint32_t offset = firstRecord(sector);
+    if(sector == head || readSectorHeader(log, sector, &header)) {
+      RecordStatus status;
+      while((status = readRecord(log, offset, &record, payload)) != RECORD_END) {
+        if(status == RECORD_VALID && record.state == LOG_RECORD_PENDING) {
+          log->pending++;
+          if(!readFound) {
+            readFound = true;
+            log->readOffset = offset;
+          }
+        }
+        offset += recordSize(record.length);
+      }
+    }
+    if(sector == head) {
+      // Anything that isn't erased after the last record can't be written
+      // to, the next record starts a new sector then
+      uint16_t next = 0;
+      uint32_t end = sector + LOG_SECTOR_SIZE;
+      if(offset + sizeof(next) <= end && (!flash->read(flash->context, offset, &next, sizeof(next)) || next != 0xFFFF)) {
+        offset = end;
+      }
+      log->writeOffset = offset;
+      break;
+    }
+  }
+
+  if(!readFound) {
+    log->readOffset = log->writeOffset;
+  }
+  log->pageOffset = log->writeOffset;
+  return true;
+}
+
+bool appendLog(t_event_log* log, const void* data, size_t length) {
+  if(!length || length > LOG_RECORD_MAX_SIZE) {
+    return false;
+  }
+  size_t size = recordSize(length);
+
+  uint32_t sector = sectorOfRecord(log->writeOffset);
+  if(log->writeOffset + size > sector + LOG_SECTOR_SIZE) {
+    if(!flushLog(log) || !startSector(log, nextSector(log, sector), log->sequence + 1)) {
+      return false;
+    }
+  }
+  if(log->pageLength + size > LOG_PAGE_SIZE && !flushLog(log)) {
+    return false;
+  }
+
+  t_log_record_header header;
+  header.length = length;
+  header.state = LOG_RECORD_PENDING;
+  header.crc = recordCrc(length, data);
+
+  uint8_t* record = log->page + log->pageLength;
+  memset(record, 0xFF, size);
+  memcpy(record, &header, sizeof(header));
+  memcpy(record + sizeof(header), data, length);
+  log->pageLength += size;
+  log->writeOffset += size;
+  log->pending++;
+  return true;
+}
+
+bool flushLog(t_event_log* log) {
+  if(log->pageLength) {
+    if(!log->flash->write(log->flash->context, log->pageOffset, log->page, log->pageLength)) {
+      return false;
+    }
+    log->pageLength = 0;
+  }
+  log->pageOffset = log->writeOffset;
+  return true;
+}
+
+uint32_t startLogRead(t_event_log* log) {
+  flushLog(log);
+  return log->readOffset;
+}
+
+size_t readLog(t_event_log* log, uint32_t* cursor, void* data, size_t size) {
+  t_log_record_header header;
+  uint8_t payload[LOG_RECORD_MAX_SIZE];
+  // Each sector is passed at most once
+  uint32_t sectors = 0;
+  while(*cursor != log->writeOffset && sectors <= log->sectors) {
+    RecordStatus status = readRecord(log, *cursor, &header, payload);
+    if(status == RECORD_END) {
+      *cursor = firstRecord(nextSector(log, sectorOfRecord(*cursor)));
+      sectors++;
+      continue;
+    }
+    *cursor += recordSize(header.length);
+    if(status == RECORD_VALID && header.state == LOG_RECORD_PENDING) {
+      memcpy(data, payload, header.length < size ? header.length : size);
+      return header.length;
+    }
+  }
+  return 0;
+}
+
+void consumeLog(t_event_log* log, uint32_t cursor) {
+  t_log_record_header header;
+  uint8_t payload[LOG_RECORD_MAX_SIZE];
+  const uint16_t consumed = LOG_RECORD_CONSUMED;
+  uint32_t offset = log->readOffset;
+  uint32_t sectors = 0;
+  while(offset != cursor && sectors <= log->sectors) {
+    RecordStatus status = readRecord(log, offset, &header, payload);
+    if(status == RECORD_END) {
+      offset = firstRecord(nextSector(log, sectorOfRecord(offset)));
+      sectors++;
+      continue;
+    }
+    if(status == RECORD_VALID && header.state == LOG_RECORD_PENDING) {
+      // Clearing bits needs no erase
+      log->flash->write(log->flash->context, offset + offsetof(t_log_record_header, state), &consumed, sizeof(consumed));
+      if(log->pending) {
+        log->pending--;
+      }
+    }
+    offset += recordSize(header.length);
+  }
+  log->readOffset = cursor;
+}
@@ -0,0 +1,49 @@
+#include <I2cBus.h>
+
+I2cBus::I2cBus(TwoWire& wire) : bus(wire), mutex(NULL), highWaiting(0), acquired(0), count(0) {}
+
+void I2cBus::begin() {
+  mutex = xSemaphoreCreateMutex();
+  bus.begin();
+}
+
+t_i2c_device* I2cBus::addDevice(const char* name, I2cPriority priority) {
+  if(count >= I2C_MAX_DEVICES) {
+    return NULL;
+  }
+  t_i2c_device* device = &deviceTable[count++];
+  device->name = name;
+  device->priority = priority;
+  device->transactions = 0;
+  device->busy = 0;
+  device->wait = 0;
+  return device;
+}
+
+void I2cBus::acquire(t_i2c_device* device) {
+  uint32_t start = micros();
+  if(device->priority == I2C_PRIORITY_HIGH) {
+    highWaiting++;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    highWaiting--;
+  } else {
+    // Low priority transactions hand the bus over right away while a high
+    // priority one is pending, and try again a tick later
+    for(;;) {
+      xSemaphoreTake(mutex, portMAX_DELAY);
+      if(!highWaiting) {
+        break;
+      }
+      xSemaphoreGive(mutex);
+      vTaskDelay(1);
+    }
+  }
+  acquired = micros();
+  device->wait += acquired - start;
+}
+
+void I2cBus::release(t_i2c_device* device) {
+  device->transactions++;
+  device->busy += micros() - acquired;
+  xSemaphoreGive(mutex);
+}
@@ -0,0 +1,7 @@
+#include <IRCodes.h>
+
+// The one definition of the tables the header declares
+constexpr t_ir_code IRCodes::CODES[];
+constexpr uint8_t IRCodes::COUNT;
+constexpr uint32_t IRCodes::HASH_SEED;
+constexpr t_ir_hash_table IRCodes::HASH_TABLE;
@@ -0,0 +1,21 @@
+#include <LatencyHistogram.h>
+
+void takeLatencyInterval(const t_latency_histogram* live, t_latency_histogram* reported, t_latency_histogram* interval) {
+  for(size_t i = 0; i < LATENCY_BUCKETS; i++) {
+    // A single read, the measuring task may count on meanwhile
+    uint32_t count = live->buckets[i];
+    interval->buckets[i] = count - reported->buckets[i];
+    reported->buckets[i] = count;
+  }
+  uint32_t sum = live->sum;
+  interval->sum = sum - reported->sum;
+  reported->sum = sum;
+}
+
+size_t usedLatencyBuckets(const t_latency_histogram* histogram) {
+  size_t used = LATENCY_BUCKETS;
+  while(used > 0 && histogram->buckets[used - 1] == 0) {
+    used--;
+  }
+  return used;
+}
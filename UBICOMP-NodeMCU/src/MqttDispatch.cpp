@@ -0,0 +1,88 @@
+#include <MqttDispatch.h>
+
+#include <string.h>
+
+namespace {
+
+// FNV-1a, also measures the topic on the way
+uint32_t hashTopic(const char* topic, size_t* length) {
+  uint32_t hash = 2166136261u;
+  size_t i = 0;
+  for(; topic[i]; i++) {
+    hash ^= (uint8_t) topic[i];
+    hash *= 16777619u;
+  }
+  *length = i;
+  return hash;
+}
+
+}
+
+bool registerTopic(t_topic_dispatch* dispatch, const char* topic, uint8_t id) {
+  if(dispatch->count == MQTT_MAX_ROUTES) {
+    return false;
+  }
+  size_t length;
+  t_topic_route* route = &dispatch->routes[dispatch->count++];
+  route->hash = hashTopic(topic, &length);
+  route->length = length;
+  route->id = id;
+  route->topic = topic;
+  return true;
+}
+
+uint8_t dispatchTopic(const t_topic_dispatch* dispatch, const char* topic) {
+  size_t length;
+  uint32_t hash = hashTopic(topic, &length);
+  for(uint8_t i = 0; i < dispatch->count; i++) {
+    const t_topic_route* route = &dispatch->routes[i];
+    if(route->hash == hash && route->length == length && memcmp(route->topic, topic, length) == 0) {
+      return route->id;
+    }
+  }
+  return TOPIC_UNKNOWN;
+}
+
+void resetAssembler(t_payload_assembler* assembler) {
+  assembler->received = 0;
+  assembler->total = 0;
+  assembler->discarding = false;
+}
+
+char* assemblePayload(t_payload_assembler* assembler, const char* payload, size_t len, size_t index, size_t total) {
+  if(index == 0) {
+    // The last chunks of the message before never arrived
+    if(assembler->total) {
+      assembler->dropped++;
+    }
+    resetAssembler(assembler);
+    if(total > MQTT_PAYLOAD_MAX_SIZE || len > total) {
+      assembler->dropped++;
+      assembler->discarding = true;
+      return NULL;
+    }
+    assembler->total = total;
+  } else if(assembler->total == 0) {
+    // Rest of a dropped message, or one whose first chunk never arrived
+    if(!assembler->discarding) {
+      assembler->dropped++;
+      assembler->discarding = true;
+    }
+    return NULL;
+  } else if(index != assembler->received || total != assembler->total || index + len > total) {
+    resetAssembler(assembler);
+    assembler->dropped++;
+    assembler->discarding = true;
+    return NULL;
+  }
+
+  memcpy(assembler->buffer + index, payload, len);
+  assembler->received += len;
+  if(assembler->received < assembler->total) {
+    return NULL;
+  }
+
+  assembler->buffer[assembler->total] = '\0';
+  resetAssembler(assembler);
+  return assembler->buffer;
+}
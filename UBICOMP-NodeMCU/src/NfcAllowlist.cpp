@@ -0,0 +1,140 @@
+#include <NfcAllowlist.h>
+
+namespace {
+
+// Finalizer of MurmurHash3, spreads the UID bytes over the slot bits
+size_t slotOf(uint64_t key, uint64_t seed) {
+  key ^= seed;
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ULL;
+  key ^= key >> 33;
+  return key & (NFC_ALLOWLIST_SLOTS - 1);
+}
+
+// Puts a new key into the probe window of its slot
+bool placeTag(t_nfc_allowlist* list, uint64_t key, uint8_t action) {
+  size_t slot = slotOf(key, list->seed);
+  for(size_t probe = 0; probe < NFC_ALLOWLIST_MAX_PROBE; probe++) {
+    size_t i = (slot + probe) & (NFC_ALLOWLIST_SLOTS - 1);
+    if(list->keys[i] == 0) {
+      list->keys[i] = key;
+      list->actions[i] = action;
+      list->count++;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Places the tags of previous and the new one with the next seeds until all
+// of them fit
+bool rehashAllowlist(t_nfc_allowlist* list, const t_nfc_allowlist* previous, uint64_t key, uint8_t action) {
+  uint64_t seed = previous->seed;
+  for(size_t attempt = 0; attempt < NFC_ALLOWLIST_MAX_SEEDS; attempt++) {
+    seed += 0x9e3779b97f4a7c15ULL;
+    clearAllowlist(list);
+    list->seed = seed;
+    bool placed = placeTag(list, key, action);
+    for(size_t i = 0; placed && i < NFC_ALLOWLIST_SLOTS; i++) {
+      if(previous->keys[i] != 0) {
+        placed = placeTag(list, previous->keys[i], previous->actions[i]);
+      }
+    }
+    if(placed) {
+      return true;
+    }
+  }
+  *list = *previous;
+  return false;
+}
+
+}
+
+void clearAllowlist(t_nfc_allowlist* list) {
+  for(size_t i = 0; i < NFC_ALLOWLIST_SLOTS; i++) {
+    list->keys[i] = 0;
+  }
+  list->count = 0;
+  list->seed = 0;
+}
+
+uint64_t packNfcUid(const uint8_t* uid, uint8_t uidLength) {
+  if(uidLength == 0 || uidLength > NFC_UID_MAX_LENGTH) {
+    return 0;
+  }
+  uint64_t key = (uint64_t) uidLength << 56;
+  for(uint8_t i = 0; i < uidLength; i++) {
+    key |= (uint64_t) uid[i] << (8 * i);
+  }
+  return key;
+}
+
+bool addAllowlistTag(t_nfc_allowlist* list, const uint8_t* uid, uint8_t uidLength, uint8_t action) {
+  uint64_t key = packNfcUid(uid, uidLength);
+  if(key == 0) {
+    return false;
+  }
+
+  size_t slot = slotOf(key, list->seed);
+  for(size_t probe = 0; probe < NFC_ALLOWLIST_MAX_PROBE; probe++) {
+    size_t i = (slot + probe) & (NFC_ALLOWLIST_SLOTS - 1);
+    if(list->keys[i] == key) {
+      list->actions[i] = action;
+      return true;
+    }
+  }
+  if(list->count == NFC_ALLOWLIST_MAX_TAGS) {
+    return false;
+  }
+  if(placeTag(list, key, action)) {
+    return true;
+  }
+
+  // The window is taken, lookups stay at a fixed window so everything moves
+  t_nfc_allowlist previous = *list;
+  return rehashAllowlist(list, &previous, key, action);
+}
+
+uint8_t matchAllowlist(const t_nfc_allowlist* list, const uint8_t* uid, uint8_t uidLength, uint8_t fallback) {
+  uint64_t key = packNfcUid(uid, uidLength);
+  size_t slot = slotOf(key, list->seed);
+
+  // Keys are unique, so at most one slot of the window matches. A miss ORs
+  // in nothing, a hit ORs in the action and clears the fallback
+  uint32_t action = 0;
+  uint32_t found = 0;
+  for(size_t probe = 0; probe < NFC_ALLOWLIST_MAX_PROBE; probe++) {
+    size_t i = (slot + probe) & (NFC_ALLOWLIST_SLOTS - 1);
+    uint64_t diff = list->keys[i] ^ key;
+    uint32_t mask = (uint32_t) 0 - (uint32_t) (((diff | (0 - diff)) >> 63) ^ 1);
+    action |= list->actions[i] & mask;
+    found |= mask;
+  }
+  // An empty UID packs to 0 and would match empty slots
+  found &= (uint32_t) 0 - (uint32_t) (key != 0);
+  action &= found;
+  return (uint8_t) (action | (fallback & ~found));
+}
+
+void initTagRateLimiter(t_tag_rate_limiter* limiter, uint8_t burst, uint32_t interval, uint32_t now) {
+  limiter->burst = burst;
+  limiter->interval = interval;
+  limiter->tokens = burst;
+  limiter->lastRefill = now;
+}
+
+bool allowUnknownTag(t_tag_rate_limiter* limiter, uint32_t now) {
+  uint32_t regained = (now - limiter->lastRefill) / limiter->interval;
+  if(regained > 0) {
+    uint32_t tokens = limiter->tokens + regained;
+    limiter->tokens = tokens > limiter->burst ? limiter->burst : tokens;
+    limiter->lastRefill += regained * limiter->interval;
+  }
+  if(limiter->tokens == 0) {
+    return false;
+  }
+  limiter->tokens--;
+  return true;
+}
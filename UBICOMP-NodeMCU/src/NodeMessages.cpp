@@ -0,0 +1,89 @@
+#include <NodeMessages.h>
+
+#include <string.h>
+
+namespace {
+
+bool addIRRules(t_node_rules* rules, JsonArrayConst codes, RuleAction action) {
+  bool complete = true;
+  for(JsonVariantConst code : codes) {
+    complete &= code.is<uint32_t>() && addIRRule(rules, code.as<uint32_t>(), action);
+  }
+  return complete;
+}
+
+int hexDigit(char c) {
+  if(c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if(c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if(c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+}
+
+CommandResult readCommand(JsonVariantConst message, CommandScope scope, const char* node, uint16_t index,
+                          t_node_command* command) {
+  // Am I affected? Every member of a group is
+  if(scope == SCOPE_NODE && strcmp(message["node"] | "", node) != 0) {
+    return COMMAND_NOT_ADDRESSED;
+  }
+  if(scope == SCOPE_BROADCAST && !isBroadcastTarget(message["nodes"], index)) {
+    return COMMAND_NOT_ADDRESSED;
+  }
+
+  JsonVariantConst value = message["command"];
+  if(!value.is<int>() || value.as<int>() < DISABLE || value.as<int>() > TOGGLE) {
+    return COMMAND_INVALID;
+  }
+  command->command = (Command) value.as<int>();
+  return COMMAND_ACCEPTED;
+}
+
+bool isBroadcastTarget(JsonVariantConst nodes, uint16_t index) {
+  // Nodes past the bitset are never addressed by broadcasts
+  if(index >= BROADCAST_MAX_NODES) {
+    return false;
+  }
+  if(nodes.is<JsonArrayConst>()) {
+    for(JsonVariantConst node : nodes.as<JsonArrayConst>()) {
+      if(node.is<uint16_t>() && node.as<uint16_t>() == index) {
+        return true;
+      }
+    }
+    return false;
+  }
+  if(nodes.is<const char*>()) {
+    // Each digit holds four nodes, the last one the first four
+    const char* digits = nodes.as<const char*>();
+    size_t length = strlen(digits);
+    if(index / 4 >= length) {
+      return false;
+    }
+    int digit = hexDigit(digits[length - 1 - index / 4]);
+    return digit >= 0 && ((digit >> (index % 4)) & 1);
+  }
+  return index < 32 && ((nodes.as<uint32_t>() >> index) & 1);
+}
+
+bool readRules(JsonVariantConst config, t_node_rules* rules) {
+  clearRules(rules);
+
+  bool complete = true;
+  complete &= addIRRules(rules, config["ir"]["toggle"].as<JsonArrayConst>(), RULE_TOGGLE);
+  complete &= addIRRules(rules, config["ir"]["on"].as<JsonArrayConst>(), RULE_ENABLE);
+  complete &= addIRRules(rules, config["ir"]["off"].as<JsonArrayConst>(), RULE_DISABLE);
+  // Read first, so a tag listed as both keeps its rule
+  for(JsonVariantConst uid : config["nfc"]["known"].as<JsonArrayConst>()) {
+    complete &= uid.is<const char*>() && addNfcRule(rules, uid.as<const char*>(), RULE_KNOWN);
+  }
+  for(JsonVariantConst uid : config["nfc"]["toggle"].as<JsonArrayConst>()) {
+    complete &= uid.is<const char*>() && addNfcRule(rules, uid.as<const char*>(), RULE_TOGGLE);
+  }
+  return complete;
+}
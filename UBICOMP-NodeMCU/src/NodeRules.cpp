@@ -0,0 +1,101 @@
+#include <NodeRules.h>
+
+#include <string.h>
+
+namespace {
+
+int hexValue(char c) {
+  if(c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if(c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  if(c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+}
+
+void clearRules(t_node_rules* rules) {
+  rules->irCount = 0;
+  clearAllowlist(&rules->nfc);
+}
+
+bool addIRRule(t_node_rules* rules, uint32_t code, RuleAction action) {
+  // Find the insert position, keeping the array sorted
+  uint8_t position = 0;
+  while(position < rules->irCount && rules->ir[position].code < code) {
+    position++;
+  }
+  if(position < rules->irCount && rules->ir[position].code == code) {
+    rules->ir[position].action = action;
+    return true;
+  }
+  if(rules->irCount == RULES_MAX_IR) {
+    return false;
+  }
+
+  memmove(&rules->ir[position + 1], &rules->ir[position], (rules->irCount - position) * sizeof(t_ir_rule));
+  rules->ir[position].code = code;
+  rules->ir[position].action = action;
+  rules->irCount++;
+  return true;
+}
+
+bool addNfcRule(t_node_rules* rules, const char* text, RuleAction action) {
+  uint8_t uid[NFC_UID_MAX_LENGTH];
+  uint8_t uidLength;
+  if(!parseNfcUid(text, uid, &uidLength)) {
+    return false;
+  }
+  return addAllowlistTag(&rules->nfc, uid, uidLength, action);
+}
+
+RuleAction matchIRRule(const t_node_rules* rules, uint32_t code) {
+  int low = 0;
+  int high = rules->irCount - 1;
+  while(low <= high) {
+    int middle = (low + high) / 2;
+    uint32_t other = rules->ir[middle].code;
+    if(other == code) {
+      return rules->ir[middle].action;
+    }
+    if(other < code) {
+      low = middle + 1;
+    } else {
+      high = middle - 1;
+    }
+  }
+  return RULE_NONE;
+}
+
+RuleAction matchNfcRule(const t_node_rules* rules, const t_nfc_data* nfc) {
+  return (RuleAction) matchAllowlist(&rules->nfc, nfc->uid, nfc->uidLength, RULE_NONE);
+}
+
+bool parseNfcUid(const char* text, uint8_t* uid, uint8_t* uidLength) {
+  uint8_t length = 0;
+  while(*text) {
+    int high = hexValue(text[0]);
+    int low = high < 0 ? -1 : hexValue(text[1]);
+    if(low < 0 || length == NFC_UID_MAX_LENGTH) {
+      return false;
+    }
+    uid[length++] = (high << 4) | low;
+    text += 2;
+
+    if(*text == ':') {
+      text++;
+      if(!*text) {
+        return false;
+      }
+    } else if(*text) {
+      return false;
+    }
+  }
+  *uidLength = length;
+  return length > 0;
+}
@@ -0,0 +1,95 @@
+#include <Scheduler.h>
+
+namespace {
+
+// Wrap-safe "a is before b"
+bool before(uint32_t a, uint32_t b) {
+  return (int32_t) (a - b) < 0;
+}
+
+}  // namespace
+
+void initScheduler(t_scheduler* scheduler) {
+  scheduler->count = 0;
+  scheduler->utilization = 0;
+}
+
+int addScheduledTask(t_scheduler* scheduler, const char* name, t_task_function run, uint32_t period, uint32_t budget, uint32_t now) {
+  if(scheduler->count >= SCHEDULER_MAX_TASKS || !period || budget > period) {
+    return -1;
+  }
+  uint32_t utilization = (uint32_t) ((uint64_t) budget * 1000 / period);
+  if(scheduler->utilization + utilization > 1000) {
+    return -1;
+  }
+  // Tasks aren't preempted, one that runs longer than the period of another
+  // makes that one miss its deadline no matter the order
+  for(uint8_t i = 0; i < scheduler->count; i++) {
+    if(budget > scheduler->tasks[i].period || scheduler->tasks[i].budget > period) {
+      return -1;
+    }
+  }
+  scheduler->utilization += utilization;
+
+  t_scheduled_task* task = &scheduler->tasks[scheduler->count];
+  task->name = name;
+  task->run = run;
+  task->period = period;
+  task->budget = budget;
+  task->release = now;
+  task->runs = 0;
+  task->misses = 0;
+  task->overruns = 0;
+  return scheduler->count++;
+}
+
+int nextScheduledTask(const t_scheduler* scheduler, uint32_t now) {
+  int next = -1;
+  for(uint8_t i = 0; i < scheduler->count; i++) {
+    const t_scheduled_task* task = &scheduler->tasks[i];
+    if(before(now, task->release)) {
+      continue;
+    }
+    // Deadlines are release + period
+    if(next < 0 || before(task->release + task->period, scheduler->tasks[next].release + scheduler->tasks[next].period)) {
+      next = i;
+    }
+  }
+  return next;
+}
+
+uint32_t runScheduler(t_scheduler* scheduler, t_scheduler_clock clock) {
+  uint32_t start = clock();
+  int next = nextScheduledTask(scheduler, start);
+  if(next < 0) {
+    uint32_t idle = UINT32_MAX;
+    for(uint8_t i = 0; i < scheduler->count; i++) {
+      uint32_t until = scheduler->tasks[i].release - start;
+      idle = until < idle ? until : idle;
+    }
+    return idle;
+  }
+
+  t_scheduled_task* task = &scheduler->tasks[next];
+  task->run();
+  uint32_t end = clock();
+
+  task->runs++;
+  if(end - start > task->budget) {
+    task->overruns++;
+  }
+  uint32_t deadline = task->release + task->period;
+  if(before(deadline, end)) {
+    task->misses++;
+  }
+
+  // The next release is the deadline of this one. Whole periods that already
+  // passed are skipped instead of being caught up on in a burst
+  task->release = deadline;
+  if(!before(end, task->release)) {
+    uint32_t behind = (end - task->release) / task->period;
+    task->misses += behind;
+    task->release += behind * task->period;
+  }
+  return 0;
+}
@@ -0,0 +1,329 @@
+#include <SensorJson.h>
+
+#include <string.h>
+
+namespace {
+
+// Appends to a fixed buffer and remembers if anything didn't fit
+class JsonBuffer {
+public:
+  JsonBuffer(char* out, size_t size) : out(out), size(size), length(0), overflow(size == 0) {}
+
+  void raw(const char* text) {
+    while(*text) {
+      put(*text++);
+    }
+  }
+
+  void number(uint32_t value) {
+    // Digits are produced backwards, 10 is the most a uint32_t needs
+    char digits[10];
+    uint8_t count = 0;
+    do {
+      digits[count++] = '0' + value % 10;
+      value /= 10;
+    } while(value);
+    while(count) {
+      put(digits[--count]);
+    }
+  }
+
+  void string(const char* text) {
+    put('"');
+    while(*text) {
+      if(*text == '"' || *text == '\\') {
+        put('\\');
+      }
+      put(*text++);
+    }
+    put('"');
+  }
+
+  size_t finish() {
+    if(overflow || length >= size) {
+      if(size) {
+        out[0] = '\0';
+      }
+      return 0;
+    }
+    out[length] = '\0';
+    return length;
+  }
+
+private:
+  void put(char c) {
+    // Keep one byte for the terminator
+    if(length + 1 >= size) {
+      overflow = true;
+      return;
+    }
+    out[length++] = c;
+  }
+
+  char* out;
+  size_t size;
+  size_t length;
+  bool overflow;
+};
+
+// Tells the coordinator which command a local rule already executed
+void actionField(JsonBuffer& json, uint8_t action) {
+  if(action != SENSOR_NO_ACTION) {
+    json.raw(",\"action\":");
+    json.number(action);
+  }
+}
+
+void irFields(JsonBuffer& json, const t_ir_data* ir) {
+  json.raw("\"code\":");
+  json.number(ir->code);
+  json.raw(",\"command\":");
+  json.number(ir->command);
+
+  // Only known codes resolve to a button of the remote
+  const t_ir_code* button = lookupIRCode(ir->code);
+  if(button) {
+    json.raw(",\"button\":");
+    json.string(button->name);
+  }
+  actionField(json, ir->action);
+}
+
+void soundFields(JsonBuffer& json, const t_sound_data* sound) {
+  json.raw("\"rms\":");
+  json.number(sound->rms);
+  json.raw(",\"peak\":");
+  json.number(sound->peak);
+  json.raw(",\"envelope\":");
+  json.number(sound->envelope);
+}
+
+void nfcFields(JsonBuffer& json, const t_nfc_data* nfc) {
+  char uid[NFC_UID_STRING_LENGTH];
+  formatNfcUid(nfc, uid);
+
+  json.raw("\"uid\":");
+  json.string(uid);
+  json.raw(",\"type\":");
+  json.string(nfcTagTypeName(nfc));
+  actionField(json, nfc->action);
+}
+
+void acousticFields(JsonBuffer& json, const t_acoustic_data* acoustic) {
+  json.raw("\"event\":");
+  json.string(acoustic->kind == ACOUSTIC_CLAP ? "clap" : "loud");
+  json.raw(",\"onset\":");
+  json.number(acoustic->onset);
+  json.raw(",\"peak\":");
+  json.number(acoustic->peak);
+  json.raw(",\"duration\":");
+  json.number(acoustic->duration);
+}
+
+}
+
+size_t writeIrJson(char* out, size_t size, const t_ir_data* ir) {
+  JsonBuffer json(out, size);
+  json.raw("{");
+  irFields(json, ir);
+  json.raw("}");
+  return json.finish();
+}
+
+size_t writeSoundJson(char* out, size_t size, const t_sound_data* sound) {
+  JsonBuffer json(out, size);
+  json.raw("{");
+  soundFields(json, sound);
+  json.raw("}");
+  return json.finish();
+}
+
+size_t writeNfcJson(char* out, size_t size, const t_nfc_data* nfc) {
+  JsonBuffer json(out, size);
+  json.raw("{");
+  nfcFields(json, nfc);
+  json.raw("}");
+  return json.finish();
+}
+
+size_t writeAcousticJson(char* out, size_t size, const t_acoustic_data* acoustic) {
+  JsonBuffer json(out, size);
+  json.raw("{");
+  acousticFields(json, acoustic);
+  json.raw("}");
+  return json.finish();
+}
+
+size_t writeStateJson(char* out, size_t size, uint8_t state, const char* node) {
+  JsonBuffer json(out, size);
+  json.raw("{\"state\":");
+  json.number(state);
+  json.raw(",\"node\":");
+  json.string(node);
+  json.raw("}");
+  return json.finish();
+}
+
+size_t writeBatchJson(char* out, size_t size, const t_sensor_event* events, size_t count) {
+  JsonBuffer json(out, size);
+  json.raw("[");
+  for(size_t i = 0; i < count; i++) {
+    const t_sensor_event* event = &events[i];
+    if(i > 0) {
+      json.raw(",");
+    }
+    json.raw("{\"sensor\":");
+    switch (event->type)
+    {
+      case SENSOR_IR:
+        json.string("ir");
+        break;
+      case SENSOR_SOUND:
+        json.string("sound");
+        break;
+      case SENSOR_NFC:
+        json.string("nfc");
+        break;
+      case SENSOR_ACOUSTIC:
+        json.string("acoustic");
+        break;
+    }
+    json.raw(",\"timestamp\":");
+    json.number(event->timestamp);
+    json.raw(",");
+    switch (event->type)
+    {
+      case SENSOR_IR:
+        irFields(json, &event->ir);
+        break;
+      case SENSOR_SOUND:
+        soundFields(json, &event->sound);
+        break;
+      case SENSOR_NFC:
+        nfcFields(json, &event->nfc);
+        break;
+      case SENSOR_ACOUSTIC:
+        acousticFields(json, &event->acoustic);
+        break;
+    }
+    json.raw("}");
+  }
+  json.raw("]");
+  return json.finish();
+}
+
+size_t writeMetricsJson(char* out, size_t size, uint32_t interval, const t_latency_histogram* histograms, const char* const* names, size_t count) {
+  JsonBuffer json(out, size);
+  json.raw("{\"interval\":");
+  json.number(interval);
+  for(size_t i = 0; i < count; i++) {
+    const t_latency_histogram* histogram = &histograms[i];
+    json.raw(",");
+    json.string(names[i]);
+    json.raw(":{\"sum\":");
+    json.number(histogram->sum);
+    json.raw(",\"buckets\":[");
+    size_t used = usedLatencyBuckets(histogram);
+    for(size_t bucket = 0; bucket < used; bucket++) {
+      if(bucket > 0) {
+        json.raw(",");
+      }
+      json.number(histogram->buckets[bucket]);
+    }
+    json.raw("]}");
+  }
+  json.raw("}");
+  return json.finish();
+}
+
+size_t writeBootJson(char* out, size_t size, const char* build, const uint32_t* times, const char* const* names, size_t count) {
+  JsonBuffer json(out, size);
+  json.raw("{\"build\":");
+  json.string(build);
+  for(size_t i = 0; i < count; i++) {
+    json.raw(",");
+    json.string(names[i]);
+    json.raw(":");
+    if(times[i]) {
+      json.number(times[i]);
+    } else {
+      json.raw("null");
+    }
+  }
+  json.raw("}");
+  return json.finish();
+}
+
+size_t writeDroppedJson(char* out, size_t size, uint32_t dropped) {
+  JsonBuffer json(out, size);
+  json.raw("{\"dropped\":");
+  json.number(dropped);
+  json.raw("}");
+  return json.finish();
+}
+
+size_t writeScheduleJson(char* out, size_t size, const t_scheduled_task* tasks, size_t count) {
+  JsonBuffer json(out, size);
+  json.raw("{");
+  for(size_t i = 0; i < count; i++) {
+    const t_scheduled_task* task = &tasks[i];
+    if(i > 0) {
+      json.raw(",");
+    }
+    json.string(task->name);
+    json.raw(":{\"period\":");
+    json.number(task->period);
+    json.raw(",\"budget\":");
+    json.number(task->budget);
+    json.raw(",\"runs\":");
+    json.number(task->runs);
+    json.raw(",\"misses\":");
+    json.number(task->misses);
+    json.raw(",\"overruns\":");
+    json.number(task->overruns);
+    json.raw("}");
+  }
+  json.raw("}");
+  return json.finish();
+}
+
+size_t writeBusJson(char* out, size_t size, const t_i2c_device* devices, size_t count) {
+  JsonBuffer json(out, size);
+  json.raw("{");
+  for(size_t i = 0; i < count; i++) {
+    const t_i2c_device* device = &devices[i];
+    if(i > 0) {
+      json.raw(",");
+    }
+    json.string(device->name);
+    json.raw(":{\"transactions\":");
+    json.number(device->transactions);
+    json.raw(",\"busy\":");
+    json.number(device->busy);
+    json.raw(",\"wait\":");
+    json.number(device->wait);
+    json.raw("}");
+  }
+  json.raw("}");
+  return json.finish();
+}
+
+void formatNfcUid(const t_nfc_data* nfc, char* out) {
+  static const char HEX_DIGITS[] = "0123456789ABCDEF";
+  char* cursor = out;
+  for(uint8_t i = 0; i < nfc->uidLength && i < NFC_UID_MAX_LENGTH; i++) {
+    if(i > 0) {
+      *cursor++ = ':';
+    }
+    *cursor++ = HEX_DIGITS[nfc->uid[i] >> 4];
+    *cursor++ = HEX_DIGITS[nfc->uid[i] & 0x0F];
+  }
+  *cursor = '\0';
+}
+
+const char* nfcTagTypeName(const t_nfc_data* nfc) {
+  if(nfc->tagType == NFC_TAG_TYPE_MIFARE_CLASSIC) {
+    return "Mifare Classic";
+  }
+  return "NFC Forum Type 2";
+}
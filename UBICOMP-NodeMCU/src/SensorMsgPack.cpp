@@ -0,0 +1,270 @@
+#include <SensorMsgPack.h>
+
+#include <string.h>
+
+namespace {
+
+// Appends MessagePack to a fixed buffer and remembers if anything didn't fit
+class MsgPackBuffer {
+public:
+  MsgPackBuffer(uint8_t* out, size_t size) : out(out), size(size), length(0), overflow(false) {}
+
+  void array(size_t count) {
+    if(count < 16) {
+      put(0x90 | count);
+    } else {
+      put(0xdc);
+      put(count >> 8);
+      put(count);
+    }
+  }
+
+  void number(uint32_t value) {
+    if(value < 0x80) {
+      put(value);
+    } else if(value <= 0xff) {
+      put(0xcc);
+      put(value);
+    } else if(value <= 0xffff) {
+      put(0xcd);
+      put(value >> 8);
+      put(value);
+    } else {
+      put(0xce);
+      put(value >> 24);
+      put(value >> 16);
+      put(value >> 8);
+      put(value);
+    }
+  }
+
+  void nil() {
+    put(0xc0);
+  }
+
+  void bin(const uint8_t* data, uint8_t count) {
+    put(0xc4);
+    put(count);
+    for(uint8_t i = 0; i < count; i++) {
+      put(data[i]);
+    }
+  }
+
+  void string(const char* text) {
+    size_t count = strlen(text);
+    if(count < 32) {
+      put(0xa0 | count);
+    } else {
+      put(0xd9);
+      put(count > 0xff ? 0xff : count);
+    }
+    for(size_t i = 0; i < count && i < 0xff; i++) {
+      put(text[i]);
+    }
+  }
+
+  size_t finish() {
+    return overflow ? 0 : length;
+  }
+
+private:
+  void put(uint8_t byte) {
+    if(length >= size) {
+      overflow = true;
+      return;
+    }
+    out[length++] = byte;
+  }
+
+  uint8_t* out;
+  size_t size;
+  size_t length;
+  bool overflow;
+};
+
+// Tells the coordinator which command a local rule already executed
+void actionField(MsgPackBuffer& msg, uint8_t action) {
+  if(action == SENSOR_NO_ACTION) {
+    msg.nil();
+  } else {
+    msg.number(action);
+  }
+}
+
+void irFields(MsgPackBuffer& msg, const t_ir_data* ir) {
+  msg.number(ir->code);
+  msg.number(ir->command);
+  msg.number(ir->button);
+  actionField(msg, ir->action);
+}
+
+void soundFields(MsgPackBuffer& msg, const t_sound_data* sound) {
+  msg.number(sound->rms);
+  msg.number(sound->peak);
+  msg.number(sound->envelope);
+}
+
+void nfcFields(MsgPackBuffer& msg, const t_nfc_data* nfc) {
+  msg.bin(nfc->uid, nfc->uidLength < NFC_UID_MAX_LENGTH ? nfc->uidLength : NFC_UID_MAX_LENGTH);
+  msg.number(nfc->tagType);
+  actionField(msg, nfc->action);
+}
+
+void acousticFields(MsgPackBuffer& msg, const t_acoustic_data* acoustic) {
+  msg.number(acoustic->kind);
+  msg.number(acoustic->onset);
+  msg.number(acoustic->peak);
+  msg.number(acoustic->duration);
+}
+
+}
+
+size_t writeIrMsgPack(uint8_t* out, size_t size, const t_ir_data* ir) {
+  MsgPackBuffer msg(out, size);
+  msg.array(5);
+  msg.number(MSGPACK_PAYLOAD_VERSION);
+  irFields(msg, ir);
+  return msg.finish();
+}
+
+size_t writeSoundMsgPack(uint8_t* out, size_t size, const t_sound_data* sound) {
+  MsgPackBuffer msg(out, size);
+  msg.array(4);
+  msg.number(MSGPACK_PAYLOAD_VERSION);
+  soundFields(msg, sound);
+  return msg.finish();
+}
+
+size_t writeNfcMsgPack(uint8_t* out, size_t size, const t_nfc_data* nfc) {
+  MsgPackBuffer msg(out, size);
+  msg.array(4);
+  msg.number(MSGPACK_PAYLOAD_VERSION);
+  nfcFields(msg, nfc);
+  return msg.finish();
+}
+
+size_t writeAcousticMsgPack(uint8_t* out, size_t size, const t_acoustic_data* acoustic) {
+  MsgPackBuffer msg(out, size);
+  msg.array(5);
+  msg.number(MSGPACK_PAYLOAD_VERSION);
+  acousticFields(msg, acoustic);
+  return msg.finish();
+}
+
+size_t writeStateMsgPack(uint8_t* out, size_t size, uint8_t state, const char* node) {
+  MsgPackBuffer msg(out, size);
+  msg.array(3);
+  msg.number(MSGPACK_PAYLOAD_VERSION);
+  msg.number(state);
+  msg.string(node);
+  return msg.finish();
+}
+
+size_t writeBatchMsgPack(uint8_t* out, size_t size, const t_sensor_event* events, size_t count) {
+  MsgPackBuffer msg(out, size);
+  msg.array(count + 1);
+  msg.number(MSGPACK_PAYLOAD_VERSION);
+  for(size_t i = 0; i < count; i++) {
+    const t_sensor_event* event = &events[i];
+    switch (event->type)
+    {
+      case SENSOR_IR:
+        msg.array(6);
+        break;
+      case SENSOR_SOUND:
+        msg.array(5);
+        break;
+      case SENSOR_NFC:
+        msg.array(5);
+        break;
+      case SENSOR_ACOUSTIC:
+        msg.array(6);
+        break;
+    }
+    msg.number(event->type);
+    msg.number(event->timestamp);
+    switch (event->type)
+    {
+      case SENSOR_IR:
+        irFields(msg, &event->ir);
+        break;
+      case SENSOR_SOUND:
+        soundFields(msg, &event->sound);
+        break;
+      case SENSOR_NFC:
+        nfcFields(msg, &event->nfc);
+        break;
+      case SENSOR_ACOUSTIC:
+        acousticFields(msg, &event->acoustic);
+        break;
+    }
+  }
+  return msg.finish();
+}
+
+size_t writeMetricsMsgPack(uint8_t* out, size_t size, uint32_t interval, const t_latency_histogram* histograms, size_t count) {
+  MsgPackBuffer msg(out, size);
+  msg.array(count + 2);
+  msg.number(MSGPACK_PAYLOAD_VERSION);
+  msg.number(interval);
+  for(size_t i = 0; i < count; i++) {
+    size_t used = usedLatencyBuckets(&histograms[i]);
+    msg.array(used + 1);
+    msg.number(histograms[i].sum);
+    for(size_t bucket = 0; bucket < used; bucket++) {
+      msg.number(histograms[i].buckets[bucket]);
+    }
+  }
+  return msg.finish();
+}
+
+size_t writeBootMsgPack(uint8_t* out, size_t size, const char* build, const uint32_t* times, size_t count) {
+  MsgPackBuffer msg(out, size);
+  msg.array(count + 2);
+  msg.number(MSGPACK_PAYLOAD_VERSION);
+  msg.string(build);
+  for(size_t i = 0; i < count; i++) {
+    if(times[i]) {
+      msg.number(times[i]);
+    } else {
+      msg.nil();
+    }
+  }
+  return msg.finish();
+}
+
+size_t writeDroppedMsgPack(uint8_t* out, size_t size, uint32_t dropped) {
+  MsgPackBuffer msg(out, size);
+  msg.array(2);
+  msg.number(MSGPACK_PAYLOAD_VERSION);
+  msg.number(dropped);
+  return msg.finish();
+}
+
+size_t writeScheduleMsgPack(uint8_t* out, size_t size, const t_scheduled_task* tasks, size_t count) {
+  MsgPackBuffer msg(out, size);
+  msg.array(count + 1);
+  msg.number(MSGPACK_PAYLOAD_VERSION);
+  for(size_t i = 0; i < count; i++) {
+    msg.array(5);
+    msg.number(tasks[i].period);
+    msg.number(tasks[i].budget);
+    msg.number(tasks[i].runs);
+    msg.number(tasks[i].misses);
+    msg.number(tasks[i].overruns);
+  }
+  return msg.finish();
+}
+
+size_t writeBusMsgPack(uint8_t* out, size_t size, const t_i2c_device* devices, size_t count) {
+  MsgPackBuffer msg(out, size);
+  msg.array(count + 1);
+  msg.number(MSGPACK_PAYLOAD_VERSION);
+  for(size_t i = 0; i < count; i++) {
+    msg.array(3);
+    msg.number(devices[i].transactions);
+    msg.number(devices[i].busy);
+    msg.number(devices[i].wait);
+  }
+  return msg.finish();
+}
@@ -0,0 +1,61 @@
+#include <SoundDetector.h>
+
+void initSoundDetector(t_sound_detector* detector, const t_sound_detector_config* config) {
+  detector->config = *config;
+  detector->noiseFloor = 0;
+  detector->floorValid = false;
+  detector->active = false;
+  detector->onset = 0;
+  detector->peak = 0;
+  detector->hasEvent = false;
+  detector->lastEventEnd = 0;
+}
+
+bool detectSoundEvent(t_sound_detector* detector, uint16_t level, uint32_t timestamp, t_acoustic_data* event) {
+  const t_sound_detector_config* config = &detector->config;
+  if(!detector->floorValid) {
+    detector->noiseFloor = level;
+    detector->floorValid = true;
+  }
+
+  if(!detector->active) {
+    float onThreshold = detector->noiseFloor * config->onFactor + config->minLevel;
+    bool refractory = detector->hasEvent && timestamp - detector->lastEventEnd < config->refractory;
+
+    if(level > onThreshold && !refractory) {
+      detector->active = true;
+      detector->onset = timestamp;
+      detector->peak = level;
+    } else if(level <= onThreshold) {
+      // Only quiet levels are learned, so events don't raise the floor
+      detector->noiseFloor += (level - detector->noiseFloor) * config->floorAdapt;
+    }
+    return false;
+  }
+
+  if(level > detector->peak) {
+    detector->peak = level;
+  }
+
+  uint32_t duration = timestamp - detector->onset;
+  float offThreshold = detector->noiseFloor * config->offFactor + config->minLevel;
+  bool ended = level < offThreshold;
+  bool persistent = duration >= config->maxDuration;
+  if(!ended && !persistent) {
+    return false;
+  }
+
+  event->kind = duration <= config->clapMaxDuration ? ACOUSTIC_CLAP : ACOUSTIC_LOUD;
+  event->onset = detector->onset;
+  event->peak = detector->peak;
+  event->duration = duration > 0xFFFF ? 0xFFFF : duration;
+
+  if(persistent && !ended) {
+    // The room got louder for good, that's the new normal
+    detector->noiseFloor = level;
+  }
+  detector->active = false;
+  detector->hasEvent = true;
+  detector->lastEventEnd = timestamp;
+  return true;
+}
@@ -0,0 +1,69 @@
+#include <SoundFeatures.h>
+
+#include <math.h>
+
+// How quickly the DC offset follows the signal, per sample
+static const float DC_COEFFICIENT = 1.0f / 1024.0f;
+
+void initSoundAnalyzer(t_sound_analyzer* analyzer, float attack, float release) {
+  analyzer->dc = 0;
+  analyzer->dcValid = false;
+  analyzer->envelope = 0;
+  analyzer->attack = attack;
+  analyzer->release = release;
+  analyzer->sumSquares = 0;
+  analyzer->count = 0;
+  analyzer->peak = 0;
+}
+
+uint16_t analyzeSoundBlock(t_sound_analyzer* analyzer, const uint16_t* samples, size_t count) {
+  if(!count) {
+    return 0;
+  }
+  if(!analyzer->dcValid) {
+    analyzer->dc = samples[0];
+    analyzer->dcValid = true;
+  }
+
+  // Work on locals, the struct is only written back once per block
+  float dc = analyzer->dc;
+  float envelope = analyzer->envelope;
+  float sumSquares = 0;
+  float peak = 0;
+
+  for(size_t i = 0; i < count; i++) {
+    float sample = samples[i];
+    dc += (sample - dc) * DC_COEFFICIENT;
+
+    float level = fabsf(sample - dc);
+    sumSquares += level * level;
+    if(level > peak) {
+      peak = level;
+    }
+    envelope += (level - envelope) * (level > envelope ? analyzer->attack : analyzer->release);
+  }
+
+  analyzer->dc = dc;
+  analyzer->envelope = envelope;
+  analyzer->sumSquares += sumSquares;
+  analyzer->count += count;
+  if(peak > analyzer->peak) {
+    analyzer->peak = (uint16_t) peak;
+  }
+  return (uint16_t) peak;
+}
+
+bool takeSoundFeatures(t_sound_analyzer* analyzer, t_sound_data* features) {
+  if(!analyzer->count) {
+    return false;
+  }
+
+  features->rms = (uint16_t) (sqrtf(analyzer->sumSquares / analyzer->count) + 0.5f);
+  features->peak = analyzer->peak;
+  features->envelope = (uint16_t) (analyzer->envelope + 0.5f);
+
+  analyzer->sumSquares = 0;
+  analyzer->count = 0;
+  analyzer->peak = 0;
+  return true;
+}
@@ -0,0 +1,85 @@
+#include <Trace.h>
+
+#ifdef TRACING
+
+#include <atomic>
+#include <Arduino.h>
+
+static_assert(TRACE_BUFFER_RECORDS >= 2 && (TRACE_BUFFER_RECORDS & (TRACE_BUFFER_RECORDS - 1)) == 0, "TRACE_BUFFER_RECORDS has to be a power of two");
+
+namespace {
+
+t_trace_record buffer[TRACE_BUFFER_RECORDS];
+// Free running index of the next record, claimed by writers with fetch_add
+// so any number of tasks can record without a lock
+std::atomic<uint32_t> head(0);
+// Index of the oldest record that wasn't cleared
+uint32_t tail = 0;
+std::atomic<bool> paused(false);
+// Writers between their check of paused and the end of their record. A
+// writer either sees the pause or is waited for by pauseTrace(), both are
+// sequentially consistent
+std::atomic<uint32_t> writers(0);
+
+}
+
+void traceEvent(uint16_t event, uint8_t phase, uint32_t arg0, uint32_t arg1) {
+  writers.fetch_add(1);
+  if(paused.load()) {
+    writers.fetch_sub(1, std::memory_order_relaxed);
+    return;
+  }
+  uint32_t index = head.fetch_add(1, std::memory_order_relaxed);
+  t_trace_record* record = &buffer[index & (TRACE_BUFFER_RECORDS - 1)];
+  record->timestamp = (uint32_t) esp_timer_get_time();
+  record->event = event;
+  record->phase = phase;
+  record->core = xPortGetCoreID();
+  record->arg0 = arg0;
+  record->arg1 = arg1;
+  writers.fetch_sub(1, std::memory_order_release);
+}
+
+uint32_t pauseTrace(uint32_t* first) {
+  paused.store(true);
+  // Records claimed before the pause may still be written, on the other core
+  // or by a preempted task
+  while(writers.load() != 0) {
+    vTaskDelay(1);
+  }
+  uint32_t end = head.load();
+  uint32_t oldest = end > TRACE_BUFFER_RECORDS ? end - TRACE_BUFFER_RECORDS : 0;
+  *first = oldest > tail ? oldest : tail;
+  return end;
+}
+
+const t_trace_record* traceRecordAt(uint32_t index) {
+  return &buffer[index & (TRACE_BUFFER_RECORDS - 1)];
+}
+
+void resumeTrace(bool clear) {
+  if(clear) {
+    tail = head.load();
+  }
+  paused.store(false);
+}
+
+#else
+
+// Without -D TRACING nothing is recorded and no buffer is kept, the trace
+// is always empty
+
+void traceEvent(uint16_t event, uint8_t phase, uint32_t arg0, uint32_t arg1) {}
+
+uint32_t pauseTrace(uint32_t* first) {
+  *first = 0;
+  return 0;
+}
+
+const t_trace_record* traceRecordAt(uint32_t index) {
+  return nullptr;
+}
+
+void resumeTrace(bool clear) {}
+
+#endif
@@ -5,6 +5,8 @@
 
 // WiFi
 #include <WiFi.h>
+#include <esp_system.h>
+#include <freertos/timers.h>
 
 // MQTT
 #include <AsyncMqttClient.h>
@@ -12,33 +14,147 @@
 // JSON
 #include <ArduinoJson.h>
 
-// Grove NFC
+// Sensor and presenter components
 #include <Wire.h>
-#include <PN532/PN532_I2C/PN532_I2C.h>
-#include <NfcAdapter.h>
-
-// IR
-#include <IRremoteESP8266.h>
-#include <IRrecv.h>
-#include <IRutils.h>
-#include <IRCodes.h>
-
-// LCD
-#include "rgb_lcd.h"
+#include <I2cBus.h>
+#include <Sensors.h>
+#include <Presenters.h>
+
+// Tasks
+#include <atomic>
+#include <SpscQueue.h>
+#include <TripleBuffer.h>
+#include <RingBuffer.h>
+#include <SensorEvent.h>
+#include <SensorJson.h>
+#include <SensorPayload.h>
+#include <LatencyHistogram.h>
+#include <Trace.h>
+#include <NodeRules.h>
+#include <NodeMessages.h>
+#include <MqttDispatch.h>
+#include <Backoff.h>
+#include <Scheduler.h>
+
+// Flash
+#include <Preferences.h>
+#include <esp_partition.h>
+#include <EventLog.h>
 
 /***** Constants ******/
 #pragma region
 /**************************************************************************/
+// Identity of the node, node-1 unless built with e.g.
+// -D NODE_ID=\"node-2\" -D NODE_BROADCAST_INDEX=1 -D NODE_GROUP=\"room-1\"
+#ifndef NODE_ID
+#define NODE_ID "node-1"
+#ifndef NODE_BROADCAST_INDEX
+#define NODE_BROADCAST_INDEX 0
+#endif
+#ifndef NODE_GROUP
+#define NODE_GROUP "room-1"
+#endif
+#endif
+// Another node keeping index 0 would switch along with node-1 on broadcasts
+#ifndef NODE_BROADCAST_INDEX
+#error "NODE_ID is set without NODE_BROADCAST_INDEX, give the node its index from the coordinator's config.json"
+#endif
 // This is the node identifier (or qualifier). It should be unique
-const String NODE_IDENTIFIER = String("node-1");
+const String NODE_IDENTIFIER = String(NODE_ID);
+// Position of this node in the bitset of broadcast commands, node-1 is 0
+const uint16_t NODE_INDEX = NODE_BROADCAST_INDEX;
+// Group this node belongs to, commands on group/<name>/set switch all members.
+// Another node than node-1 is in no group unless built with NODE_GROUP
+#ifdef NODE_GROUP
+const char* const NODE_GROUP_NAME = NODE_GROUP;
+#else
+const char* const NODE_GROUP_NAME = NULL;
+#endif
 // The PIN used for LED presentation
 const int LED = 16;
 // IR Pin
 const int IR_RECV = 33;
 // Sound Sensor Pin
 const int SOUND = 34;
-// NFC Timeout
+// ADC channel of the sound sensor pin, sampled continuously through I2S/DMA
+const adc1_channel_t SOUND_ADC_CHANNEL = ADC1_CHANNEL_6;
+// Sound sample rate (Hz) and samples per DMA buffer
+const uint32_t SOUND_SAMPLE_RATE = 8000;
+#define SOUND_BLOCK_SIZE 256
+// Sound features are published this often (ms)
+const uint32_t SOUND_FEATURE_INTERVAL = 100;
+// Envelope follower coefficients per sample while the level rises / falls
+const float SOUND_ENVELOPE_ATTACK = 0.05f;
+const float SOUND_ENVELOPE_RELEASE = 0.0005f;
+// Acoustic event detection on the peak level of each sound block
+const t_sound_detector_config SOUND_DETECTOR_CONFIG = {
+  0.01f,  // floorAdapt
+  3.0f,   // onFactor
+  1.5f,   // offFactor
+  40,     // minLevel
+  250,    // refractory (ms)
+  120,    // clapMaxDuration (ms)
+  2000    // maxDuration (ms)
+};
+// NFC Timeout - a pending tag detection without response for this long (ms)
+// means that no tag is held against the antenna
 const int NFC_TIMEOUT = 0x14;
+// The NFC reader is given up if it didn't answer this long (ms) after setup
+const unsigned long NFC_START_TIMEOUT = 3000;
+// Until then every poll asks it again, waiting this long (ms) per answer
+const uint16_t NFC_START_RESPONSE_TIMEOUT = 4;
+// Each sensor is polled once per period (us) and takes at most its budget (us)
+// per poll. The DMA holds two sound blocks (64 ms), the IR receiver buffers a
+// whole signal. Tune them per deployment, the schedule is published with the
+// metrics
+const uint32_t IR_PERIOD = 10000;
+const uint32_t IR_BUDGET = 1000;
+const uint32_t SOUND_PERIOD = 16000;
+const uint32_t SOUND_BUDGET = 2000;
+const uint32_t NFC_PERIOD = 20000;
+const uint32_t NFC_BUDGET = 5000;
+// Core the IR/sound sampling and the publisher run on. loop() - and with it
+// the NFC polling - runs on the other core (ARDUINO_RUNNING_CORE)
+const BaseType_t SENSOR_CORE = 0;
+// Stack sizes (bytes) of the sensor and publisher tasks
+const uint32_t SENSOR_TASK_STACK = 4096;
+const uint32_t PUBLISHER_TASK_STACK = 4096;
+// With batching enabled sensor events are collected for at most this long (ms)...
+const uint32_t BATCH_WINDOW = 500;
+// ...or until this many were collected and then published as one message
+const size_t BATCH_MAX_EVENTS = 16;
+// Sensor events kept while disconnected from the broker, beyond that the 
+// oldest are dropped. They're replayed in order once the connection is back
+#define OFFLINE_MAX_EVENTS 64
+// A replay that the MQTT client didn't take is retried after this long (ms)
+const uint32_t REPLAY_RETRY = 100;
+// With the flash log enabled, sensor events are kept in this partition 
+// instead, see partitions.csv
+const char* const LOG_PARTITION = "eventlog";
+// Events kept in the flash log are written at the latest after this long (ms)
+const uint32_t LOG_FLUSH_INTERVAL = 1000;
+// The flash log is replayed one batch per interval (ms)
+const uint32_t LOG_REPLAY_INTERVAL = 250;
+// Reconnect attempts are delayed between these (ms), doubling per failed attempt
+const uint32_t WIFI_RECONNECT_MIN = 1000;
+const uint32_t WIFI_RECONNECT_MAX = 60000;
+const uint32_t MQTT_RECONNECT_MIN = 1000;
+const uint32_t MQTT_RECONNECT_MAX = 30000;
+// Unknown NFC tags are published at most this often (ms), after a quiet
+// period up to NFC_UNKNOWN_BURST of them at once
+const uint32_t NFC_UNKNOWN_INTERVAL = 2000;
+const uint8_t NFC_UNKNOWN_BURST = 3;
+// Largest config that is kept in flash
+const size_t CONFIG_MAX_SIZE = 1024;
+// Latency histograms are published and restarted this often (ms)
+const uint32_t METRICS_INTERVAL = 10000;
+// Trace records per message of an MQTT trace dump
+const size_t TRACE_CHUNK_RECORDS = 64;
+// Identifies the firmware build in the boot report, override with
+// -D FIRMWARE_BUILD=\"...\" e.g. to use the git revision
+#ifndef FIRMWARE_BUILD
+#define FIRMWARE_BUILD __DATE__ " " __TIME__
+#endif
 
 /**************************************************************************/
 #pragma endregion
@@ -47,10 +163,9 @@ const int NFC_TIMEOUT = 0x14;
 /***** Feature / Build Flags ******/
 #pragma region
 /**************************************************************************/
-// These are feature flags to enable node-specific features.
-// TODO: We probably would rather inline them using build profiles
-//       to even exclude libraries. However, this would cruttle the codebase as we're using
-//       a single-file sketch and would require more modularity to be useful
+// These are feature flags to enable node-specific features. The sensor and
+// presenter flags select the components below at compile time, a disabled
+// component isn't even constructed
 #ifdef S_NFC
 const boolean S_NFC_ENABLED = true;
 #else 
@@ -81,6 +196,36 @@ const boolean P_LED_ENABLED = true;
 const boolean P_LED_ENABLED = false;
 #endif
 
+#ifdef SOUND_FEATURES
+const boolean SOUND_FEATURES_ENABLED = true;
+#else 
+const boolean SOUND_FEATURES_ENABLED = false;
+#endif
+
+#ifdef SENSOR_BATCHING
+const boolean BATCHING_ENABLED = true;
+#else 
+const boolean BATCHING_ENABLED = false;
+#endif
+
+#ifdef METRICS
+const boolean METRICS_ENABLED = true;
+#else 
+const boolean METRICS_ENABLED = false;
+#endif
+
+#ifdef TRACING
+const boolean TRACING_ENABLED = true;
+#else 
+const boolean TRACING_ENABLED = false;
+#endif
+
+#ifdef FLASH_LOG
+const boolean FLASH_LOG_ENABLED = true;
+#else 
+const boolean FLASH_LOG_ENABLED = false;
+#endif
+
 #ifdef DEBUG_MODE
 const boolean DEBUG = true;
 #else 
@@ -94,11 +239,47 @@ const boolean DEBUG = false;
 #pragma region
 /**************************************************************************/
 const String COMMAND_TOPIC = String("node/") + NODE_IDENTIFIER + String("/set");
+// Retained rules of the coordinator that this node executes on its own
+const String CONFIG_TOPIC = String("node/") + NODE_IDENTIFIER + String("/config");
+// Commands for all nodes of the group, empty without NODE_GROUP_NAME
+const String GROUP_TOPIC = NODE_GROUP_NAME ? String("group/") + NODE_GROUP_NAME + String("/set") : String();
+// Commands for any set of nodes, addressed by NODE_INDEX
+const String BROADCAST_TOPIC = String("broadcast/set");
 const String STATE_TOPIC = String("node/") + NODE_IDENTIFIER + String("/state");
 const String SENSOR_TOPIC = String("node/") + NODE_IDENTIFIER + String("/sensor");
 const String IR_SENSOR_TOPIC = SENSOR_TOPIC + String("/ir"); 
 const String SOUND_SENSOR_TOPIC = SENSOR_TOPIC + String("/sound");
+const String ACOUSTIC_SENSOR_TOPIC = SENSOR_TOPIC + String("/acoustic");
 const String NFC_SENSOR_TOPIC = SENSOR_TOPIC + String("/nfc");
+const String NFC_DROPPED_SENSOR_TOPIC = NFC_SENSOR_TOPIC + String("/dropped");
+// Used instead of the topics above if batching is enabled
+const String BATCH_SENSOR_TOPIC = SENSOR_TOPIC + String("/batch");
+// Events of the offline queue, as a batch with their original timestamps, and
+// how many events didn't fit into it
+const String REPLAY_SENSOR_TOPIC = SENSOR_TOPIC + String("/replay");
+const String DROPPED_SENSOR_TOPIC = SENSOR_TOPIC + String("/dropped");
+const String METRICS_TOPIC = String("node/") + NODE_IDENTIFIER + String("/metrics");
+const String SCHEDULE_TOPIC = String("node/") + NODE_IDENTIFIER + String("/schedule");
+const String BUS_TOPIC = String("node/") + NODE_IDENTIFIER + String("/bus");
+// Any message on the dump topic publishes the trace buffer on the trace topic
+const String TRACE_TOPIC = String("node/") + NODE_IDENTIFIER + String("/trace");
+const String TRACE_DUMP_TOPIC = TRACE_TOPIC + String("/dump");
+// Boot times of the running firmware, published once per boot and retained
+const String BOOT_TOPIC = String("node/") + NODE_IDENTIFIER + String("/boot");
+
+// IDs the subscribed topics are dispatched by
+enum TopicId : uint8_t {
+  TOPIC_COMMAND = 0,
+  TOPIC_CONFIG = 1,
+  TOPIC_GROUP = 2,
+  TOPIC_BROADCAST = 3,
+  TOPIC_TRACE_DUMP = 4
+};
+
+// Subscribed topics and the message currently received, only touched by the
+// MQTT callback
+t_topic_dispatch topics;
+t_payload_assembler incoming;
 /**************************************************************************/
 #pragma endregion
 
@@ -106,19 +287,23 @@ const String NFC_SENSOR_TOPIC = SENSOR_TOPIC + String("/nfc");
 #pragma region
 /**************************************************************************/
 AsyncMqttClient mqttClient;
-IRrecv irReceiver(IR_RECV);
-decode_results results;
-rgb_lcd lcd;
-PN532_I2C pn532_i2c(Wire);
-NfcAdapter nfc = NfcAdapter(pn532_i2c);
+// The NFC reader and the LCD share this bus, every access goes through it
+I2cBus i2cBus(Wire);
+NfcSensor<S_NFC_ENABLED> nfcSensor(i2cBus, NFC_TIMEOUT, NFC_START_TIMEOUT, NFC_START_RESPONSE_TIMEOUT);
+IrSensor<S_IR_ENABLED> irSensor(IR_RECV);
+SoundSensor<S_SOUND_ENABLED, SOUND_BLOCK_SIZE> soundSensor(SOUND_ADC_CHANNEL, SOUND_SAMPLE_RATE, SOUND_FEATURE_INTERVAL,
+                                                           SOUND_ENVELOPE_ATTACK, SOUND_ENVELOPE_RELEASE, &SOUND_DETECTOR_CONFIG);
+Presentation<LedPresenter<P_LED_ENABLED, LED>, LcdPresenter<P_LCD_ENABLED, i2cBus>> presentation;
 /**************************************************************************/
 #pragma endregion
 
 /***** Statevars / Helpers ******/
 #pragma region
 /**************************************************************************/
+// Only touched by loop()
 boolean enabled = false;
-boolean nfcMutex = false;
+// Set by the MQTT callback on connect, loop() queues the current state then
+std::atomic<bool> stateRequested(false);
 /**************************************************************************/
 #pragma endregion
 
@@ -127,22 +312,7 @@ boolean nfcMutex = false;
 #pragma region
 /**************************************************************************/
 
-// Data that we get from the IR Sensor
-typedef struct s_ir_data {
-  uint32_t code;
-  uint16_t command;
-} t_ir_data;
-
-// Data that we get from the Sound Sensor
-typedef struct s_sound_data {
-  uint16_t value;
-} t_sound_data;
-
-// Data that we get from the NFC Sensor
-typedef struct s_nfc_data {
-  const char* uid;
-  const char* type;
-} t_nfc_data;
+// Sensor data and events are defined in SensorEvent.h
 
 // Possible Node States
 enum State {
@@ -150,18 +320,309 @@ enum State {
   ON = 1
 };
 
-// Command types that can be performed on this node
-enum Command {
-  DISABLE = 0,
-  ENABLE = 1,
-  TOGGLE = 2
+// Commands are defined in NodeMessages.h
+
+// A state change that has to be published
+typedef struct s_state_data {
+  State state;
+} t_state_data;
+/**************************************************************************/
+#pragma endregion
+
+
+/***** Local Rules ******/
+#pragma region
+/**************************************************************************/
+// Rules are compiled into the inactive table, then the pointer is swapped.
+// A reader may still be matching against the table that gets rewritten, the
+// generation is bumped before and after every rewrite so it notices and
+// matches again (see matchActiveRules)
+t_node_rules ruleTables[2];
+std::atomic<t_node_rules*> activeRules(&ruleTables[0]);
+std::atomic<uint32_t> rulesGeneration(0);
+// The last config is kept in flash, so the rules work before the broker is reached
+Preferences preferences;
+// A config as received, it's parsed and stored by loop()
+typedef struct s_config_message {
+  size_t length;
+  char payload[CONFIG_MAX_SIZE];
+} t_config_message;
+// Written by the MQTT callback, a newer config replaces one loop() didn't take yet
+TripleBuffer<t_config_message> receivedConfigs;
+// Only used by loop(), too large for its stack
+StaticJsonDocument<CONFIG_MAX_SIZE> configDoc;
+char storedConfig[CONFIG_MAX_SIZE];
+// Only touched by loop()
+t_tag_rate_limiter unknownTags;
+// Counted by loop(), reported by the publisher task
+std::atomic<uint32_t> droppedUnknownTags(0);
+uint32_t reportedUnknownTags = 0;
+unsigned long unknownTagsReported = 0;
+/**************************************************************************/
+#pragma endregion
+
+
+/***** Metrics ******/
+#pragma region
+/**************************************************************************/
+// What is measured, every call of the function in question
+enum Metric : uint8_t {
+  METRIC_LOOP = 0,     // loop()
+  METRIC_NFC = 1,      // readNFC()
+  METRIC_IR = 2,       // readIR()
+  METRIC_SOUND = 3,    // readSound()
+  METRIC_PUBLISH = 4,  // MQTT publish of any state or sensor payload
+  METRIC_COUNT
 };
+const char* const METRIC_NAMES[METRIC_COUNT] = { "loop", "nfc", "ir", "sound", "publish" };
+
+// Each histogram is only written by the task calling the measured function
+t_latency_histogram metrics[METRIC_COUNT];
+// Counters at the last report and the histograms of the current report,
+// only touched by the publisher task
+t_latency_histogram reportedMetrics[METRIC_COUNT];
+t_latency_histogram intervalMetrics[METRIC_COUNT];
+unsigned long metricsStarted = 0;
+char metricsPayload[METRICS_PAYLOAD_SIZE(METRIC_COUNT)];
+char tracePayload[TRACE_CHUNK_RECORDS * sizeof(t_trace_record)];
+// Set by the MQTT callback, the dump is published by the publisher task
+std::atomic<bool> traceDumpRequested(false);
+
+// CPU cycles per microsecond, set on startup
+uint32_t cyclesPerUs = 240;
+
+/**
+ * @brief Starts a measurement. The cycle counter is read as it costs a 
+ *        single instruction, esp_timer_get_time() is much slower
+ * 
+ * @return uint32_t cycle count to pass to endMeasurement()
+ */
+inline uint32_t startMeasurement() {
+  return METRICS_ENABLED ? ESP.getCycleCount() : 0;
+}
+
+/**
+ * @brief Records the time since startMeasurement(). Cycle counters are per 
+ *        core, all measuring tasks are pinned to one
+ * 
+ * @param metric what was measured
+ * @param start value returned by startMeasurement()
+ */
+inline void endMeasurement(Metric metric, uint32_t start) {
+  if(METRICS_ENABLED) {
+    recordLatency(&metrics[metric], (ESP.getCycleCount() - start) / cyclesPerUs);
+  }
+}
+/**************************************************************************/
+#pragma endregion
+
+
+/***** Scheduling ******/
+#pragma region
+/**************************************************************************/
+// Sensors are polled by earliest deadline first, IR and sound by the sensor
+// task and NFC by loop(). Each schedule is only run by its task, the
+// publisher reads the counters for the report
+t_scheduler sensorSchedule;
+t_scheduler loopSchedule;
+t_scheduled_task scheduleReport[2 * SCHEDULER_MAX_TASKS];
+char schedulePayload[SCHEDULE_PAYLOAD_SIZE(2 * SCHEDULER_MAX_TASKS)];
+char busPayload[BUS_PAYLOAD_SIZE(I2C_MAX_DEVICES)];
+
+uint32_t schedulerClock() {
+  return micros();
+}
+/**************************************************************************/
+#pragma endregion
+
+
+/***** Boot ******/
+#pragma region
+/**************************************************************************/
+// Phases of the boot. WiFi association and the MQTT connection run in the
+// background while the peripherals come up, so the phases overlap and are
+// reached in any order
+enum BootPhase : uint8_t {
+  BOOT_SETUP = 0,        // setup() entered
+  BOOT_PERIPHERALS = 1,  // sensors, presentation and tasks set up
+  BOOT_NFC = 2,          // the PN532 answered its firmware version
+  BOOT_WIFI = 3,         // got an IP address
+  BOOT_MQTT = 4,         // connected to the broker
+  BOOT_STATE = 5,        // first state published
+  BOOT_PHASE_COUNT
+};
+const char* const BOOT_PHASE_NAMES[BOOT_PHASE_COUNT] = { "setup", "peripherals", "nfc", "wifi", "mqtt", "state" };
+
+// ms since reset each phase was first reached at, 0 if it wasn't yet.
+// Written by the task reaching the phase, read by the publisher task
+std::atomic<uint32_t> bootTimes[BOOT_PHASE_COUNT];
+uint32_t bootReport[BOOT_PHASE_COUNT];
+char bootPayload[BOOT_PAYLOAD_SIZE(BOOT_PHASE_COUNT)];
+
+/**
+ * @brief Records when a boot phase was reached. Only the first time counts,
+ *        reconnects don't change the boot times
+ * 
+ * @param phase phase that was reached
+ */
+void reachBootPhase(BootPhase phase) {
+  uint32_t now = millis();
+  uint32_t unreached = 0;
+  bootTimes[phase].compare_exchange_strong(unreached, now ? now : 1);
+}
+
+/**
+ * @brief Whether a boot phase was reached
+ * 
+ * @param phase phase in question
+ */
+inline boolean reachedBootPhase(BootPhase phase) {
+  return bootTimes[phase].load(std::memory_order_relaxed) != 0;
+}
+/**************************************************************************/
+#pragma endregion
+
+
+/***** Event Queues ******/
+#pragma region
+/**************************************************************************/
+// Every queue has exactly one producing task, the publisher task is the only
+// consumer. Hence sensors never wait for MQTT and the publisher is the only
+// one calling mqttClient.publish
+SpscQueue<t_sensor_event, 32> sensorEvents;  // sensor task
+SpscQueue<t_sensor_event, 4> nfcEvents;      // loop()
+SpscQueue<t_state_data, 4> stateEvents;      // loop()
+
+// Per-topic output buffers, only written by the publisher task
+char irPayload[IR_PAYLOAD_SIZE];
+char soundPayload[SOUND_PAYLOAD_SIZE];
+char acousticPayload[ACOUSTIC_PAYLOAD_SIZE];
+char nfcPayload[NFC_PAYLOAD_SIZE];
+char statePayload[STATE_PAYLOAD_SIZE];
+char batchPayload[BATCH_PAYLOAD_SIZE(BATCH_MAX_EVENTS)];
+
+// Sensor events collected for the next batch, only touched by the publisher task
+t_sensor_event batch[BATCH_MAX_EVENTS];
+size_t batchCount = 0;
+unsigned long batchStarted = 0;
+
+// Sensor events kept while disconnected and those that didn't fit, only
+// touched by the publisher task
+RingBuffer<t_sensor_event, OFFLINE_MAX_EVENTS> offlineEvents;
+uint32_t droppedOfflineEvents = 0;
+t_sensor_event replay[BATCH_MAX_EVENTS];
+char droppedPayload[DROPPED_PAYLOAD_SIZE];
+
+// Sensor events kept in flash, survive a reboot. Mounted in setup(), only
+// touched by the publisher task afterwards
+const esp_partition_t* logPartition = NULL;
+t_log_flash logFlash;
+t_event_log eventLog;
+boolean eventLogMounted = false;
+// When the oldest record that's not in flash yet was appended and when the
+// last batch was replayed
+unsigned long logCollected = 0;
+unsigned long logReplayed = 0;
+
+// Commands of local IR rules, executed by loop()
+SpscQueue<RuleAction, 4> localActions;  // sensor task
+// Received commands, executed by loop() so the LCD isn't driven over I2C
+// while loop() talks to the PN532
+SpscQueue<t_node_command, 8> commands;  // MQTT callback
+uint32_t droppedCommands = 0;
+
+TaskHandle_t publisherTaskHandle = NULL;
+// Events that didn't fit into their queue
+std::atomic<uint32_t> droppedEvents(0);
+
+/**
+ * @brief Queues an event and wakes up the publisher task
+ * 
+ * @param queue queue owned by the calling task
+ * @param event event to be published
+ */
+template <typename T, size_t N>
+void queueEvent(SpscQueue<T, N>& queue, const T& event) {
+  if(!queue.push(event)) {
+    droppedEvents++;
+  }
+  if(publisherTaskHandle) {
+    xTaskNotifyGive(publisherTaskHandle);
+  }
+}
+
+// Flash access of the event log, the context is the partition
+bool readLogPartition(void* context, uint32_t offset, void* data, size_t length) {
+  return esp_partition_read((const esp_partition_t*) context, offset, data, length) == ESP_OK;
+}
+
+bool writeLogPartition(void* context, uint32_t offset, const void* data, size_t length) {
+  return esp_partition_write((const esp_partition_t*) context, offset, data, length) == ESP_OK;
+}
 
-// How a command will be received
-typedef struct s_node_command {
-  const char* node;
-  Command command;
-} t_node_command;
+bool eraseLogPartition(void* context, uint32_t offset) {
+  return esp_partition_erase_range((const esp_partition_t*) context, offset, LOG_SECTOR_SIZE) == ESP_OK;
+}
+
+/**
+ * @brief Mounts the event log in its flash partition. Without the partition
+ *        sensor events are only kept in RAM while disconnected
+ * 
+ */
+void mountEventLog() {
+  logPartition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, LOG_PARTITION);
+  if(!logPartition) {
+    Serial.println("No eventlog partition, keeping offline events in RAM");
+    return;
+  }
+
+  logFlash.read = readLogPartition;
+  logFlash.write = writeLogPartition;
+  logFlash.erase = eraseLogPartition;
+  logFlash.context = (void*) logPartition;
+  logFlash.size = logPartition->size - logPartition->size % LOG_SECTOR_SIZE;
+  eventLogMounted = mountLog(&eventLog, &logFlash);
+
+  if(DEBUG) {
+    Serial.print("Event log mounted: ");
+    Serial.print(eventLogMounted);
+    Serial.print(" Pending: ");
+    Serial.println(pendingLogRecords(&eventLog));
+  }
+}
+/**************************************************************************/
+#pragma endregion
+
+
+/***** Connection ******/
+#pragma region
+/**************************************************************************/
+// One-shot timers of the next reconnect attempt. Each backoff is only touched
+// by the task handling the events of its connection
+TimerHandle_t wifiReconnectTimer;
+TimerHandle_t mqttReconnectTimer;
+t_backoff wifiBackoff;
+t_backoff mqttBackoff;
+
+/**
+ * @brief Starts the timer of the next reconnect attempt
+ * 
+ * @param timer reconnect timer of the connection
+ * @param backoff backoff of the connection
+ * @param name name of the connection, for debugging
+ */
+void scheduleReconnect(TimerHandle_t timer, t_backoff* backoff, const char* name) {
+  uint32_t delay = nextBackoff(backoff, esp_random());
+  if(DEBUG) {
+    Serial.print("Reconnecting to ");
+    Serial.print(name);
+    Serial.print(" in ");
+    Serial.print(delay);
+    Serial.println(" ms");
+  }
+  // Starts the timer if it's not running, restarts it otherwise
+  xTimerChangePeriod(timer, pdMS_TO_TICKS(delay), 0);
+}
 /**************************************************************************/
 #pragma endregion
 
@@ -179,12 +640,13 @@ void i2c_scanner()
   Serial.println("I2C scanner. Scanning ...");
   byte count = 0;
 
-  Wire.begin();
+  // Runs before any device joined the bus, nothing to wait for
+  TwoWire& wire = i2cBus.wire();
   for (byte i = 1; i < 120; i++)
   {
-    Wire.beginTransmission(i);
+    wire.beginTransmission(i);
 
-    if (Wire.endTransmission() == 0)
+    if (wire.endTransmission() == 0)
     {
       Serial.print("Found address: ");
       Serial.print(i, DEC);
@@ -220,6 +682,15 @@ void connectToMqtt()
   Serial.println("Connecting to MQTT...");
   mqttClient.connect();
 }
+
+// Callbacks of the reconnect timers
+void onWifiReconnectTimer(TimerHandle_t timer) {
+  connectToWifi();
+}
+
+void onMqttReconnectTimer(TimerHandle_t timer) {
+  connectToMqtt();
+}
 /**************************************************************************/
 
 #pragma endregion
@@ -233,163 +704,577 @@ void connectToMqtt()
  * 
  */
 void setupSensors() {
-  // Print a warning when NFC and IR are enabled.
-  // We experienced interferences and inconsistent behaviour when both are 
-  // enabled at the same time - probably because the NFC reader blocks the 
-  // whole execution. Even if a timout is specified the IR sensor might not
-  // work as resilient as expected
-  if(S_IR_ENABLED && S_NFC_ENABLED) {
-    Serial.println("NFC and IR enabled, NFC blocks the execution - so IR might not work properly");
+  if(DEBUG && S_IR_ENABLED) {
+    Serial.println("Enabling IR...");
   }
+  irSensor.setup();
 
-  if(S_IR_ENABLED) {
-    if(DEBUG) {
-      Serial.println("Enabling IR...");
+  if(DEBUG && S_NFC_ENABLED) {
+    Serial.println("Enabling NFC...");
+  }
+  nfcSensor.setup();
+
+  if(DEBUG && S_SOUND_ENABLED) {
+    Serial.println("Enabling Sound...");
+  }
+  soundSensor.setup();
+}
+
+/**
+ * @brief Matches a sensor reading against the active rules, lock free. If the
+ *        rules were rewritten meanwhile, the table that was read may have been
+ *        half written - then it's matched again
+ * 
+ * @param match matches a reading against a rule table
+ * @return RuleAction action of the matching rule
+ */
+template <typename Match>
+RuleAction matchActiveRules(Match match) {
+  for(;;) {
+    uint32_t generation = rulesGeneration.load(std::memory_order_acquire);
+    RuleAction action = match(activeRules.load(std::memory_order_acquire));
+    // The table is read before the generation is checked again
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(rulesGeneration.load(std::memory_order_relaxed) == generation) {
+      return action;
     }
-    irReceiver.enableIRIn();
   }
+}
 
-  if(S_NFC_ENABLED) {
-    if(DEBUG) {
-      Serial.println("Enabling NFC...");
+/**
+ * @brief Read the expected data from NFC tag, the NFC sensor never blocks
+ *        so IR signals aren't missed
+ * 
+ * @param event filled with the data read from the NFC tag
+ * @return true if a new tag was read, false if no tag was present
+ */
+boolean readNFC(t_sensor_event* event) {
+  if(!nfcSensor.read(event)) {
+    return false;
+  }
+  event->nfc.action = matchActiveRules([event](const t_node_rules* rules) {
+    return matchNfcRule(rules, &event->nfc);
+  });
+
+  if(DEBUG) {
+    char uid[NFC_UID_STRING_LENGTH];
+    formatNfcUid(&event->nfc, uid);
+    Serial.println("Read NFC");
+    Serial.print("Type: ");
+    Serial.println(nfcTagTypeName(&event->nfc));
+    Serial.print("UID: ");
+    Serial.println(uid);
+  }
+
+  return true;
+}
+
+/**
+ * @brief Read the expected data from IR sensor
+ * 
+ * @param event filled with the data read from the IR signal
+ * @return true if a signal was decoded, false if no signal was present
+ */
+boolean readIR(t_sensor_event* event)
+{
+  if(!irSensor.read(event)) {
+    return false;
+  }
+  event->ir.action = matchActiveRules([event](const t_node_rules* rules) {
+    return matchIRRule(rules, event->ir.code);
+  });
+
+  // The command is executed by loop(), which owns the presentation
+  if(event->ir.action != RULE_NONE && !localActions.push((RuleAction) event->ir.action)) {
+    droppedEvents++;
+  }
+
+  if(DEBUG) {
+    const t_ir_code* button = lookupIRCode(event->ir.code);
+    Serial.print("Code (Hex): ");
+    Serial.println(event->ir.code);
+    Serial.print("Command: ");
+    Serial.println(event->ir.command);
+    Serial.print("Button: ");
+    Serial.println(button ? button->name : "unknown");
+    irSensor.printLast(Serial);
+  }
+
+  return true;
+}
+
+/**
+ * @brief Looks for acoustic events like claps in the sound samples the DMA
+ *        collected so far
+ * 
+ * @param event filled with the detected acoustic event
+ * @return true if an acoustic event ended, false otherwise
+ */
+boolean readSound(t_sensor_event* event) {
+  if(!soundSensor.read(event)) {
+    return false;
+  }
+
+  if(DEBUG) {
+    Serial.print("Acoustic event: ");
+    Serial.print(event->acoustic.kind == ACOUSTIC_CLAP ? "clap" : "loud");
+    Serial.print(" Peak: ");
+    Serial.println(event->acoustic.peak);
+  }
+  return true;
+}
+
+/**
+ * @brief Reads the IR sensor and queues its data for the publisher. Runs in
+ *        the sensor task, scheduled every IR_PERIOD
+ * 
+ */
+void pollIR() {
+  t_sensor_event event;
+  uint32_t start = startMeasurement();
+  boolean read = readIR(&event);
+  endMeasurement(METRIC_IR, start);
+  if(read) {
+    queueEvent(sensorEvents, event);
+  }
+}
+
+/**
+ * @brief Reads the sound sensor and queues its data for the publisher. Runs
+ *        in the sensor task, scheduled every SOUND_PERIOD
+ * 
+ */
+void pollSound() {
+  t_sensor_event event;
+  uint32_t start = startMeasurement();
+  boolean read = readSound(&event);
+  endMeasurement(METRIC_SOUND, start);
+  if(read) {
+    queueEvent(sensorEvents, event);
+  }
+  // The features are always taken to start a new interval, but they're 
+  // only streamed on demand - acoustic events are what's usually of interest
+  if(soundSensor.readFeatures(&event) && SOUND_FEATURES_ENABLED) {
+    queueEvent(sensorEvents, event);
+  }
+}
+
+/**
+ * @brief Publishes a serialized payload
+ * 
+ * @param topic topic to publish to
+ * @param retain whether the broker should retain the message
+ * @param payload serialized payload
+ * @param length length of the payload, 0 if it didn't fit into its buffer
+ * @return true if the payload was handed to the MQTT client, false if it 
+ *         didn't fit or the client isn't connected
+ */
+boolean publishPayload(const String& topic, boolean retain, const char* payload, size_t length) {
+  if(!length) {
+    Serial.print("Payload too large for ");
+    Serial.println(topic);
+    return false;
+  }
+  uint32_t start = startMeasurement();
+  TRACE_BEGIN(TRACE_PUBLISH, length, 0);
+  uint16_t packetId = mqttClient.publish(topic.c_str(), 0, retain, payload, length);
+  TRACE_END(TRACE_PUBLISH, length, packetId);
+  endMeasurement(METRIC_PUBLISH, start);
+  return packetId != 0;
+}
+
+/**
+ * @brief Publishes a sensor event into its defined sensor topic
+ * 
+ * @param event event to be published
+ * @return true if the event was handed to the MQTT client
+ */
+boolean publishSensorEvent(const t_sensor_event& event) {
+  size_t length = 0;
+  switch (event.type)
+  {
+    case SENSOR_IR:
+      // Publish under IR Sensor Topic
+      length = writeIrPayload(irPayload, sizeof(irPayload), &event.ir);
+      return publishPayload(IR_SENSOR_TOPIC, false, irPayload, length);
+
+    case SENSOR_SOUND:
+      // Publish under Sound Sensor Topic
+      length = writeSoundPayload(soundPayload, sizeof(soundPayload), &event.sound);
+      return publishPayload(SOUND_SENSOR_TOPIC, false, soundPayload, length);
+
+    case SENSOR_ACOUSTIC:
+      // Publish under Acoustic Sensor Topic
+      length = writeAcousticPayload(acousticPayload, sizeof(acousticPayload), &event.acoustic);
+      return publishPayload(ACOUSTIC_SENSOR_TOPIC, false, acousticPayload, length);
+
+    case SENSOR_NFC:
+      // Publish under NFC Sensor Topic
+      length = writeNfcPayload(nfcPayload, sizeof(nfcPayload), &event.nfc);
+      return publishPayload(NFC_SENSOR_TOPIC, false, nfcPayload, length);
+  }
+  return false;
+}
+
+/**
+ * @brief Keeps a sensor event that couldn't be published for the replay
+ * 
+ * @param event event to be published later
+ */
+void keepOffline(const t_sensor_event& event) {
+  if(eventLogMounted) {
+    if(!eventLog.pageLength) {
+      logCollected = millis();
+    }
+    if(!appendLog(&eventLog, &event, sizeof(event))) {
+      droppedOfflineEvents++;
+    }
+    // Starting a sector of a full log erases its oldest events
+    droppedOfflineEvents += eventLog.dropped;
+    eventLog.dropped = 0;
+    return;
+  }
+
+  if(!offlineEvents.push(event)) {
+    droppedOfflineEvents++;
+  }
+}
+
+/**
+ * @brief Whether sensor events are waiting for the replay
+ * 
+ */
+boolean hasOfflineEvents() {
+  return !offlineEvents.empty() || (eventLogMounted && pendingLogRecords(&eventLog));
+}
+
+/**
+ * @brief Keeps the collected sensor events for the replay, they're older
+ *        than any event that follows
+ * 
+ */
+void keepBatchOffline() {
+  for(size_t i = 0; i < batchCount; i++) {
+    keepOffline(batch[i]);
+  }
+  batchCount = 0;
+}
+
+/**
+ * @brief Publishes all collected sensor events as one array into the batch topic
+ * 
+ */
+void publishBatch() {
+  size_t length = writeBatchPayload(batchPayload, sizeof(batchPayload), batch, batchCount);
+  if(!publishPayload(BATCH_SENSOR_TOPIC, false, batchPayload, length)) {
+    keepBatchOffline();
+  }
+  batchCount = 0;
+}
+
+/**
+ * @brief Publishes the next batch of events of the flash log. At most one 
+ *        batch per LOG_REPLAY_INTERVAL, so a long backlog doesn't hog the 
+ *        connection. Events are only consumed once the MQTT client took them,
+ *        a reboot meanwhile replays them again
+ * 
+ * @return true if the flash log was replayed completely
+ */
+boolean replayEventLog() {
+  if(!pendingLogRecords(&eventLog)) {
+    return true;
+  }
+  if(millis() - logReplayed < LOG_REPLAY_INTERVAL) {
+    return false;
+  }
+  logReplayed = millis();
+
+  uint32_t cursor = startLogRead(&eventLog);
+  size_t count = 0;
+  size_t length;
+  while(count < BATCH_MAX_EVENTS && (length = readLog(&eventLog, &cursor, &replay[count], sizeof(replay[count])))) {
+    // Records of another size were written by another firmware, they're skipped
+    if(length == sizeof(t_sensor_event)) {
+      count++;
+    }
+  }
+  if(count) {
+    length = writeBatchPayload(batchPayload, sizeof(batchPayload), replay, count);
+    if(!publishPayload(REPLAY_SENSOR_TOPIC, false, batchPayload, length)) {
+      return false;
+    }
+  }
+  consumeLog(&eventLog, cursor);
+  return !pendingLogRecords(&eventLog);
+}
+
+/**
+ * @brief Publishes the sensor events kept while disconnected in order, as
+ *        batches with their original timestamps, and then how many were
+ *        dropped. Stops at the first message the MQTT client doesn't take
+ * 
+ */
+void replayOfflineEvents() {
+  if(eventLogMounted && !replayEventLog()) {
+    return;
+  }
+  while(!offlineEvents.empty()) {
+    size_t count = offlineEvents.size() < BATCH_MAX_EVENTS ? offlineEvents.size() : BATCH_MAX_EVENTS;
+    for(size_t i = 0; i < count; i++) {
+      replay[i] = offlineEvents.at(i);
+    }
+    size_t length = writeBatchPayload(batchPayload, sizeof(batchPayload), replay, count);
+    if(!publishPayload(REPLAY_SENSOR_TOPIC, false, batchPayload, length)) {
+      return;
+    }
+    offlineEvents.drop(count);
+  }
+
+  if(droppedOfflineEvents) {
+    size_t length = writeDroppedPayload(droppedPayload, sizeof(droppedPayload), droppedOfflineEvents);
+    if(publishPayload(DROPPED_SENSOR_TOPIC, false, droppedPayload, length)) {
+      if(DEBUG) {
+        Serial.print("Dropped events while offline: ");
+        Serial.println(droppedOfflineEvents);
+      }
+      droppedOfflineEvents = 0;
+    }
+  }
+}
+
+/**
+ * @brief How long the publisher may sleep before the replay is retried
+ * 
+ * @return TickType_t ticks until the next attempt, portMAX_DELAY if there is
+ *                    nothing to replay or the connection is down - the 
+ *                    publisher is woken up on connect
+ */
+TickType_t replayTimeout() {
+  if((!hasOfflineEvents() && !droppedOfflineEvents) || !mqttClient.connected()) {
+    return portMAX_DELAY;
+  }
+  return pdMS_TO_TICKS(eventLogMounted ? LOG_REPLAY_INTERVAL : REPLAY_RETRY);
+}
+
+/**
+ * @brief Publishes how many unknown NFC tags were dropped since the last 
+ *        report, at most once per NFC_UNKNOWN_INTERVAL
+ * 
+ */
+void publishDroppedTags() {
+  uint32_t dropped = droppedUnknownTags.load();
+  if(dropped == reportedUnknownTags || millis() - unknownTagsReported < NFC_UNKNOWN_INTERVAL) {
+    return;
+  }
+  size_t length = writeDroppedPayload(droppedPayload, sizeof(droppedPayload), dropped - reportedUnknownTags);
+  if(publishPayload(NFC_DROPPED_SENSOR_TOPIC, false, droppedPayload, length)) {
+    reportedUnknownTags = dropped;
+    unknownTagsReported = millis();
+  }
+}
+
+/**
+ * @brief How long the publisher may sleep before dropped unknown NFC tags
+ *        are due to be reported
+ * 
+ * @return TickType_t ticks until the report, portMAX_DELAY if none were 
+ *                    dropped or the connection is down - the publisher is
+ *                    woken up on a drop and on connect
+ */
+TickType_t droppedTagsTimeout() {
+  if(droppedUnknownTags.load() == reportedUnknownTags || !mqttClient.connected()) {
+    return portMAX_DELAY;
+  }
+  unsigned long elapsed = millis() - unknownTagsReported;
+  return elapsed >= NFC_UNKNOWN_INTERVAL ? 0 : pdMS_TO_TICKS(NFC_UNKNOWN_INTERVAL - elapsed);
+}
+
+/**
+ * @brief How long the publisher may sleep before the events collected for 
+ *        the flash log are due to be written
+ * 
+ * @return TickType_t ticks until the flush, portMAX_DELAY if nothing was 
+ *                    collected
+ */
+TickType_t logFlushTimeout() {
+  if(!eventLogMounted || !eventLog.pageLength) {
+    return portMAX_DELAY;
+  }
+  unsigned long elapsed = millis() - logCollected;
+  return elapsed >= LOG_FLUSH_INTERVAL ? 0 : pdMS_TO_TICKS(LOG_FLUSH_INTERVAL - elapsed);
+}
+
+/**
+ * @brief How long the publisher may sleep before the current batch is due
+ * 
+ * @return TickType_t ticks until the batch window closes, portMAX_DELAY if 
+ *                    there is no open batch
+ */
+TickType_t batchTimeout() {
+  if(!batchCount) {
+    return portMAX_DELAY;
+  }
+  unsigned long elapsed = millis() - batchStarted;
+  return elapsed >= BATCH_WINDOW ? 0 : pdMS_TO_TICKS(BATCH_WINDOW - elapsed);
+}
+
+/**
+ * @brief How long the publisher may sleep before the metrics are due
+ * 
+ * @return TickType_t ticks until the metrics interval ends, portMAX_DELAY if 
+ *                    metrics are disabled
+ */
+TickType_t metricsTimeout() {
+  if(!METRICS_ENABLED) {
+    return portMAX_DELAY;
+  }
+  unsigned long elapsed = millis() - metricsStarted;
+  return elapsed >= METRICS_INTERVAL ? 0 : pdMS_TO_TICKS(METRICS_INTERVAL - elapsed);
+}
+
+/**
+ * @brief Publishes the latency histograms of the ending interval and starts 
+ *        a new one
+ * 
+ */
+void publishMetrics() {
+  unsigned long now = millis();
+  for(size_t i = 0; i < METRIC_COUNT; i++) {
+    takeLatencyInterval(&metrics[i], &reportedMetrics[i], &intervalMetrics[i]);
+  }
+  size_t length = writeMetricsPayload(metricsPayload, sizeof(metricsPayload), now - metricsStarted, intervalMetrics, METRIC_NAMES, METRIC_COUNT);
+  metricsStarted = now;
+  publishPayload(METRICS_TOPIC, false, metricsPayload, length);
+}
+
+/**
+ * @brief Publishes the periods, budgets and counters of all scheduled sensor
+ *        polls. The counters are copied while the tasks run, a report may be
+ *        a poll behind
+ * 
+ */
+void publishSchedule() {
+  size_t count = 0;
+  for(uint8_t i = 0; i < sensorSchedule.count; i++) {
+    scheduleReport[count++] = sensorSchedule.tasks[i];
+  }
+  for(uint8_t i = 0; i < loopSchedule.count; i++) {
+    scheduleReport[count++] = loopSchedule.tasks[i];
+  }
+  size_t length = writeSchedulePayload(schedulePayload, sizeof(schedulePayload), scheduleReport, count);
+  publishPayload(SCHEDULE_TOPIC, false, schedulePayload, length);
+
+  if(DEBUG) {
+    for(size_t i = 0; i < count; i++) {
+      if(scheduleReport[i].misses || scheduleReport[i].overruns) {
+        Serial.print("Deadline misses of ");
+        Serial.print(scheduleReport[i].name);
+        Serial.print(": ");
+        Serial.print(scheduleReport[i].misses);
+        Serial.print(" Overruns: ");
+        Serial.println(scheduleReport[i].overruns);
+      }
     }
-    nfc.begin();
   }
 }
 
 /**
- * @brief Read the expected data from NFC tag
+ * @brief Publishes the transactions and the time each device held and 
+ *        waited for the I2C bus. Like the schedule, the counters are copied 
+ *        while the devices use the bus
  * 
- * @return t_nfc_data* data read from NFC tag as defined in the typedef.
- *                     nullptr if no tag was present.
  */
-t_nfc_data* readNFC() {
-  // We're using a simple mutex to prevent the loop from reading the same tag
-  // over and over again if it is held against the antenna. 
-  if (nfc.tagPresent(NFC_TIMEOUT) && !nfcMutex) {
-    nfcMutex = true;
-    NfcTag tag = nfc.read();
-    String type = tag.getTagType();
-    String uid = tag.getUidString();
-    
-    // By default the UID won't be separated by colons - which I found fancier
-    uid.replace(" ", ":");
-    
-    if(DEBUG) {
-      Serial.println("Read NFC");
-      Serial.print("Type: ");
-      Serial.println(type);
-      Serial.print("UID: ");
-      Serial.println(uid);
-    }
-
-    // Build Data and return
-    t_nfc_data *result;
-    result = (t_nfc_data*) malloc(sizeof(t_nfc_data));
-    result->type = type.c_str();
-    result->uid = uid.c_str();
-
-    return result;
-  }
-  
-  // We're freeing the mutex if no tag is present
-  if(!nfc.tagPresent(NFC_TIMEOUT)) {
-    nfcMutex = false;
-  }
-  return nullptr;
+void publishBus() {
+  size_t length = writeBusPayload(busPayload, sizeof(busPayload), i2cBus.devices(), i2cBus.deviceCount());
+  publishPayload(BUS_TOPIC, false, busPayload, length);
 }
 
 /**
- * @brief Read the expected data from IR sensor
+ * @brief Publishes the buffered trace records as raw binary on the trace 
+ *        topic, in chunks of TRACE_CHUNK_RECORDS. Recording is paused 
+ *        meanwhile and the published records are dropped afterwards.
+ *        Decode with tools/trace2chrome.cpp
  * 
- * @return t_ir_data* data read from IR signal tag as defined in the typedef.
- *                     nullptr if no signal was present.
  */
-t_ir_data* readIR()
-{
-  if (irReceiver.decode(&results))
-  {
-    uint32_t code = (uint32_t)strtol(resultToHexidecimal(&results).c_str(), NULL, 0);
-    uint16_t command = (&results)->command;
-    t_ir_data *result;
-    result = (t_ir_data*) malloc(sizeof(t_ir_data));
-    result->code = code;
-    result->command = command;
-
-    if(DEBUG) {
-      Serial.print("Code (Hex): ");
-      Serial.println(code);
-      Serial.print("Command: ");
-      Serial.println(command);
-      Serial.print(resultToHumanReadableBasic(&results));
-      Serial.println(resultToSourceCode(&results));
+void publishTrace() {
+  uint32_t index;
+  uint32_t end = pauseTrace(&index);
+  while(index != end) {
+    size_t count = 0;
+    while(index != end && count < TRACE_CHUNK_RECORDS) {
+      memcpy(tracePayload + count * sizeof(t_trace_record), traceRecordAt(index), sizeof(t_trace_record));
+      count++;
+      index++;
     }
-
-    irReceiver.resume();
-
-    return result;
+    publishPayload(TRACE_TOPIC, false, tracePayload, count * sizeof(t_trace_record));
   }
-  return nullptr;
+  resumeTrace(true);
 }
 
 /**
- * @brief Read Data from the sound sensor
+ * @brief Prints the buffered trace records as hex, one "trace:" line each.
+ *        Recording is paused meanwhile, the records stay buffered. Decode 
+ *        the monitor log with tools/trace2chrome.cpp
  * 
- * @return t_sound_data* data read from sound sensor tag as defined in the typedef.
  */
-t_sound_data* readSound() {
-  uint16_t measurement = analogRead(SOUND);
-  t_sound_data *result = (t_sound_data*) malloc(sizeof(t_sound_data));
-  result->value = measurement;
-  return result;
+void dumpTraceSerial() {
+  static const char HEX_DIGITS[] = "0123456789abcdef";
+  uint32_t index;
+  uint32_t end = pauseTrace(&index);
+  for(; index != end; index++) {
+    const uint8_t* bytes = (const uint8_t*) traceRecordAt(index);
+    char line[7 + 2 * sizeof(t_trace_record)] = "trace:";
+    for(size_t i = 0; i < sizeof(t_trace_record); i++) {
+      line[6 + 2 * i] = HEX_DIGITS[bytes[i] >> 4];
+      line[7 + 2 * i] = HEX_DIGITS[bytes[i] & 0x0F];
+    }
+    line[sizeof(line) - 1] = '\0';
+    Serial.println(line);
+  }
+  resumeTrace(false);
 }
 
 /**
- * @brief Reads Data from all enabled sensors. If data is present they will be streamlined
- *        into their defined sensor topic.
+ * @brief Publishes a sensor event right away or collects it for the next batch
  * 
+ * @param event event to be published
  */
-void readAndPublishSensors() {
-  if(S_IR_ENABLED) {
-    t_ir_data* ir_data = readIR();
-    if(ir_data) {
-      // Parse data to JSON
-      DynamicJsonDocument doc(512);
-      doc["code"] = ir_data->code; 
-      doc["command"] = ir_data->command;
-      String json = String("");
-      serializeJson(doc, json);
+void onSensorEvent(const t_sensor_event& event) {
+  // Keep the order, nothing new is published before the backlog was replayed
+  if(!mqttClient.connected() || hasOfflineEvents()) {
+    keepBatchOffline();
+    keepOffline(event);
+    return;
+  }
 
-      // Publish under IR Sensor Topic
-      mqttClient.publish(IR_SENSOR_TOPIC.c_str(), 0, false, json.c_str());
+  if(!BATCHING_ENABLED) {
+    if(!publishSensorEvent(event)) {
+      keepOffline(event);
     }
+    return;
   }
-  if(S_SOUND_ENABLED) {
-    t_sound_data* sound_data = readSound();
-    if(sound_data) {
-      // Parse data to JSON
-      DynamicJsonDocument doc(512);
-      doc["value"] = sound_data->value; 
-      String json = String("");
-      serializeJson(doc, json);
 
-      // Publish under IR Sensor Topic
-      mqttClient.publish(SOUND_SENSOR_TOPIC.c_str(), 0, false, json.c_str());
-    }
+  if(!batchCount) {
+    batchStarted = millis();
   }
-  if(S_NFC_ENABLED) {
-    t_nfc_data* nfc_data = readNFC();
-    if(nfc_data) {
-      // Parse data to JSON
-      DynamicJsonDocument doc(512);
-      doc["uid"] = nfc_data->uid; 
-      doc["type"] = nfc_data->type; 
-      String json = String("");
-      serializeJson(doc, json);
-      
-      // Publish under IR Sensor Topic
-      mqttClient.publish(NFC_SENSOR_TOPIC.c_str(), 0, false, json.c_str());
-    }
+  batch[batchCount++] = event;
+  if(batchCount == BATCH_MAX_EVENTS) {
+    publishBatch();
+  }
+}
+
+/**
+ * @brief Publishes all queued sensor data into their defined sensor topic.
+ *        Runs in the publisher task.
+ * 
+ */
+void publishSensorEvents() {
+  t_sensor_event event;
+  while(sensorEvents.pop(event)) {
+    onSensorEvent(event);
+  }
+  while(nfcEvents.pop(event)) {
+    onSensorEvent(event);
   }
 }
 
@@ -402,20 +1287,55 @@ void readAndPublishSensors() {
 /**************************************************************************/
 
 /**
- * @brief Publish a node state to mqtt
+ * @brief Queue a node state to be published to mqtt
  * 
  * @param state state to be published
  */
 void publishState(State state) {
-  // Build JSON
-  DynamicJsonDocument doc(128);
-  doc["state"] = state;
-  doc["node"] = NODE_IDENTIFIER.c_str(); 
-  String json = String("");
-  serializeJson(doc, json);
+  t_state_data state_data;
+  state_data.state = state;
+  queueEvent(stateEvents, state_data);
+}
+
+/**
+ * @brief Publishes the boot times, right after the first state was published.
+ *        The time of the first state is the startup time of the build
+ * 
+ */
+void publishBoot() {
+  for(size_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+    bootReport[i] = bootTimes[i];
+  }
+  size_t length = writeBootPayload(bootPayload, sizeof(bootPayload), FIRMWARE_BUILD, bootReport, BOOT_PHASE_NAMES, BOOT_PHASE_COUNT);
+  publishPayload(BOOT_TOPIC, true, bootPayload, length);
+
+  if(DEBUG) {
+    Serial.print("Boot times (ms):");
+    for(size_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+      Serial.print(" ");
+      Serial.print(BOOT_PHASE_NAMES[i]);
+      Serial.print("=");
+      Serial.print(bootReport[i]);
+    }
+    Serial.println();
+  }
+}
 
-  // Publish into state Topic. Retain last message
-  mqttClient.publish(STATE_TOPIC.c_str(), 0, true, json.c_str());
+/**
+ * @brief Publishes all queued node states. Runs in the publisher task.
+ * 
+ */
+void publishStateEvents() {
+  t_state_data state_data;
+  while(stateEvents.pop(state_data)) {
+    size_t length = writeStatePayload(statePayload, sizeof(statePayload), state_data.state, NODE_IDENTIFIER.c_str());
+
+    // Publish into state Topic. Retain last message
+    if(publishPayload(STATE_TOPIC, true, statePayload, length) && !reachedBootPhase(BOOT_STATE)) {
+      reachBootPhase(BOOT_STATE);
+      publishBoot();
+    }
+  }
 }
 
 /**
@@ -423,11 +1343,7 @@ void publishState(State state) {
  * 
  */
 void setupPresentation() {
-  if(P_LCD_ENABLED) {
-    // LCD
-    lcd.begin(16, 2);
-    lcd.display();
-  }
+  presentation.setup();
 }
 
 /**
@@ -442,17 +1358,7 @@ void onEnableNode() {
   }
 
   enabled = true;
-
-  if(P_LED_ENABLED) { 
-    digitalWrite(LED, HIGH);
-  }
-
-  if(P_LCD_ENABLED) {
-    lcd.setRGB(0, 255, 0);
-    lcd.clear();
-    lcd.setCursor(0, 0);
-    lcd.print("ENABLED");
-  }
+  presentation.present(true);
 
   publishState(ON);
 }
@@ -469,17 +1375,7 @@ void onDisableNode() {
   }
 
   enabled = false;
-  
-  if(P_LED_ENABLED) {
-    digitalWrite(LED, LOW);
-  }
-
-  if(P_LCD_ENABLED) {
-    lcd.setRGB(255, 0, 0);
-    lcd.clear();
-    lcd.setCursor(0, 0);
-    lcd.print("DISABLED");
-  }
+  presentation.present(false);
 
   publishState(OFF);
 }
@@ -501,42 +1397,194 @@ void onToggleNode() {
   }
 }
 
+/**
+ * @brief Executes a command on this node
+ * 
+ * @param cmd command to execute
+ */
+void runCommand(Command cmd) {
+  TRACE_INSTANT(TRACE_COMMAND, cmd, 0);
+  // Well okay, what should I do?
+  switch (cmd)
+  {
+    case DISABLE:
+      onDisableNode();
+      break;
+    
+    case ENABLE:
+      onEnableNode();
+      break;
+
+    case TOGGLE:
+      onToggleNode();
+      break;
+    
+    default:
+      Serial.println("Unsupported command");
+      break;
+  }
+}
+
+/**
+ * @brief Executes the command of a local rule right away, without waiting
+ *        for the coordinator
+ * 
+ * @param action action of the matching rule
+ */
+void onLocalAction(RuleAction action) {
+  if(DEBUG) {
+    Serial.print("Local rule matched: ");
+    Serial.println(action);
+  }
+  // Rule actions share their values with the commands
+  runCommand((Command) action);
+}
+
+/**
+ * @brief Hands a received config to loop(). Runs in the MQTT callback, which
+ *        must not parse or write flash
+ * 
+ * @param payload JSON config
+ * @param len length of the payload
+ */
+void queueConfig(const char* payload, size_t len) {
+  if(len > CONFIG_MAX_SIZE) {
+    Serial.println("Config too large, ignored");
+    return;
+  }
+
+  t_config_message& config = receivedConfigs.back();
+  memcpy(config.payload, payload, len);
+  config.length = len;
+  receivedConfigs.publish();
+}
+
+/**
+ * @brief Compiles the rules of the config message into the inactive rule 
+ *        table and activates it. Only called by loop() (and setup())
+ * 
+ * @param payload JSON config, e.g. {"ir":{"toggle":[...],"on":[...],"off":[...]},"nfc":{"toggle":["8E:FC:5B:22"]}}
+ * @param len length of the payload
+ */
+boolean onConfig(const char* payload, size_t len) {
+  DeserializationError error = deserializeJson(configDoc, payload, len);
+  if (error) {
+    Serial.println("Failed to read config");
+    Serial.println(error.f_str());
+    return false;
+  }
+
+  t_node_rules* rules = activeRules.load() == &ruleTables[0] ? &ruleTables[1] : &ruleTables[0];
+  // Odd while the inactive table is rewritten, readers still on it match again
+  rulesGeneration.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  if(!readRules(configDoc, rules)) {
+    Serial.println("Config contains invalid or too many rules, ignored those");
+  }
+
+  activeRules.store(rules, std::memory_order_release);
+  rulesGeneration.fetch_add(1, std::memory_order_release);
+
+  if(DEBUG) {
+    Serial.print("Rules loaded - IR: ");
+    Serial.print(rules->irCount);
+    Serial.print(" NFC: ");
+    Serial.println(rules->nfc.count);
+  }
+  return true;
+}
+
+/**
+ * @brief Keeps the config in flash. The config is retained and arrives on
+ *        every reconnect, so it's only written if it changed
+ * 
+ * @param payload JSON config
+ * @param len length of the payload
+ */
+void storeConfig(const char* payload, size_t len) {
+  if(len > CONFIG_MAX_SIZE) {
+    return;
+  }
+
+  size_t storedLen = preferences.getBytes("config", storedConfig, sizeof(storedConfig));
+  if(storedLen == len && memcmp(storedConfig, payload, len) == 0) {
+    return;
+  }
+
+  preferences.putBytes("config", payload, len);
+  if(DEBUG) {
+    Serial.println("Stored config in flash");
+  }
+}
+
+/**
+ * @brief Loads the rules of the config stored in flash
+ */
+void loadConfig() {
+  preferences.begin("node", false);
+
+  size_t storedLen = preferences.getBytes("config", storedConfig, sizeof(storedConfig));
+  if(storedLen > 0) {
+    onConfig(storedConfig, storedLen);
+  }
+}
+
 /**
  * @brief The command handler which handles received commmands
  * 
  * @param command command received
  */
 void onCommand(t_node_command* command) {
-  // What is the affected node?
-  String node = String(command->node);
-  // Which command?
-  Command cmd = command->command;
-
-  // Am I affected?
-  if(node.equals(NODE_IDENTIFIER)) {
-    // Well okay, what should I do?
-    switch (cmd)
-    {
-      case DISABLE:
-        onDisableNode();
-        break;
-      
-      case ENABLE:
-        onEnableNode();
-        break;
-
-      case TOGGLE:
-        onToggleNode();
-        break;
-      
-      default:
-        Serial.println("Unsupported command");
-        break;
+  // Whether I'm affected was decided on receipt
+  runCommand(command->command);
+}
+
+/**
+ * @brief Parses a command received on the node, a group or the broadcast
+ *        topic and queues it for loop() if it addresses this node
+ * 
+ * @param topicId topic the command was received on
+ * @param message JSON command, e.g. {"node":"node-1","command":2},
+ *                {"command":2} or {"nodes":5,"command":2}
+ * @param len length of the message
+ */
+void onCommandMessage(uint8_t topicId, const char* message, size_t len) {
+  // Parse JSON Content
+  StaticJsonDocument<512> doc;
+  DeserializationError error = deserializeJson(doc, message, len);
+
+  if (error) {
+    Serial.println("Failed to read payload");
+    Serial.println(error.f_str());
+    return;
+  }
+
+  // Am I affected? Every member of a group is
+  CommandScope scope = topicId == TOPIC_COMMAND ? SCOPE_NODE : topicId == TOPIC_GROUP ? SCOPE_GROUP : SCOPE_BROADCAST;
+  t_node_command command;
+  CommandResult result = readCommand(doc, scope, NODE_IDENTIFIER.c_str(), NODE_INDEX, &command);
+  if(result == COMMAND_NOT_ADDRESSED) {
+    if(scope == SCOPE_NODE) {
+      Serial.print(doc["node"] | "");
+      Serial.println(" does not match node identifier");
     }
-  } else {
-    Serial.print(node);
-    Serial.print(" does not match node identifier ");
-    Serial.println(cmd);
+    return;
+  }
+  if(result == COMMAND_INVALID) {
+    Serial.println("Unsupported command");
+    return;
+  }
+
+  if(DEBUG) {
+    Serial.println("Parsed Command");
+    Serial.print("Command: ");
+    Serial.println(command.command);
+  }
+
+  // The command handler is called by loop()
+  if(!commands.push(command)) {
+    droppedCommands++;
+    Serial.println("Command queue full, dropped command");
   }
 }
 /**************************************************************************/
@@ -550,23 +1598,51 @@ void onCommand(t_node_command* command) {
 // Callback for the MQTT Connection Event
 void onMqttConnect(bool sessionPresent)
 {
+  reachBootPhase(BOOT_MQTT);
+  resetBackoff(&mqttBackoff);
   if(DEBUG) {
     Serial.println("Connected to MQTT.");
     Serial.print("Session present: ");
     Serial.println(sessionPresent);
+  }
 
-    // We subscribe in the callback to re-subscribe on re-connection
-    uint16_t packetIdSub = mqttClient.subscribe(COMMAND_TOPIC.c_str(), 2);
+  // We subscribe in the callback to re-subscribe on re-connection
+  uint16_t packetIdSub = mqttClient.subscribe(COMMAND_TOPIC.c_str(), 2);
+  uint16_t packetIdConfig = mqttClient.subscribe(CONFIG_TOPIC.c_str(), 1);
+  if(NODE_GROUP_NAME) {
+    mqttClient.subscribe(GROUP_TOPIC.c_str(), 2);
+  }
+  mqttClient.subscribe(BROADCAST_TOPIC.c_str(), 2);
+  if(TRACING_ENABLED) {
+    mqttClient.subscribe(TRACE_DUMP_TOPIC.c_str(), 0);
+  }
+  if(DEBUG) {
     Serial.print("Subscribing at QoS 2, packetId: ");
     Serial.println(packetIdSub);
+    Serial.print("Subscribing to config at QoS 1, packetId: ");
+    Serial.println(packetIdConfig);
+  }
+
+  // A state published while disconnected got lost, the broker retains the one
+  // loop() queues now. Only loop() feeds the state queue, the publisher is 
+  // woken up here to replay the offline events
+  stateRequested = true;
+  if(publisherTaskHandle) {
+    xTaskNotifyGive(publisherTaskHandle);
   }
 }
 
-// Callback for disconnection - lame
+// Callback for disconnection, also called if a connection attempt failed.
+// Without WiFi the reconnect waits for an IP address
 void onMqttDisconnect(AsyncMqttClientDisconnectReason reason)
 {
   if(DEBUG) {
-    Serial.println("Disconnected from MQTT.");
+    Serial.print("Disconnected from MQTT, reason: ");
+    Serial.println((int) reason);
+  }
+
+  if(WiFi.isConnected()) {
+    scheduleReconnect(mqttReconnectTimer, &mqttBackoff, "MQTT");
   }
 }
 
@@ -611,46 +1687,49 @@ void onMqttMessage(char *topic, char *payload, AsyncMqttClientMessageProperties
     Serial.println(index);
     Serial.print("  total: ");
     Serial.println(total);
-    Serial.print("  payload: ");
-    Serial.println(payload);
-  }
-
-  // If the message was received on the command topic
-  if(String(topic).equals(String(COMMAND_TOPIC))) {
-    // Parse JSON Content
-    StaticJsonDocument<128> doc;
-    DeserializationError error = deserializeJson(doc, payload);
-
-    if (error) {
-      Serial.println("Failed to read payload");
-      Serial.println(error.f_str());
-    } else {
-      
-      // Parse into the command type
-      t_node_command *command;
-      command = (t_node_command*) malloc(sizeof(t_node_command));
-      
-      const char* node = doc["node"];
-      int cmd = doc["command"];
-
-      command->node = node;
-      command->command = (Command) cmd;
-
-      if(DEBUG) {
-        Serial.println("Parsed Command");
-        Serial.print("Node: ");
-        Serial.println(command->node);
-        Serial.print("Command: ");
-        Serial.println(command->command);
-      }
+  }
 
-      // Call the command handler with the received command
-      onCommand(command);
-    }
-  } else {
+  uint8_t topicId = dispatchTopic(&topics, topic);
+  if(topicId == TOPIC_UNKNOWN) {
     if(DEBUG) {
       Serial.println("No Matching topic");
     }
+    return;
+  }
+
+  // Wait for the remaining chunks, the payload is only parsed as a whole
+  char* message = assemblePayload(&incoming, payload, len, index, total);
+  if(!message) {
+    if(DEBUG && total > MQTT_PAYLOAD_MAX_SIZE) {
+      Serial.println("Payload too large, dropped");
+    }
+    return;
+  }
+
+  if(DEBUG) {
+    Serial.print("  payload: ");
+    Serial.println(message);
+  }
+
+  switch (topicId)
+  {
+    case TOPIC_COMMAND:
+    case TOPIC_GROUP:
+    case TOPIC_BROADCAST:
+      onCommandMessage(topicId, message, total);
+      break;
+
+    case TOPIC_CONFIG:
+      queueConfig(message, total);
+      break;
+
+    case TOPIC_TRACE_DUMP:
+      traceDumpRequested = true;
+      // Messages can arrive before setupTasks() created the publisher
+      if(publisherTaskHandle) {
+        xTaskNotifyGive(publisherTaskHandle);
+      }
+      break;
   }
 }
 
@@ -671,6 +1750,7 @@ void onWiFiEvent(WiFiEvent_t event)
   switch (event)
   {
     case SYSTEM_EVENT_STA_GOT_IP:
+      reachBootPhase(BOOT_WIFI);
       Serial.println("WiFi connected");
       Serial.println("IP address: ");
       Serial.println(WiFi.localIP());
@@ -678,10 +1758,15 @@ void onWiFiEvent(WiFiEvent_t event)
       Serial.println(WiFi.macAddress());
 
       // We're connecting to the MQTT Broker right after a WiFi Connection was established
+      resetBackoff(&wifiBackoff);
+      xTimerStop(wifiReconnectTimer, 0);
       connectToMqtt();
       break;
     case SYSTEM_EVENT_STA_DISCONNECTED:
+      // Also raised for every failed attempt, so the backoff keeps growing
       Serial.println("WiFi lost connection");
+      xTimerStop(mqttReconnectTimer, 0);
+      scheduleReconnect(wifiReconnectTimer, &wifiBackoff, "WiFi");
       break;
     default:
       break;
@@ -690,23 +1775,191 @@ void onWiFiEvent(WiFiEvent_t event)
 /**************************************************************************/
 #pragma endregion
 
+/***** Tasks ******/
+#pragma region
+/**************************************************************************/
+
+/**
+ * @brief Reads the NFC sensor. Known tags trigger their action right away,
+ *        all tags are queued for the publisher. Runs in loop(), scheduled 
+ *        every NFC_PERIOD
+ * 
+ */
+void pollNFC() {
+  t_sensor_event event;
+  uint32_t nfcStart = startMeasurement();
+  TRACE_BEGIN(TRACE_NFC_READ, 0, 0);
+  boolean nfcRead = readNFC(&event);
+  TRACE_END(TRACE_NFC_READ, 0, nfcRead);
+  endMeasurement(METRIC_NFC, nfcStart);
+  if(!reachedBootPhase(BOOT_NFC) && nfcSensor.ready()) {
+    reachBootPhase(BOOT_NFC);
+  }
+  if(!nfcRead) {
+    return;
+  }
+  if(event.nfc.action == RULE_KNOWN) {
+    // The coordinator switches the nodes of the tag
+    event.nfc.action = RULE_NONE;
+    queueEvent(nfcEvents, event);
+  } else if(event.nfc.action != RULE_NONE) {
+    onLocalAction((RuleAction) event.nfc.action);
+    queueEvent(nfcEvents, event);
+  } else if(allowUnknownTag(&unknownTags, event.timestamp)) {
+    queueEvent(nfcEvents, event);
+  } else {
+    // Someone is trying tags, don't flood the network with them
+    uint32_t dropped = ++droppedUnknownTags;
+    if(publisherTaskHandle) {
+      xTaskNotifyGive(publisherTaskHandle);
+    }
+    if(DEBUG) {
+      Serial.print("Dropped unknown tag, dropped so far: ");
+      Serial.println(dropped);
+    }
+  }
+}
+
+/**
+ * @brief Adds a sensor poll to a schedule, a rejected one is reported as 
+ *        the sensor isn't read then
+ * 
+ */
+void scheduleSensor(t_scheduler* scheduler, const char* name, t_task_function poll, uint32_t period, uint32_t budget) {
+  if(addScheduledTask(scheduler, name, poll, period, budget, schedulerClock()) < 0) {
+    Serial.print("Schedule rejected ");
+    Serial.println(name);
+  }
+}
+
+/**
+ * @brief Schedules the polls of the enabled sensors
+ * 
+ */
+void setupSchedule() {
+  initScheduler(&sensorSchedule);
+  initScheduler(&loopSchedule);
+  if(S_IR_ENABLED) {
+    scheduleSensor(&sensorSchedule, "ir", pollIR, IR_PERIOD, IR_BUDGET);
+  }
+  if(S_SOUND_ENABLED) {
+    scheduleSensor(&sensorSchedule, "sound", pollSound, SOUND_PERIOD, SOUND_BUDGET);
+  }
+  if(S_NFC_ENABLED) {
+    scheduleSensor(&loopSchedule, "nfc", pollNFC, NFC_PERIOD, NFC_BUDGET);
+  }
+}
+
+/**
+ * @brief Polls IR and sound by their schedule. Pinned to SENSOR_CORE so that
+ *        slow PN532 transactions in loop() can't delay it.
+ * 
+ * @param parameter unused
+ */
+void sensorTask(void* parameter) {
+  for(;;) {
+    uint32_t idle = runScheduler(&sensorSchedule, schedulerClock);
+    // Sleep until the next poll is due, at least a tick so the idle task on
+    // this core can feed the watchdog
+    if(idle) {
+      TickType_t ticks = pdMS_TO_TICKS(idle / 1000);
+      vTaskDelay(ticks ? ticks : 1);
+    }
+  }
+}
+
+/**
+ * @brief Sleeps until an event was queued or the batch window closed and
+ *        publishes everything queued.
+ * 
+ * @param parameter unused
+ */
+void publisherTask(void* parameter) {
+  uint32_t reportedDrops = 0;
+  for(;;) {
+    // Sleep until the earlier of the batch window and the metrics interval
+    TickType_t timeout = batchTimeout();
+    TickType_t metricsDue = metricsTimeout();
+    TickType_t replayDue = replayTimeout();
+    TickType_t flushDue = logFlushTimeout();
+    TickType_t droppedTagsDue = droppedTagsTimeout();
+    timeout = metricsDue < timeout ? metricsDue : timeout;
+    timeout = replayDue < timeout ? replayDue : timeout;
+    timeout = droppedTagsDue < timeout ? droppedTagsDue : timeout;
+    ulTaskNotifyTake(pdTRUE, flushDue < timeout ? flushDue : timeout);
+    publishStateEvents();
+    if(mqttClient.connected()) {
+      replayOfflineEvents();
+      publishDroppedTags();
+    }
+    publishSensorEvents();
+
+    if(batchCount && millis() - batchStarted >= BATCH_WINDOW) {
+      publishBatch();
+    }
+
+    // Collected events are written in pages, but don't wait for long in RAM
+    if(eventLogMounted && eventLog.pageLength && millis() - logCollected >= LOG_FLUSH_INTERVAL) {
+      flushLog(&eventLog);
+    }
+
+    if(METRICS_ENABLED && millis() - metricsStarted >= METRICS_INTERVAL) {
+      publishMetrics();
+      publishSchedule();
+      publishBus();
+    }
+
+    if(TRACING_ENABLED && traceDumpRequested.exchange(false)) {
+      publishTrace();
+    }
+
+    if(DEBUG && droppedEvents != reportedDrops) {
+      reportedDrops = droppedEvents;
+      Serial.print("Dropped events: ");
+      Serial.println(reportedDrops);
+    }
+  }
+}
+
+/**
+ * @brief Starts the publisher and - if any of its sensors is enabled - the sensor task
+ * 
+ */
+void setupTasks() {
+  cyclesPerUs = ESP.getCpuFreqMHz();
+  metricsStarted = millis();
+  setupSchedule();
+  xTaskCreatePinnedToCore(publisherTask, "publisher", PUBLISHER_TASK_STACK, NULL, 2, &publisherTaskHandle, SENSOR_CORE);
+
+  if(S_IR_ENABLED || S_SOUND_ENABLED) {
+    xTaskCreatePinnedToCore(sensorTask, "sensors", SENSOR_TASK_STACK, NULL, 1, NULL, SENSOR_CORE);
+  }
+}
+/**************************************************************************/
+#pragma endregion
+
 /***** Arduino Lifecycle ******/
 #pragma region
 
 /**************************************************************************/
 void setup()
 {
+  reachBootPhase(BOOT_SETUP);
   Serial.begin(115200);
 
-  while (!Serial)
-  {
-  }
-
-  if(DEBUG) {
-    i2c_scanner();
+  // Rules from the last config, until the broker sends the current one
+  loadConfig();
+  initTagRateLimiter(&unknownTags, NFC_UNKNOWN_BURST, NFC_UNKNOWN_INTERVAL, millis());
+  // Events of the last boot that weren't published yet are replayed on connect
+  if(FLASH_LOG_ENABLED) {
+    mountEventLog();
   }
 
-  pinMode(LED, OUTPUT);
+  // Reconnects are started by timers, delayed by the backoff
+  initBackoff(&wifiBackoff, WIFI_RECONNECT_MIN, WIFI_RECONNECT_MAX);
+  initBackoff(&mqttBackoff, MQTT_RECONNECT_MIN, MQTT_RECONNECT_MAX);
+  wifiReconnectTimer = xTimerCreate("wifiReconnect", pdMS_TO_TICKS(WIFI_RECONNECT_MIN), pdFALSE, NULL, onWifiReconnectTimer);
+  mqttReconnectTimer = xTimerCreate("mqttReconnect", pdMS_TO_TICKS(MQTT_RECONNECT_MIN), pdFALSE, NULL, onMqttReconnectTimer);
 
   // Register Events
   WiFi.onEvent(onWiFiEvent);
@@ -718,18 +1971,84 @@ void setup()
   mqttClient.onPublish(onMqttPublish);
   mqttClient.setServer(MQTT_HOST, MQTT_PORT);
 
-  // Connect to WiFi - MQTT Connection will be established aswell
+  registerTopic(&topics, COMMAND_TOPIC.c_str(), TOPIC_COMMAND);
+  registerTopic(&topics, CONFIG_TOPIC.c_str(), TOPIC_CONFIG);
+  if(NODE_GROUP_NAME) {
+    registerTopic(&topics, GROUP_TOPIC.c_str(), TOPIC_GROUP);
+  }
+  registerTopic(&topics, BROADCAST_TOPIC.c_str(), TOPIC_BROADCAST);
+  if(TRACING_ENABLED) {
+    registerTopic(&topics, TRACE_DUMP_TOPIC.c_str(), TOPIC_TRACE_DUMP);
+  }
+  if(NODE_INDEX >= BROADCAST_MAX_NODES) {
+    Serial.print("Broadcast index ");
+    Serial.print(NODE_INDEX);
+    Serial.println(" is past the bitset, broadcasts are ignored");
+  }
+
+  // Connect to WiFi - MQTT Connection will be established aswell. The 
+  // association runs in the background while the peripherals come up
   connectToWifi();
 
+  i2cBus.begin();
+  if(DEBUG) {
+    i2c_scanner();
+  }
+
+  // The NFC reader isn't waited for, loop() polls until it answers
   setupSensors();
   setupPresentation();
 
   onDisableNode();
+
+  setupTasks();
+  reachBootPhase(BOOT_PERIPHERALS);
 }
 
+// loop() only polls the NFC reader, IR and sound are sampled in the sensor task
 void loop()
 {
-  readAndPublishSensors();
+  uint32_t loopStart = startMeasurement();
+  TRACE_BEGIN(TRACE_LOOP, 0, 0);
+
+  uint32_t idle = runScheduler(&loopSchedule, schedulerClock);
+
+  RuleAction action;
+  while(localActions.pop(action)) {
+    onLocalAction(action);
+  }
+
+  // Call the command handler with the received commands
+  t_node_command command;
+  while(commands.pop(command)) {
+    onCommand(&command);
+  }
+
+  // Apply the latest config, parsing and the flash write stay out of the MQTT task
+  if(receivedConfigs.take()) {
+    const t_config_message& config = receivedConfigs.front();
+    if(onConfig(config.payload, config.length)) {
+      storeConfig(config.payload, config.length);
+    }
+  }
+
+  // Republish the state for the broker after a (re)connect
+  if(stateRequested.exchange(false)) {
+    publishState(enabled ? ON : OFF);
+  }
+
+  // Send a 't' over serial to dump the trace
+  if(TRACING_ENABLED && Serial.available() && Serial.read() == 't') {
+    dumpTraceSerial();
+  }
+
+  TRACE_END(TRACE_LOOP, 0, 0);
+  endMeasurement(METRIC_LOOP, loopStart);
+
+  // Nothing due for a while, commands wait at most a tick meanwhile
+  if(idle >= 1000 * portTICK_PERIOD_MS) {
+    vTaskDelay(1);
+  }
 }
 
 /**************************************************************************/
@@ -0,0 +1,282 @@
+// Sensor events go through the same queues and serializers as in the firmware,
+// from the sensor task's push to the publisher task's payload buffer, while
+// every heap allocation of the process is counted
+
+#include <unity.h>
+#include <SpscQueue.h>
+#include <RingBuffer.h>
+#include <SensorEvent.h>
+#include <SensorJson.h>
+#include <SensorMsgPack.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <new>
+
+// Cycles of each test, enough to wrap the queues many times
+#define CYCLES 1000
+
+namespace {
+
+std::atomic<bool> counting(false);
+std::atomic<size_t> allocations(0);
+
+void count() {
+  if(counting.load(std::memory_order_relaxed)) {
+    allocations++;
+  }
+}
+
+void startCounting() {
+  allocations = 0;
+  counting = true;
+}
+
+size_t stopCounting() {
+  counting = false;
+  return allocations;
+}
+
+// Same capacities as the queues of main.cpp
+SpscQueue<t_sensor_event, 32> sensorEvents;
+SpscQueue<t_sensor_event, 4> nfcEvents;
+RingBuffer<t_sensor_event, 64> offlineEvents;
+
+char irPayload[IR_JSON_SIZE];
+char soundPayload[SOUND_JSON_SIZE];
+char nfcPayload[NFC_JSON_SIZE];
+char acousticPayload[ACOUSTIC_JSON_SIZE];
+char statePayload[STATE_JSON_SIZE];
+uint8_t msgPackPayload[STATE_MSGPACK_SIZE];
+t_sensor_event batch[8];
+char batchPayload[BATCH_JSON_SIZE(8)];
+uint8_t batchMsgPack[BATCH_MSGPACK_SIZE(8)];
+
+t_sensor_event sensorEvent(uint32_t i) {
+  t_sensor_event event;
+  memset(&event, 0, sizeof(event));
+  event.timestamp = i * 10;
+  switch(i % 4) {
+    case 0:
+      event.type = SENSOR_IR;
+      event.ir.code = 0xFFB04F;
+      event.ir.command = 176;
+      event.ir.button = (uint8_t) (i % (IR_BUTTON_SMOOTH + 1));
+      event.ir.action = i % 3 ? SENSOR_NO_ACTION : 2;
+      break;
+    case 1:
+      event.type = SENSOR_SOUND;
+      event.sound.rms = i & 0xFFF;
+      event.sound.peak = (i * 3) & 0xFFF;
+      event.sound.envelope = (i * 2) & 0xFFF;
+      break;
+    case 2:
+      event.type = SENSOR_NFC;
+      event.nfc.uidLength = i % 2 ? 4 : NFC_UID_MAX_LENGTH;
+      for(uint8_t b = 0; b < event.nfc.uidLength; b++) {
+        event.nfc.uid[b] = (uint8_t) (i + b);
+      }
+      event.nfc.tagType = i % 3;
+      event.nfc.action = SENSOR_NO_ACTION;
+      break;
+    default:
+      event.type = SENSOR_ACOUSTIC;
+      event.acoustic.kind = i % 2 ? ACOUSTIC_CLAP : ACOUSTIC_LOUD;
+      event.acoustic.peak = 2000;
+      event.acoustic.duration = 40;
+      event.acoustic.onset = i * 10;
+      break;
+  }
+  return event;
+}
+
+// What publishSensorEvent() serializes for an event, in both encodings
+size_t serialize(const t_sensor_event& event) {
+  switch(event.type) {
+    case SENSOR_IR:
+      return writeIrJson(irPayload, sizeof(irPayload), &event.ir)
+             + writeIrMsgPack(msgPackPayload, sizeof(msgPackPayload), &event.ir);
+    case SENSOR_SOUND:
+      return writeSoundJson(soundPayload, sizeof(soundPayload), &event.sound)
+             + writeSoundMsgPack(msgPackPayload, sizeof(msgPackPayload), &event.sound);
+    case SENSOR_NFC:
+      return writeNfcJson(nfcPayload, sizeof(nfcPayload), &event.nfc)
+             + writeNfcMsgPack(msgPackPayload, sizeof(msgPackPayload), &event.nfc);
+    case SENSOR_ACOUSTIC:
+      return writeAcousticJson(acousticPayload, sizeof(acousticPayload), &event.acoustic)
+             + writeAcousticMsgPack(msgPackPayload, sizeof(msgPackPayload), &event.acoustic);
+  }
+  return 0;
+}
+
+}
+
+// C allocations are counted as well. Only glibc can be wrapped like this,
+// and the sanitizers bring their own allocator
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+#define COUNT_MALLOC
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* p, size_t size);
+
+void* malloc(size_t size) {
+  count();
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+  ::count();
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* p, size_t size) {
+  count();
+  return __libc_realloc(p, size);
+}
+}
+#endif
+
+// Every C++ allocation of the process passes these, counted once each
+namespace {
+
+void* allocate(size_t size) {
+#ifndef COUNT_MALLOC
+  count();
+#endif
+  return malloc(size ? size : 1);
+}
+
+}
+
+void* operator new(size_t size) {
+  void* p = allocate(size);
+  if(!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return allocate(size);
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+  free(p);
+}
+
+void setUp() {
+  t_sensor_event event;
+  while(sensorEvents.pop(event)) {}
+  while(nfcEvents.pop(event)) {}
+  offlineEvents.drop(offlineEvents.size());
+}
+
+void tearDown() {
+  counting = false;
+}
+
+void test_counting_sees_allocations() {
+  // Volatile, so the compiler can't leave the allocations out
+  int* volatile object;
+  startCounting();
+  object = new int(1);
+#ifdef COUNT_MALLOC
+  void* volatile memory = malloc(16);
+  size_t counted = stopCounting();
+  free(memory);
+  TEST_ASSERT_EQUAL(2, counted);
+#else
+  size_t counted = stopCounting();
+  TEST_ASSERT_EQUAL(1, counted);
+#endif
+  delete object;
+}
+
+void test_queue_and_publish_cycles_do_not_allocate() {
+  size_t written = 0;
+  startCounting();
+  for(uint32_t i = 0; i < CYCLES; i++) {
+    // Sensor task and loop() queue, the publisher task drains and serializes
+    sensorEvents.push(sensorEvent(i));
+    nfcEvents.push(sensorEvent(4 * i + 2));
+    t_sensor_event event;
+    while(sensorEvents.pop(event)) {
+      written += serialize(event);
+    }
+    while(nfcEvents.pop(event)) {
+      written += serialize(event);
+    }
+    written += writeStateJson(statePayload, sizeof(statePayload), i & 1, "node-1");
+    written += writeStateMsgPack(msgPackPayload, sizeof(msgPackPayload), i & 1, "node-1");
+  }
+  size_t counted = stopCounting();
+  TEST_ASSERT_GREATER_THAN(0, written);
+  TEST_ASSERT_EQUAL(0, counted);
+}
+
+void test_full_queues_do_not_allocate() {
+  startCounting();
+  uint32_t dropped = 0;
+  for(uint32_t i = 0; i < CYCLES; i++) {
+    if(!sensorEvents.push(sensorEvent(i))) {
+      dropped++;
+    }
+  }
+  size_t counted = stopCounting();
+  TEST_ASSERT_EQUAL(CYCLES - sensorEvents.capacity(), dropped);
+  TEST_ASSERT_EQUAL(0, counted);
+}
+
+void test_batch_and_offline_cycles_do_not_allocate() {
+  size_t written = 0;
+  startCounting();
+  for(uint32_t i = 0; i < CYCLES; i++) {
+    // Kept while disconnected, replayed as a batch once connected
+    offlineEvents.push(sensorEvent(i));
+    if(i % 100 == 99) {
+      while(!offlineEvents.empty()) {
+        size_t count = offlineEvents.size() < 8 ? offlineEvents.size() : 8;
+        for(size_t e = 0; e < count; e++) {
+          batch[e] = offlineEvents.at(e);
+        }
+        written += writeBatchJson(batchPayload, sizeof(batchPayload), batch, count);
+        written += writeBatchMsgPack(batchMsgPack, sizeof(batchMsgPack), batch, count);
+        offlineEvents.drop(count);
+      }
+    }
+  }
+  size_t counted = stopCounting();
+  TEST_ASSERT_GREATER_THAN(0, written);
+  TEST_ASSERT_EQUAL(0, counted);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_counting_sees_allocations);
+  RUN_TEST(test_queue_and_publish_cycles_do_not_allocate);
+  RUN_TEST(test_full_queues_do_not_allocate);
+  RUN_TEST(test_batch_and_offline_cycles_do_not_allocate);
+  return UNITY_END();
+}
@@ -0,0 +1,152 @@
+// Commands flooding in through onCommandMessage() of main.cpp on one thread,
+// like the MQTT callback does, while another thread drains the queue like
+// loop(). Whatever isn't dropped has to arrive in order, and the drop count
+// has to match what went missing
+
+#include <unity.h>
+#include <SpscQueue.h>
+#include <NodeMessages.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Of main.cpp
+extern SpscQueue<t_node_command, 8> commands;
+extern uint32_t droppedCommands;
+void onCommandMessage(uint8_t topicId, const char* message, size_t len);
+
+// Every member of a group is addressed (TOPIC_GROUP of main.cpp)
+#define TOPIC_GROUP 2
+#define FLOOD 20000
+
+namespace {
+
+const char* const MESSAGES[] = {
+  "{\"command\":0}",
+  "{\"command\":1}",
+  "{\"command\":2}"
+};
+
+// Deterministic pseudo-random numbers
+uint32_t randomState = 1;
+
+uint32_t nextRandom() {
+  randomState = randomState * 1103515245UL + 12345UL;
+  return randomState >> 16;
+}
+
+// The handlers log every command, that is kept out of the test output
+int mutedStdout = -1;
+
+void muteSerial() {
+  fflush(stdout);
+  mutedStdout = dup(fileno(stdout));
+  FILE* null = fopen("/dev/null", "w");
+  dup2(fileno(null), fileno(stdout));
+  fclose(null);
+}
+
+void unmuteSerial() {
+  fflush(stdout);
+  dup2(mutedStdout, fileno(stdout));
+  close(mutedStdout);
+}
+
+std::vector<Command> accepted;
+std::vector<Command> received;
+std::atomic<bool> producing;
+std::atomic<size_t> sent;
+
+void drain() {
+  t_node_command command;
+  while(commands.pop(command)) {
+    received.push_back(command.command);
+  }
+}
+
+// The MQTT callback, knows which of its commands were dropped
+void produce(size_t count) {
+  for(size_t i = 0; i < count; i++) {
+    const char* message = MESSAGES[nextRandom() % 3];
+    uint32_t dropped = droppedCommands;
+    onCommandMessage(TOPIC_GROUP, message, strlen(message));
+    if(droppedCommands == dropped) {
+      accepted.push_back((Command) (message[11] - '0'));
+    }
+    sent++;
+  }
+  producing = false;
+}
+
+// loop(), starts late so the queue overflows at least once
+void consume(size_t delay) {
+  while(sent < delay) {
+    std::this_thread::yield();
+  }
+  while(producing) {
+    drain();
+  }
+  drain();
+}
+
+void flood(size_t count, size_t delay) {
+  producing = true;
+  sent = 0;
+  uint32_t droppedBefore = droppedCommands;
+  muteSerial();
+  std::thread consumer(consume, delay);
+  std::thread producer(produce, count);
+  producer.join();
+  consumer.join();
+  unmuteSerial();
+
+  uint32_t dropped = droppedCommands - droppedBefore;
+  TEST_ASSERT_EQUAL(count, accepted.size() + dropped);
+  TEST_ASSERT_EQUAL(accepted.size(), received.size());
+  for(size_t i = 0; i < received.size(); i++) {
+    TEST_ASSERT_EQUAL_MESSAGE(accepted[i], received[i], "Command out of order");
+  }
+}
+
+}
+
+void setUp() {
+  accepted.clear();
+  received.clear();
+  drain();
+  received.clear();
+}
+
+void tearDown() {}
+
+void test_messages_are_parsed_into_commands() {
+  flood(3 * commands.capacity(), 0);
+  TEST_ASSERT_GREATER_THAN(0, received.size());
+}
+
+void test_full_queue_drops_and_counts() {
+  uint32_t droppedBefore = droppedCommands;
+  // Nothing is drained until all of them were sent
+  flood(3 * commands.capacity(), 3 * commands.capacity());
+  TEST_ASSERT_EQUAL(commands.capacity(), received.size());
+  TEST_ASSERT_EQUAL(2 * commands.capacity(), droppedCommands - droppedBefore);
+}
+
+void test_flood_keeps_order() {
+  uint32_t droppedBefore = droppedCommands;
+  flood(FLOOD, 2 * commands.capacity());
+  TEST_ASSERT_GREATER_THAN(0, droppedCommands - droppedBefore);
+  TEST_ASSERT_GREATER_OR_EQUAL(commands.capacity(), received.size());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_messages_are_parsed_into_commands);
+  RUN_TEST(test_full_queue_drops_and_counts);
+  RUN_TEST(test_flood_keeps_order);
+  return UNITY_END();
+}
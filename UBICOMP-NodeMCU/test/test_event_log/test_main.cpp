@@ -0,0 +1,243 @@
+// The flash event log against simulated NOR flash, like tools/eventlog.cpp.
+// Records carry their number, so every read checks the order and what was
+// lost. A remount stands for a reboot, a write budget for a reset mid-write
+
+#include <unity.h>
+#include <EventLog.h>
+
+#include <string.h>
+#include <vector>
+
+#define SECTORS 3
+// Payload of every record, the number of the record and padding
+#define RECORD_LENGTH 60
+
+namespace {
+
+// NOR flash: erasing sets a sector to 0xFF, writing can only clear bits
+struct FlashFile {
+  std::vector<uint8_t> data;
+  // Bytes the flash still takes before it "loses power", -1 for unlimited
+  long budget;
+};
+
+bool flashRead(void* context, uint32_t offset, void* data, size_t length) {
+  FlashFile* flash = (FlashFile*) context;
+  if(offset + length > flash->data.size()) {
+    return false;
+  }
+  memcpy(data, &flash->data[offset], length);
+  return true;
+}
+
+bool flashWrite(void* context, uint32_t offset, const void* data, size_t length) {
+  FlashFile* flash = (FlashFile*) context;
+  if(offset + length > flash->data.size()) {
+    return false;
+  }
+  const uint8_t* bytes = (const uint8_t*) data;
+  for(size_t i = 0; i < length; i++) {
+    if(flash->budget == 0) {
+      return false;
+    }
+    if(flash->budget > 0) {
+      flash->budget--;
+    }
+    flash->data[offset + i] &= bytes[i];
+  }
+  return true;
+}
+
+bool flashErase(void* context, uint32_t offset) {
+  FlashFile* flash = (FlashFile*) context;
+  if(offset % LOG_SECTOR_SIZE || offset + LOG_SECTOR_SIZE > flash->data.size() || flash->budget == 0) {
+    return false;
+  }
+  memset(&flash->data[offset], 0xFF, LOG_SECTOR_SIZE);
+  return true;
+}
+
+FlashFile flash;
+t_log_flash ops;
+t_event_log eventLog;
+// Number of the next record appended
+uint32_t next;
+
+// Records of RECORD_LENGTH that fit into a sector behind its header
+const size_t RECORDS_PER_SECTOR = (LOG_SECTOR_SIZE - sizeof(t_log_sector_header)) / (sizeof(t_log_record_header) + RECORD_LENGTH);
+
+void remount() {
+  flash.budget = -1;
+  TEST_ASSERT_TRUE(mountLog(&eventLog, &ops));
+}
+
+void append(size_t count) {
+  uint8_t payload[RECORD_LENGTH];
+  memset(payload, 0x5A, sizeof(payload));
+  for(size_t i = 0; i < count; i++) {
+    memcpy(payload, &next, sizeof(next));
+    TEST_ASSERT_TRUE(appendLog(&eventLog, payload, sizeof(payload)));
+    next++;
+  }
+}
+
+// Reads up to count pending records, they have to be numbered from first on
+uint32_t readFrom(uint32_t first, size_t count, size_t expected) {
+  uint32_t cursor = startLogRead(&eventLog);
+  uint8_t payload[LOG_RECORD_MAX_SIZE];
+  size_t length;
+  size_t read = 0;
+  while(read < count && (length = readLog(&eventLog, &cursor, payload, sizeof(payload)))) {
+    uint32_t number;
+    memcpy(&number, payload, sizeof(number));
+    TEST_ASSERT_EQUAL(RECORD_LENGTH, length);
+    TEST_ASSERT_EQUAL_MESSAGE(first + read, number, "Record out of order or lost");
+    read++;
+  }
+  TEST_ASSERT_EQUAL(expected, read);
+  return cursor;
+}
+
+// Reads count records numbered from first on and consumes them
+void consume(uint32_t first, size_t count) {
+  consumeLog(&eventLog, readFrom(first, count, count));
+}
+
+}
+
+void setUp() {
+  flash.data.assign(SECTORS * LOG_SECTOR_SIZE, 0xFF);
+  flash.budget = -1;
+  ops = { flashRead, flashWrite, flashErase, &flash, (uint32_t) flash.data.size() };
+  next = 0;
+  remount();
+}
+
+void tearDown() {}
+
+void test_new_log_is_empty() {
+  TEST_ASSERT_EQUAL(0, pendingLogRecords(&eventLog));
+  readFrom(0, SIZE_MAX, 0);
+  remount();
+  TEST_ASSERT_EQUAL(0, pendingLogRecords(&eventLog));
+}
+
+void test_wrap_drops_the_oldest_sector() {
+  // The fourth sector's worth of records erases the first sector again
+  append(SECTORS * RECORDS_PER_SECTOR + 1);
+  TEST_ASSERT_EQUAL(RECORDS_PER_SECTOR, eventLog.dropped);
+  TEST_ASSERT_EQUAL((SECTORS - 1) * RECORDS_PER_SECTOR + 1, pendingLogRecords(&eventLog));
+  readFrom(RECORDS_PER_SECTOR, SIZE_MAX, (SECTORS - 1) * RECORDS_PER_SECTOR + 1);
+
+  // Around once more, the records of a whole turn are dropped
+  append(SECTORS * RECORDS_PER_SECTOR);
+  TEST_ASSERT_EQUAL((SECTORS + 1) * RECORDS_PER_SECTOR, eventLog.dropped);
+  readFrom((SECTORS + 1) * RECORDS_PER_SECTOR, SIZE_MAX, (SECTORS - 1) * RECORDS_PER_SECTOR + 1);
+
+  remount();
+  TEST_ASSERT_EQUAL((SECTORS - 1) * RECORDS_PER_SECTOR + 1, pendingLogRecords(&eventLog));
+  readFrom((SECTORS + 1) * RECORDS_PER_SECTOR, SIZE_MAX, (SECTORS - 1) * RECORDS_PER_SECTOR + 1);
+}
+
+void test_consumed_records_are_not_dropped() {
+  append(2 * RECORDS_PER_SECTOR);
+  consume(0, RECORDS_PER_SECTOR);
+  append(RECORDS_PER_SECTOR + 1);
+  TEST_ASSERT_EQUAL(0, eventLog.dropped);
+  readFrom(RECORDS_PER_SECTOR, SIZE_MAX, 2 * RECORDS_PER_SECTOR + 1);
+}
+
+void test_remount_mid_sector() {
+  append(10);
+  flushLog(&eventLog);
+  remount();
+  TEST_ASSERT_EQUAL(10, pendingLogRecords(&eventLog));
+  readFrom(0, SIZE_MAX, 10);
+
+  // Writing continues behind the records of before
+  append(5);
+  flushLog(&eventLog);
+  remount();
+  TEST_ASSERT_EQUAL(15, pendingLogRecords(&eventLog));
+  readFrom(0, SIZE_MAX, 15);
+}
+
+void test_remount_loses_only_unflushed_records() {
+  append(10);
+  flushLog(&eventLog);
+  append(3);
+  remount();
+  TEST_ASSERT_EQUAL(10, pendingLogRecords(&eventLog));
+  next = 10;
+  append(1);
+  readFrom(0, SIZE_MAX, 11);
+}
+
+void test_write_cut_mid_record() {
+  append(3);
+  flushLog(&eventLog);
+  append(2);
+  // One record and the header and part of the payload of the other
+  flash.budget = sizeof(t_log_record_header) + RECORD_LENGTH + sizeof(t_log_record_header) + 12;
+  TEST_ASSERT_FALSE(flushLog(&eventLog));
+
+  remount();
+  TEST_ASSERT_EQUAL(4, pendingLogRecords(&eventLog));
+  readFrom(0, SIZE_MAX, 4);
+
+  // The cut record fails its CRC and is skipped, the next one follows it
+  next = 5;
+  append(2);
+  flushLog(&eventLog);
+  remount();
+  TEST_ASSERT_EQUAL(6, pendingLogRecords(&eventLog));
+  uint32_t cursor = readFrom(0, 4, 4);
+  uint8_t payload[LOG_RECORD_MAX_SIZE];
+  uint32_t number;
+  TEST_ASSERT_EQUAL(RECORD_LENGTH, readLog(&eventLog, &cursor, payload, sizeof(payload)));
+  memcpy(&number, payload, sizeof(number));
+  TEST_ASSERT_EQUAL(5, number);
+}
+
+void test_consume_then_remount() {
+  append(20);
+  consume(0, 8);
+  TEST_ASSERT_EQUAL(12, pendingLogRecords(&eventLog));
+  remount();
+  TEST_ASSERT_EQUAL(12, pendingLogRecords(&eventLog));
+  readFrom(8, SIZE_MAX, 12);
+}
+
+void test_consume_across_a_sector_then_remount() {
+  append(RECORDS_PER_SECTOR + 10);
+  consume(0, RECORDS_PER_SECTOR + 5);
+  remount();
+  TEST_ASSERT_EQUAL(5, pendingLogRecords(&eventLog));
+  readFrom(RECORDS_PER_SECTOR + 5, SIZE_MAX, 5);
+  // Everything consumed, nothing is read again
+  consume(RECORDS_PER_SECTOR + 5, 5);
+  remount();
+  TEST_ASSERT_EQUAL(0, pendingLogRecords(&eventLog));
+  readFrom(0, SIZE_MAX, 0);
+}
+
+void test_records_have_to_fit() {
+  uint8_t payload[LOG_RECORD_MAX_SIZE + 1] = {};
+  TEST_ASSERT_FALSE(appendLog(&eventLog, payload, 0));
+  TEST_ASSERT_FALSE(appendLog(&eventLog, payload, sizeof(payload)));
+  TEST_ASSERT_EQUAL(0, pendingLogRecords(&eventLog));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_new_log_is_empty);
+  RUN_TEST(test_wrap_drops_the_oldest_sector);
+  RUN_TEST(test_consumed_records_are_not_dropped);
+  RUN_TEST(test_remount_mid_sector);
+  RUN_TEST(test_remount_loses_only_unflushed_records);
+  RUN_TEST(test_write_cut_mid_record);
+  RUN_TEST(test_consume_then_remount);
+  RUN_TEST(test_consume_across_a_sector_then_remount);
+  RUN_TEST(test_records_have_to_fit);
+  return UNITY_END();
+}
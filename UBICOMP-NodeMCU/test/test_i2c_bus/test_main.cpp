@@ -0,0 +1,123 @@
+// Tasks contending for the shared I2C bus on the virtual clock of the native
+// shims. A transaction holds the bus for a while, a high priority one that
+// is waiting gets the bus before low priority ones that waited longer
+
+#include <unity.h>
+#include <Native.h>
+#include <I2cBus.h>
+
+#include <vector>
+
+namespace {
+
+TwoWire wire;
+
+// A task doing transactions of a device
+typedef struct s_client {
+  I2cBus* bus;
+  t_i2c_device* device;
+  uint32_t start;         // ms before the first transaction
+  uint32_t hold;          // ms each transaction holds the bus
+  uint32_t gap;           // ms between the transactions
+  uint32_t repeat;
+  uint32_t longestWait;   // us, of a single transaction
+  uint32_t released;      // us, end of the last transaction
+} t_client;
+
+// Devices in the order they got the bus, only written while holding it
+std::vector<const char*> order;
+
+void clientTask(void* parameter) {
+  t_client* client = (t_client*) parameter;
+  vTaskDelay(client->start);
+  for(uint32_t i = 0; i < client->repeat; i++) {
+    uint32_t wait = client->device->wait;
+    {
+      I2cTransaction transaction(*client->bus, client->device);
+      order.push_back(client->device->name);
+      uint32_t waited = client->device->wait - wait;
+      client->longestWait = waited > client->longestWait ? waited : client->longestWait;
+      vTaskDelay(client->hold);
+    }
+    client->released = micros();
+    vTaskDelay(client->gap);
+  }
+}
+
+// All tasks share a priority, only that of the devices orders them
+void startClient(t_client* client) {
+  xTaskCreatePinnedToCore(clientTask, client->device->name, 2048, client, 1, NULL, 0);
+}
+
+}
+
+void setUp() {
+  order.clear();
+}
+
+void tearDown() {}
+
+void test_single_device_never_waits() {
+  I2cBus bus(wire);
+  bus.begin();
+  t_client lcd = { &bus, bus.addDevice("lcd", I2C_PRIORITY_LOW), 0, 2, 1, 10, 0, 0 };
+  startClient(&lcd);
+  advanceTime(100000);
+  TEST_ASSERT_EQUAL(10, lcd.device->transactions);
+  TEST_ASSERT_EQUAL(10 * 2000, lcd.device->busy);
+  TEST_ASSERT_EQUAL(0, lcd.device->wait);
+}
+
+void test_high_priority_goes_before_a_queued_low_one() {
+  I2cBus bus(wire);
+  bus.begin();
+  // lcd holds the bus from 0 to 5 ms, status queues at 1 ms and nfc at 2 ms
+  t_client lcd = { &bus, bus.addDevice("lcd", I2C_PRIORITY_LOW), 0, 5, 0, 1, 0, 0 };
+  t_client status = { &bus, bus.addDevice("status", I2C_PRIORITY_LOW), 1, 1, 0, 1, 0, 0 };
+  t_client nfc = { &bus, bus.addDevice("nfc", I2C_PRIORITY_HIGH), 2, 1, 0, 1, 0, 0 };
+  startClient(&lcd);
+  startClient(&status);
+  startClient(&nfc);
+  advanceTime(20000);
+
+  TEST_ASSERT_EQUAL(3, order.size());
+  TEST_ASSERT_EQUAL_STRING("lcd", order[0]);
+  TEST_ASSERT_EQUAL_STRING("nfc", order[1]);
+  TEST_ASSERT_EQUAL_STRING("status", order[2]);
+  // A running transaction isn't preempted
+  TEST_ASSERT_EQUAL(3000, nfc.device->wait);
+  TEST_ASSERT_EQUAL(5000, status.device->wait);
+  // The bus was never idle while someone waited, from 0 to 7 ms
+  TEST_ASSERT_EQUAL(7000, lcd.device->busy + nfc.device->busy + status.device->busy);
+}
+
+void test_contending_tasks_counters_add_up() {
+  I2cBus bus(wire);
+  bus.begin();
+  // The LCD wants the bus all the time, the NFC reader every other ms
+  t_client lcd = { &bus, bus.addDevice("lcd", I2C_PRIORITY_LOW), 0, 2, 0, 100, 0, 0 };
+  t_client nfc = { &bus, bus.addDevice("nfc", I2C_PRIORITY_HIGH), 0, 1, 1, 100, 0, 0 };
+  uint32_t begin = micros();
+  startClient(&lcd);
+  startClient(&nfc);
+  advanceTime(1000000);
+
+  TEST_ASSERT_EQUAL(100, lcd.device->transactions);
+  TEST_ASSERT_EQUAL(100, nfc.device->transactions);
+  TEST_ASSERT_EQUAL(200, order.size());
+  TEST_ASSERT_EQUAL(100 * 2000, lcd.device->busy);
+  TEST_ASSERT_EQUAL(100 * 1000, nfc.device->busy);
+  // The reader waits for one LCD transaction at most
+  TEST_ASSERT_LESS_OR_EQUAL(2000, nfc.longestWait);
+  // The bus was never idle until the last transaction ended
+  uint32_t end = lcd.released > nfc.released ? lcd.released : nfc.released;
+  TEST_ASSERT_EQUAL(end - begin, lcd.device->busy + nfc.device->busy);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_single_device_never_waits);
+  RUN_TEST(test_high_priority_goes_before_a_queued_low_one);
+  RUN_TEST(test_contending_tasks_counters_add_up);
+  return UNITY_END();
+}
@@ -0,0 +1,260 @@
+// The shadow frame of the LCD against a simulated 16x2 display, which moves
+// its cursor like an HD44780 and records every command it gets
+
+#include <unity.h>
+#include <LcdFrame.h>
+
+#include <string.h>
+
+#define COLUMNS 16
+#define ROWS 2
+
+namespace {
+
+// A character LCD with RGB backlight like rgb_lcd
+struct FakeDisplay {
+  char screen[ROWS][COLUMNS + 1];
+  uint8_t rgb[3];
+  uint8_t row;
+  uint8_t column;
+  // Commands since reset()
+  size_t cursorMoves;
+  size_t writes;
+  size_t colorChanges;
+  // Cells written since reset(), and whether a write didn't change the cell
+  bool written[ROWS][COLUMNS];
+  bool rewritten[ROWS][COLUMNS];
+
+  FakeDisplay() {
+    memset(screen, '?', sizeof(screen));
+    for(uint8_t r = 0; r < ROWS; r++) {
+      screen[r][COLUMNS] = '\0';
+    }
+    memset(rgb, 0, sizeof(rgb));
+    row = column = 0;
+    reset();
+  }
+
+  void reset() {
+    cursorMoves = writes = colorChanges = 0;
+    memset(written, 0, sizeof(written));
+    memset(rewritten, 0, sizeof(rewritten));
+  }
+
+  size_t commands() const {
+    return cursorMoves + writes + colorChanges;
+  }
+
+  void setCursor(uint8_t c, uint8_t r) {
+    column = c;
+    row = r;
+    cursorMoves++;
+  }
+
+  void write(uint8_t value) {
+    // Past the end of a row the characters land in memory that isn't shown
+    TEST_ASSERT_LESS_THAN(COLUMNS, column);
+    rewritten[row][column] = screen[row][column] == (char) value;
+    written[row][column] = true;
+    screen[row][column++] = (char) value;
+    writes++;
+  }
+
+  void setRGB(uint8_t red, uint8_t green, uint8_t blue) {
+    rgb[0] = red;
+    rgb[1] = green;
+    rgb[2] = blue;
+    colorChanges++;
+  }
+};
+
+LcdFrame<COLUMNS, ROWS> frame;
+FakeDisplay display;
+
+// What a row has to show, padded with spaces like setLine()
+void assertRow(uint8_t row, const char* text) {
+  char expected[COLUMNS + 1];
+  memset(expected, ' ', COLUMNS);
+  expected[COLUMNS] = '\0';
+  memcpy(expected, text, strlen(text) < COLUMNS ? strlen(text) : COLUMNS);
+  TEST_ASSERT_EQUAL_STRING(expected, display.screen[row]);
+}
+
+size_t render() {
+  display.reset();
+  size_t commands = frame.render(display);
+  TEST_ASSERT_EQUAL(display.commands(), commands);
+  return commands;
+}
+
+// Cells that were written without a change are single gaps between changed ones
+void assertOnlyChangesWritten() {
+  for(uint8_t r = 0; r < ROWS; r++) {
+    for(uint8_t c = 0; c < COLUMNS; c++) {
+      if(!display.rewritten[r][c]) {
+        continue;
+      }
+      TEST_ASSERT_TRUE(c > 0 && c + 1 < COLUMNS);
+      TEST_ASSERT_TRUE(display.written[r][c - 1] && !display.rewritten[r][c - 1]);
+      TEST_ASSERT_TRUE(display.written[r][c + 1] && !display.rewritten[r][c + 1]);
+    }
+  }
+}
+
+// Deterministic pseudo-random numbers
+uint32_t randomState = 1;
+
+uint32_t nextRandom() {
+  randomState = randomState * 1103515245UL + 12345UL;
+  return randomState >> 16;
+}
+
+}
+
+void setUp() {
+  frame = LcdFrame<COLUMNS, ROWS>();
+  display = FakeDisplay();
+  frame.setLine(0, "Node enabled");
+  frame.setLine(1, "node-1");
+  frame.setColor(0, 255, 0);
+  render();
+}
+
+void tearDown() {}
+
+void test_first_render_writes_everything() {
+  // setUp() rendered once
+  assertRow(0, "Node enabled");
+  assertRow(1, "node-1");
+  TEST_ASSERT_EQUAL(ROWS * COLUMNS, display.writes);
+  TEST_ASSERT_EQUAL(1, display.colorChanges);
+  TEST_ASSERT_EQUAL(0, display.rgb[0]);
+  TEST_ASSERT_EQUAL(255, display.rgb[1]);
+  // Every row starts with a cursor move, the rest follows on its own
+  TEST_ASSERT_EQUAL(ROWS, display.cursorMoves);
+}
+
+void test_unchanged_frame_sends_nothing() {
+  frame.setLine(0, "Node enabled");
+  frame.setColor(0, 255, 0);
+  TEST_ASSERT_EQUAL(0, render());
+}
+
+void test_single_changed_cell() {
+  frame.setLine(1, "node-2");
+  TEST_ASSERT_EQUAL(2, render());
+  TEST_ASSERT_EQUAL(1, display.cursorMoves);
+  TEST_ASSERT_EQUAL(1, display.writes);
+  TEST_ASSERT_TRUE(display.written[1][5]);
+  assertRow(1, "node-2");
+}
+
+void test_changed_word() {
+  frame.setLine(0, "Node disabled");
+  render();
+  assertRow(0, "Node disabled");
+  // "enabled " became "disabled", one run of 8 cells
+  TEST_ASSERT_EQUAL(1, display.cursorMoves);
+  TEST_ASSERT_EQUAL(8, display.writes);
+  assertOnlyChangesWritten();
+  TEST_ASSERT_FALSE(display.written[1][0]);
+}
+
+void test_single_unchanged_cell_between_changes_is_rewritten() {
+  frame.setLine(0, "Node_e_abled");
+  render();
+  // One cursor move, then '_', 'e' again and '_'
+  TEST_ASSERT_EQUAL(1, display.cursorMoves);
+  TEST_ASSERT_EQUAL(3, display.writes);
+  TEST_ASSERT_TRUE(display.rewritten[0][5]);
+  assertOnlyChangesWritten();
+  assertRow(0, "Node_e_abled");
+}
+
+void test_two_unchanged_cells_are_skipped() {
+  frame.setLine(0, "Node_en_bled");
+  render();
+  TEST_ASSERT_EQUAL(2, display.cursorMoves);
+  TEST_ASSERT_EQUAL(2, display.writes);
+  assertOnlyChangesWritten();
+  assertRow(0, "Node_en_bled");
+}
+
+void test_cursor_is_reused_across_renders() {
+  frame.setLine(1, "node-10");
+  TEST_ASSERT_EQUAL(2, render());
+  // The cursor stands behind the '0' already
+  frame.setLine(1, "node-100");
+  TEST_ASSERT_EQUAL(1, render());
+  TEST_ASSERT_EQUAL(0, display.cursorMoves);
+  assertRow(1, "node-100");
+}
+
+void test_cursor_is_moved_after_the_end_of_a_row() {
+  frame.setLine(0, "Node enabled   !");
+  render();
+  frame.setLine(1, "!ode-1");
+  render();
+  // The display doesn't wrap from the last column to the next row
+  TEST_ASSERT_EQUAL(1, display.cursorMoves);
+  assertRow(1, "!ode-1");
+}
+
+void test_colour_change_only() {
+  frame.setColor(255, 0, 0);
+  TEST_ASSERT_EQUAL(1, render());
+  TEST_ASSERT_EQUAL(1, display.colorChanges);
+  TEST_ASSERT_EQUAL(255, display.rgb[0]);
+}
+
+void test_invalidate_writes_everything_again() {
+  frame.invalidate();
+  render();
+  TEST_ASSERT_EQUAL(ROWS * COLUMNS, display.writes);
+  TEST_ASSERT_EQUAL(1, display.colorChanges);
+}
+
+void test_long_lines_are_cut_off() {
+  frame.setLine(1, "0123456789abcdefXYZ");
+  frame.setLine(ROWS, "no such row");
+  render();
+  assertRow(0, "Node enabled");
+  assertRow(1, "0123456789abcdef");
+}
+
+void test_random_updates_match_the_screen() {
+  char lines[ROWS][COLUMNS + 1];
+  for(int round = 0; round < 500; round++) {
+    for(uint8_t r = 0; r < ROWS; r++) {
+      size_t length = nextRandom() % (COLUMNS + 1);
+      for(size_t c = 0; c < length; c++) {
+        // Few characters, so many cells stay the same
+        lines[r][c] = "ab "[nextRandom() % 3];
+      }
+      lines[r][length] = '\0';
+      frame.setLine(r, lines[r]);
+    }
+    render();
+    assertOnlyChangesWritten();
+    for(uint8_t r = 0; r < ROWS; r++) {
+      assertRow(r, lines[r]);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_first_render_writes_everything);
+  RUN_TEST(test_unchanged_frame_sends_nothing);
+  RUN_TEST(test_single_changed_cell);
+  RUN_TEST(test_changed_word);
+  RUN_TEST(test_single_unchanged_cell_between_changes_is_rewritten);
+  RUN_TEST(test_two_unchanged_cells_are_skipped);
+  RUN_TEST(test_cursor_is_reused_across_renders);
+  RUN_TEST(test_cursor_is_moved_after_the_end_of_a_row);
+  RUN_TEST(test_colour_change_only);
+  RUN_TEST(test_invalidate_writes_everything_again);
+  RUN_TEST(test_long_lines_are_cut_off);
+  RUN_TEST(test_random_updates_match_the_screen);
+  return UNITY_END();
+}
@@ -0,0 +1,220 @@
+// Command and config messages as the coordinator publishes them, parsed
+// with ArduinoJson like in onCommandMessage() and onConfig()
+
+#include <unity.h>
+#include <ArduinoJson.h>
+#include <NodeMessages.h>
+
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+StaticJsonDocument<1024> doc;
+
+// Rule tables are large, they're kept out of the test functions' stack
+t_node_rules rules;
+
+void parse(const char* json) {
+  DeserializationError error = deserializeJson(doc, json, strlen(json));
+  TEST_ASSERT_FALSE_MESSAGE(error, json);
+}
+
+CommandResult command(const char* json, CommandScope scope, const char* node, uint16_t index,
+                      t_node_command* parsed) {
+  parse(json);
+  return readCommand(doc, scope, node, index, parsed);
+}
+
+t_nfc_data tag(const uint8_t* uid, uint8_t length) {
+  t_nfc_data nfc;
+  memset(&nfc, 0, sizeof(nfc));
+  memcpy(nfc.uid, uid, length);
+  nfc.uidLength = length;
+  return nfc;
+}
+
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_node_command_for_this_node() {
+  t_node_command parsed;
+  TEST_ASSERT_EQUAL(COMMAND_ACCEPTED, command("{\"node\":\"node-1\",\"command\":2}", SCOPE_NODE, "node-1", 0, &parsed));
+  TEST_ASSERT_EQUAL(TOGGLE, parsed.command);
+  TEST_ASSERT_EQUAL(COMMAND_ACCEPTED, command("{\"command\":0,\"node\":\"node-1\"}", SCOPE_NODE, "node-1", 0, &parsed));
+  TEST_ASSERT_EQUAL(DISABLE, parsed.command);
+}
+
+void test_node_command_for_another_node() {
+  t_node_command parsed;
+  TEST_ASSERT_EQUAL(COMMAND_NOT_ADDRESSED, command("{\"node\":\"node-2\",\"command\":1}", SCOPE_NODE, "node-1", 0, &parsed));
+  TEST_ASSERT_EQUAL(COMMAND_NOT_ADDRESSED, command("{\"node\":\"node-10\",\"command\":1}", SCOPE_NODE, "node-1", 0, &parsed));
+  TEST_ASSERT_EQUAL(COMMAND_NOT_ADDRESSED, command("{\"command\":1}", SCOPE_NODE, "node-1", 0, &parsed));
+}
+
+void test_group_command_addresses_every_member() {
+  t_node_command parsed;
+  TEST_ASSERT_EQUAL(COMMAND_ACCEPTED, command("{\"command\":1}", SCOPE_GROUP, "node-1", 0, &parsed));
+  TEST_ASSERT_EQUAL(ENABLE, parsed.command);
+  TEST_ASSERT_EQUAL(COMMAND_ACCEPTED, command("{\"command\":2}", SCOPE_GROUP, "node-7", 6, &parsed));
+  TEST_ASSERT_EQUAL(TOGGLE, parsed.command);
+}
+
+void test_broadcast_bitset() {
+  t_node_command parsed;
+  // 5 addresses the first and the third node
+  TEST_ASSERT_EQUAL(COMMAND_ACCEPTED, command("{\"nodes\":5,\"command\":2}", SCOPE_BROADCAST, "node-1", 0, &parsed));
+  TEST_ASSERT_EQUAL(COMMAND_NOT_ADDRESSED, command("{\"nodes\":5,\"command\":2}", SCOPE_BROADCAST, "node-2", 1, &parsed));
+  TEST_ASSERT_EQUAL(COMMAND_ACCEPTED, command("{\"nodes\":5,\"command\":2}", SCOPE_BROADCAST, "node-3", 2, &parsed));
+  TEST_ASSERT_EQUAL(COMMAND_ACCEPTED, command("{\"nodes\":2147483648,\"command\":0}", SCOPE_BROADCAST, "node-32", 31, &parsed));
+  TEST_ASSERT_EQUAL(DISABLE, parsed.command);
+}
+
+void test_broadcast_list() {
+  t_node_command parsed;
+  TEST_ASSERT_EQUAL(COMMAND_ACCEPTED, command("{\"nodes\":[0,2],\"command\":1}", SCOPE_BROADCAST, "node-3", 2, &parsed));
+  TEST_ASSERT_EQUAL(ENABLE, parsed.command);
+  TEST_ASSERT_EQUAL(COMMAND_NOT_ADDRESSED, command("{\"nodes\":[0,2],\"command\":1}", SCOPE_BROADCAST, "node-2", 1, &parsed));
+  TEST_ASSERT_EQUAL(COMMAND_NOT_ADDRESSED, command("{\"nodes\":[],\"command\":1}", SCOPE_BROADCAST, "node-1", 0, &parsed));
+  TEST_ASSERT_EQUAL(COMMAND_NOT_ADDRESSED, command("{\"command\":1}", SCOPE_BROADCAST, "node-1", 0, &parsed));
+}
+
+void test_broadcast_hex_bitset() {
+  t_node_command parsed;
+  // "100000005" adds the 33rd node to the first and third
+  const char* json = "{\"nodes\":\"100000005\",\"command\":2}";
+  TEST_ASSERT_EQUAL(COMMAND_ACCEPTED, command(json, SCOPE_BROADCAST, "node-1", 0, &parsed));
+  TEST_ASSERT_EQUAL(COMMAND_NOT_ADDRESSED, command(json, SCOPE_BROADCAST, "node-2", 1, &parsed));
+  TEST_ASSERT_EQUAL(COMMAND_ACCEPTED, command(json, SCOPE_BROADCAST, "node-3", 2, &parsed));
+  TEST_ASSERT_EQUAL(COMMAND_NOT_ADDRESSED, command(json, SCOPE_BROADCAST, "node-32", 31, &parsed));
+  TEST_ASSERT_EQUAL(COMMAND_ACCEPTED, command(json, SCOPE_BROADCAST, "node-33", 32, &parsed));
+  // Past the last digit
+  TEST_ASSERT_EQUAL(COMMAND_NOT_ADDRESSED, command(json, SCOPE_BROADCAST, "node-37", 36, &parsed));
+  TEST_ASSERT_EQUAL(COMMAND_ACCEPTED, command("{\"nodes\":\"A\",\"command\":2}", SCOPE_BROADCAST, "node-4", 3, &parsed));
+  TEST_ASSERT_EQUAL(COMMAND_NOT_ADDRESSED, command("{\"nodes\":\"x1\",\"command\":2}", SCOPE_BROADCAST, "node-5", 4, &parsed));
+}
+
+void test_broadcast_past_32_nodes() {
+  t_node_command parsed;
+  // A number only holds the first 32 nodes
+  TEST_ASSERT_EQUAL(COMMAND_NOT_ADDRESSED, command("{\"nodes\":4294967295,\"command\":2}", SCOPE_BROADCAST, "node-33", 32, &parsed));
+  TEST_ASSERT_EQUAL(COMMAND_ACCEPTED, command("{\"nodes\":[0,999],\"command\":2}", SCOPE_BROADCAST, "node-1000", 999, &parsed));
+  // Every digit set, with the last node
+  char json[BROADCAST_MAX_NODES / 4 + 32] = "{\"nodes\":\"";
+  memset(json + strlen(json), 'f', BROADCAST_MAX_NODES / 4);
+  strcpy(json + 10 + BROADCAST_MAX_NODES / 4, "\",\"command\":2}");
+  TEST_ASSERT_EQUAL(COMMAND_ACCEPTED, command(json, SCOPE_BROADCAST, "node-1024", BROADCAST_MAX_NODES - 1, &parsed));
+  // Nodes past the bitset are never addressed
+  TEST_ASSERT_EQUAL(COMMAND_NOT_ADDRESSED, command("{\"nodes\":[1024],\"command\":2}", SCOPE_BROADCAST, "node-1025", BROADCAST_MAX_NODES, &parsed));
+  TEST_ASSERT_EQUAL(COMMAND_NOT_ADDRESSED, command(json, SCOPE_BROADCAST, "node-1025", BROADCAST_MAX_NODES, &parsed));
+}
+
+void test_unknown_commands_are_invalid() {
+  t_node_command parsed;
+  TEST_ASSERT_EQUAL(COMMAND_INVALID, command("{\"node\":\"node-1\",\"command\":3}", SCOPE_NODE, "node-1", 0, &parsed));
+  TEST_ASSERT_EQUAL(COMMAND_INVALID, command("{\"node\":\"node-1\",\"command\":-1}", SCOPE_NODE, "node-1", 0, &parsed));
+  TEST_ASSERT_EQUAL(COMMAND_INVALID, command("{\"node\":\"node-1\",\"command\":\"on\"}", SCOPE_NODE, "node-1", 0, &parsed));
+  TEST_ASSERT_EQUAL(COMMAND_INVALID, command("{\"node\":\"node-1\"}", SCOPE_NODE, "node-1", 0, &parsed));
+  TEST_ASSERT_EQUAL(COMMAND_INVALID, command("{}", SCOPE_GROUP, "node-1", 0, &parsed));
+}
+
+void test_malformed_command_is_rejected_by_the_parser() {
+  const char* json = "{\"node\":\"node-1\",\"command\":";
+  TEST_ASSERT_TRUE((bool) deserializeJson(doc, json, strlen(json)));
+}
+
+void test_config_rules() {
+  // As published by publishNodeRules() of the coordinator for node-1
+  parse("{\"ir\":{\"toggle\":[16750695],\"on\":[16756815],\"off\":[16775175]},\"nfc\":{\"toggle\":[\"8E:FC:5B:22\"],\"known\":[\"9E:7B:E9:22\"]}}");
+  TEST_ASSERT_TRUE(readRules(doc, &rules));
+  TEST_ASSERT_EQUAL(3, rules.irCount);
+  TEST_ASSERT_EQUAL(RULE_TOGGLE, matchIRRule(&rules, 16750695));
+  TEST_ASSERT_EQUAL(RULE_ENABLE, matchIRRule(&rules, 16756815));
+  TEST_ASSERT_EQUAL(RULE_DISABLE, matchIRRule(&rules, 16775175));
+  TEST_ASSERT_EQUAL(RULE_NONE, matchIRRule(&rules, 16767015));
+
+  const uint8_t own[] = { 0x8E, 0xFC, 0x5B, 0x22 };
+  const uint8_t known[] = { 0x9E, 0x7B, 0xE9, 0x22 };
+  const uint8_t unknown[] = { 0x9E, 0x3F, 0x1A, 0x22 };
+  t_nfc_data nfc = tag(own, sizeof(own));
+  TEST_ASSERT_EQUAL(RULE_TOGGLE, matchNfcRule(&rules, &nfc));
+  nfc = tag(known, sizeof(known));
+  TEST_ASSERT_EQUAL(RULE_KNOWN, matchNfcRule(&rules, &nfc));
+  nfc = tag(unknown, sizeof(unknown));
+  TEST_ASSERT_EQUAL(RULE_NONE, matchNfcRule(&rules, &nfc));
+}
+
+void test_own_tag_listed_as_known_keeps_its_rule() {
+  parse("{\"nfc\":{\"toggle\":[\"8E:FC:5B:22\"],\"known\":[\"8E:FC:5B:22\"]}}");
+  TEST_ASSERT_TRUE(readRules(doc, &rules));
+  const uint8_t own[] = { 0x8E, 0xFC, 0x5B, 0x22 };
+  t_nfc_data nfc = tag(own, sizeof(own));
+  TEST_ASSERT_EQUAL(RULE_TOGGLE, matchNfcRule(&rules, &nfc));
+  TEST_ASSERT_EQUAL(1, rules.nfc.count);
+}
+
+void test_config_replaces_previous_rules() {
+  parse("{\"ir\":{\"toggle\":[1,2,3]},\"nfc\":{\"toggle\":[\"01:02:03:04\"]}}");
+  TEST_ASSERT_TRUE(readRules(doc, &rules));
+  parse("{\"ir\":{\"on\":[2]}}");
+  TEST_ASSERT_TRUE(readRules(doc, &rules));
+  TEST_ASSERT_EQUAL(1, rules.irCount);
+  TEST_ASSERT_EQUAL(RULE_NONE, matchIRRule(&rules, 1));
+  TEST_ASSERT_EQUAL(RULE_ENABLE, matchIRRule(&rules, 2));
+  TEST_ASSERT_EQUAL(0, rules.nfc.count);
+}
+
+void test_empty_config_clears_rules() {
+  parse("{\"ir\":{\"toggle\":[1]}}");
+  TEST_ASSERT_TRUE(readRules(doc, &rules));
+  parse("{}");
+  TEST_ASSERT_TRUE(readRules(doc, &rules));
+  TEST_ASSERT_EQUAL(0, rules.irCount);
+  TEST_ASSERT_EQUAL(RULE_NONE, matchIRRule(&rules, 1));
+}
+
+void test_config_keeps_valid_rules_of_an_invalid_config() {
+  parse("{\"ir\":{\"toggle\":[7,\"8\",-1]},\"nfc\":{\"toggle\":[\"8E:FC:5B\",\"8E:FC:5B:2\",42]}}");
+  TEST_ASSERT_FALSE(readRules(doc, &rules));
+  TEST_ASSERT_EQUAL(1, rules.irCount);
+  TEST_ASSERT_EQUAL(RULE_TOGGLE, matchIRRule(&rules, 7));
+  TEST_ASSERT_EQUAL(1, rules.nfc.count);
+}
+
+void test_config_with_too_many_rules() {
+  char json[512] = "{\"ir\":{\"toggle\":[";
+  for(int i = 0; i < RULES_MAX_IR + 4; i++) {
+    char code[16];
+    snprintf(code, sizeof(code), i ? ",%d" : "%d", 100 + i);
+    strcat(json, code);
+  }
+  strcat(json, "]}}");
+  parse(json);
+  TEST_ASSERT_FALSE(readRules(doc, &rules));
+  TEST_ASSERT_EQUAL(RULES_MAX_IR, rules.irCount);
+  TEST_ASSERT_EQUAL(RULE_TOGGLE, matchIRRule(&rules, 100));
+  TEST_ASSERT_EQUAL(RULE_NONE, matchIRRule(&rules, 100 + RULES_MAX_IR));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_node_command_for_this_node);
+  RUN_TEST(test_node_command_for_another_node);
+  RUN_TEST(test_group_command_addresses_every_member);
+  RUN_TEST(test_broadcast_bitset);
+  RUN_TEST(test_broadcast_list);
+  RUN_TEST(test_broadcast_hex_bitset);
+  RUN_TEST(test_broadcast_past_32_nodes);
+  RUN_TEST(test_unknown_commands_are_invalid);
+  RUN_TEST(test_malformed_command_is_rejected_by_the_parser);
+  RUN_TEST(test_config_rules);
+  RUN_TEST(test_own_tag_listed_as_known_keeps_its_rule);
+  RUN_TEST(test_config_replaces_previous_rules);
+  RUN_TEST(test_empty_config_clears_rules);
+  RUN_TEST(test_config_keeps_valid_rules_of_an_invalid_config);
+  RUN_TEST(test_config_with_too_many_rules);
+  return UNITY_END();
+}
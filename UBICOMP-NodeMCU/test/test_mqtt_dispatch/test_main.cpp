@@ -0,0 +1,185 @@
+// Topic dispatch and payload reassembly of the MQTT callback. Chunks are
+// passed like AsyncMqttClient does, with their offset and the full length,
+// a chunk that doesn't continue the message drops it
+
+#include <unity.h>
+#include <MqttDispatch.h>
+
+#include <string.h>
+
+namespace {
+
+t_topic_dispatch dispatch;
+t_payload_assembler assembler;
+char message[2 * MQTT_PAYLOAD_MAX_SIZE];
+
+// Passes a message in chunks of size, returns what the last chunk returned
+char* assembleInChunks(const char* payload, size_t total, size_t size) {
+  char* assembled = NULL;
+  for(size_t index = 0; index < total; index += size) {
+    size_t len = total - index < size ? total - index : size;
+    assembled = assemblePayload(&assembler, payload + index, len, index, total);
+    if(index + len < total) {
+      TEST_ASSERT_NULL(assembled);
+    }
+  }
+  return assembled;
+}
+
+void fillMessage(size_t length) {
+  for(size_t i = 0; i < length; i++) {
+    message[i] = 'a' + i % 26;
+  }
+  message[length] = '\0';
+}
+
+}
+
+void setUp() {
+  dispatch.count = 0;
+  memset(&assembler, 0, sizeof(assembler));
+}
+
+void tearDown() {}
+
+void test_registered_topics_are_resolved() {
+  TEST_ASSERT_TRUE(registerTopic(&dispatch, "node/node-1/set", 0));
+  TEST_ASSERT_TRUE(registerTopic(&dispatch, "node/node-1/config", 1));
+  TEST_ASSERT_TRUE(registerTopic(&dispatch, "broadcast/set", 3));
+  TEST_ASSERT_EQUAL(0, dispatchTopic(&dispatch, "node/node-1/set"));
+  TEST_ASSERT_EQUAL(1, dispatchTopic(&dispatch, "node/node-1/config"));
+  TEST_ASSERT_EQUAL(3, dispatchTopic(&dispatch, "broadcast/set"));
+  TEST_ASSERT_EQUAL(TOPIC_UNKNOWN, dispatchTopic(&dispatch, "node/node-2/set"));
+  TEST_ASSERT_EQUAL(TOPIC_UNKNOWN, dispatchTopic(&dispatch, "node/node-1/set/"));
+  TEST_ASSERT_EQUAL(TOPIC_UNKNOWN, dispatchTopic(&dispatch, ""));
+}
+
+void test_too_many_topics() {
+  for(uint8_t i = 0; i < MQTT_MAX_ROUTES; i++) {
+    TEST_ASSERT_TRUE(registerTopic(&dispatch, "group/room-1/set", i));
+  }
+  TEST_ASSERT_FALSE(registerTopic(&dispatch, "broadcast/set", MQTT_MAX_ROUTES));
+  TEST_ASSERT_EQUAL(TOPIC_UNKNOWN, dispatchTopic(&dispatch, "broadcast/set"));
+}
+
+void test_hash_hit_with_other_text() {
+  // Both topics have the same FNV-1a hash and length
+  registerTopic(&dispatch, "node/aivlo/set", 0);
+  TEST_ASSERT_EQUAL(TOPIC_UNKNOWN, dispatchTopic(&dispatch, "node/a1pda/set"));
+  registerTopic(&dispatch, "node/a1pda/set", 1);
+  TEST_ASSERT_EQUAL(0, dispatchTopic(&dispatch, "node/aivlo/set"));
+  TEST_ASSERT_EQUAL(1, dispatchTopic(&dispatch, "node/a1pda/set"));
+}
+
+void test_hash_hit_with_other_length() {
+  // Same FNV-1a hash, different lengths
+  registerTopic(&dispatch, "costarring", 0);
+  TEST_ASSERT_EQUAL(TOPIC_UNKNOWN, dispatchTopic(&dispatch, "liquid"));
+  registerTopic(&dispatch, "liquid", 1);
+  TEST_ASSERT_EQUAL(0, dispatchTopic(&dispatch, "costarring"));
+  TEST_ASSERT_EQUAL(1, dispatchTopic(&dispatch, "liquid"));
+}
+
+void test_single_chunk() {
+  const char* payload = "{\"command\":1}";
+  char* assembled = assemblePayload(&assembler, payload, strlen(payload), 0, strlen(payload));
+  TEST_ASSERT_EQUAL_STRING(payload, assembled);
+  TEST_ASSERT_EQUAL(0, assembler.dropped);
+}
+
+void test_chunks_in_order() {
+  fillMessage(MQTT_PAYLOAD_MAX_SIZE);
+  TEST_ASSERT_EQUAL_STRING(message, assembleInChunks(message, MQTT_PAYLOAD_MAX_SIZE, 100));
+  // The assembler is ready for the next message
+  fillMessage(300);
+  TEST_ASSERT_EQUAL_STRING(message, assembleInChunks(message, 300, 7));
+  TEST_ASSERT_EQUAL(0, assembler.dropped);
+}
+
+void test_missing_chunk_drops_the_message() {
+  fillMessage(300);
+  TEST_ASSERT_NULL(assemblePayload(&assembler, message, 100, 0, 300));
+  TEST_ASSERT_NULL(assemblePayload(&assembler, message + 200, 100, 200, 300));
+  TEST_ASSERT_EQUAL(1, assembler.dropped);
+  // The chunk that arrives late is ignored
+  TEST_ASSERT_NULL(assemblePayload(&assembler, message + 100, 100, 100, 300));
+  TEST_ASSERT_EQUAL(1, assembler.dropped);
+  TEST_ASSERT_EQUAL_STRING(message, assembleInChunks(message, 300, 100));
+}
+
+void test_chunks_out_of_order_drop_the_message() {
+  fillMessage(300);
+  TEST_ASSERT_NULL(assemblePayload(&assembler, message, 100, 0, 300));
+  TEST_ASSERT_NULL(assemblePayload(&assembler, message + 100, 50, 100, 300));
+  // Overlaps what was received
+  TEST_ASSERT_NULL(assemblePayload(&assembler, message + 100, 200, 100, 300));
+  TEST_ASSERT_EQUAL(1, assembler.dropped);
+}
+
+void test_missing_last_chunk_is_counted_by_the_next_message() {
+  fillMessage(300);
+  TEST_ASSERT_NULL(assemblePayload(&assembler, message, 100, 0, 300));
+  const char* payload = "{\"command\":2}";
+  TEST_ASSERT_EQUAL_STRING(payload, assemblePayload(&assembler, payload, strlen(payload), 0, strlen(payload)));
+  TEST_ASSERT_EQUAL(1, assembler.dropped);
+}
+
+void test_missing_first_chunk_drops_the_message() {
+  fillMessage(300);
+  TEST_ASSERT_NULL(assemblePayload(&assembler, message + 100, 100, 100, 300));
+  TEST_ASSERT_NULL(assemblePayload(&assembler, message + 200, 100, 200, 300));
+  TEST_ASSERT_EQUAL(1, assembler.dropped);
+}
+
+void test_changed_total_drops_the_message() {
+  fillMessage(300);
+  TEST_ASSERT_NULL(assemblePayload(&assembler, message, 100, 0, 300));
+  TEST_ASSERT_NULL(assemblePayload(&assembler, message + 100, 100, 100, 200));
+  TEST_ASSERT_EQUAL(1, assembler.dropped);
+}
+
+void test_chunk_past_the_total_drops_the_message() {
+  fillMessage(300);
+  TEST_ASSERT_NULL(assemblePayload(&assembler, message, 100, 0, 150));
+  TEST_ASSERT_NULL(assemblePayload(&assembler, message + 100, 100, 100, 150));
+  TEST_ASSERT_EQUAL(1, assembler.dropped);
+  // Also for the first chunk, the copy never relies on the caller
+  TEST_ASSERT_NULL(assemblePayload(&assembler, message, 2 * MQTT_PAYLOAD_MAX_SIZE, 0, 100));
+  TEST_ASSERT_EQUAL(2, assembler.dropped);
+}
+
+void test_too_large_message_is_dropped_with_its_tail() {
+  fillMessage(MQTT_PAYLOAD_MAX_SIZE + 1);
+  TEST_ASSERT_NULL(assembleInChunks(message, MQTT_PAYLOAD_MAX_SIZE + 1, 100));
+  TEST_ASSERT_EQUAL(1, assembler.dropped);
+  const char* payload = "{\"command\":0}";
+  TEST_ASSERT_EQUAL_STRING(payload, assemblePayload(&assembler, payload, strlen(payload), 0, strlen(payload)));
+  TEST_ASSERT_EQUAL(1, assembler.dropped);
+}
+
+void test_empty_message() {
+  TEST_ASSERT_EQUAL_STRING("", assemblePayload(&assembler, "", 0, 0, 0));
+  TEST_ASSERT_EQUAL(0, assembler.dropped);
+  // Not part of the empty message
+  TEST_ASSERT_NULL(assemblePayload(&assembler, "{}", 2, 0, 0));
+  TEST_ASSERT_EQUAL(1, assembler.dropped);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_registered_topics_are_resolved);
+  RUN_TEST(test_too_many_topics);
+  RUN_TEST(test_hash_hit_with_other_text);
+  RUN_TEST(test_hash_hit_with_other_length);
+  RUN_TEST(test_single_chunk);
+  RUN_TEST(test_chunks_in_order);
+  RUN_TEST(test_missing_chunk_drops_the_message);
+  RUN_TEST(test_chunks_out_of_order_drop_the_message);
+  RUN_TEST(test_missing_last_chunk_is_counted_by_the_next_message);
+  RUN_TEST(test_missing_first_chunk_drops_the_message);
+  RUN_TEST(test_changed_total_drops_the_message);
+  RUN_TEST(test_chunk_past_the_total_drops_the_message);
+  RUN_TEST(test_too_large_message_is_dropped_with_its_tail);
+  RUN_TEST(test_empty_message);
+  return UNITY_END();
+}
@@ -0,0 +1,117 @@
+// Binary payloads of SensorMsgPack.cpp byte for byte. The same hex strings
+// are decoded by payload.ts in the coordinator's test/payload.test.ts, a
+// change here has to be made there as well
+
+#include <unity.h>
+#include <SensorMsgPack.h>
+#include <NodeRules.h>
+
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+// Larger than every payload buffer, so overflows show up behind them
+uint8_t out[256];
+
+const char* const IR_NO_ACTION =
+  "95" "01" "ce00ff9867" "45" "0c" "c0";
+const char* const NFC_SEVEN_BYTE_UID =
+  "94" "01" "c40704a1b2c3d4e5f6" "01" "02";
+const char* const STATE_LONG_NODE =
+  "93" "01" "01" "d921" "6c6976696e672d726f6f6d2d6365696c696e672d6c696768742d6e6f64652d3132";
+// IR without action at 70 s, NFC toggled at 70.5 s, sound, then a clap
+const char* const BATCH =
+  "95" "01"
+  "96" "00" "ce00011170" "ce00ff9867" "45" "0c" "c0"
+  "95" "02" "ce00011364" "c4048efc5b22" "00" "02"
+  "95" "01" "ce0001151e" "cd012c" "cd03e8" "0c"
+  "96" "03" "ce00011558" "00" "ce0001e240" "cd0708" "28";
+
+char hex[2 * sizeof(out) + 1];
+
+void assertPayload(const char* expected, size_t length) {
+  TEST_ASSERT_GREATER_THAN(0, length);
+  for(size_t i = 0; i < length; i++) {
+    snprintf(hex + 2 * i, 3, "%02x", out[i]);
+  }
+  hex[2 * length] = '\0';
+  TEST_ASSERT_EQUAL_STRING(expected, hex);
+}
+
+t_ir_data irData() {
+  t_ir_data ir;
+  ir.code = 0x00FF9867;
+  ir.command = 0x45;
+  ir.button = 12;
+  ir.action = SENSOR_NO_ACTION;
+  return ir;
+}
+
+t_nfc_data nfcData(const uint8_t* uid, uint8_t length, uint8_t tagType, uint8_t action) {
+  t_nfc_data nfc;
+  memset(&nfc, 0, sizeof(nfc));
+  memcpy(nfc.uid, uid, length);
+  nfc.uidLength = length;
+  nfc.tagType = tagType;
+  nfc.action = action;
+  return nfc;
+}
+
+}
+
+void setUp() {
+  memset(out, 0xAA, sizeof(out));
+}
+
+void tearDown() {}
+
+void test_ir_without_action_is_nil() {
+  t_ir_data ir = irData();
+  assertPayload(IR_NO_ACTION, writeIrMsgPack(out, IR_MSGPACK_SIZE, &ir));
+}
+
+void test_nfc_uid_is_bin() {
+  const uint8_t uid[] = { 0x04, 0xA1, 0xB2, 0xC3, 0xD4, 0xE5, 0xF6 };
+  t_nfc_data nfc = nfcData(uid, sizeof(uid), NFC_TAG_TYPE_MIFARE_CLASSIC + 1, RULE_TOGGLE);
+  assertPayload(NFC_SEVEN_BYTE_UID, writeNfcMsgPack(out, NFC_MSGPACK_SIZE, &nfc));
+}
+
+void test_long_node_name_is_str8() {
+  const char* node = "living-room-ceiling-light-node-12";
+  TEST_ASSERT_GREATER_THAN(31, strlen(node));
+  assertPayload(STATE_LONG_NODE, writeStateMsgPack(out, STATE_MSGPACK_SIZE, 1, node));
+}
+
+void test_batch_of_every_sensor() {
+  const uint8_t uid[] = { 0x8E, 0xFC, 0x5B, 0x22 };
+  t_sensor_event events[4];
+  memset(events, 0, sizeof(events));
+  events[0].type = SENSOR_IR;
+  events[0].timestamp = 70000;
+  events[0].ir = irData();
+  events[1].type = SENSOR_NFC;
+  events[1].timestamp = 70500;
+  events[1].nfc = nfcData(uid, sizeof(uid), NFC_TAG_TYPE_MIFARE_CLASSIC, RULE_TOGGLE);
+  events[2].type = SENSOR_SOUND;
+  events[2].timestamp = 70942;
+  events[2].sound.rms = 300;
+  events[2].sound.peak = 1000;
+  events[2].sound.envelope = 12;
+  events[3].type = SENSOR_ACOUSTIC;
+  events[3].timestamp = 71000;
+  events[3].acoustic.kind = ACOUSTIC_CLAP;
+  events[3].acoustic.onset = 123456;
+  events[3].acoustic.peak = 1800;
+  events[3].acoustic.duration = 40;
+  assertPayload(BATCH, writeBatchMsgPack(out, BATCH_MSGPACK_SIZE(4), events, 4));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_ir_without_action_is_nil);
+  RUN_TEST(test_nfc_uid_is_bin);
+  RUN_TEST(test_long_node_name_is_str8);
+  RUN_TEST(test_batch_of_every_sensor);
+  return UNITY_END();
+}
@@ -0,0 +1,154 @@
+// The NFC allowlist filled up to NFC_ALLOWLIST_MAX_TAGS with random UIDs.
+// Every insert within capacity has to succeed, whether the probe windows of
+// the tags collide or not, and lookups have to find exactly the added tags
+
+#include <unity.h>
+#include <NfcAllowlist.h>
+
+#include <string.h>
+
+#define CONFIGS 2000
+#define FALLBACK 0xFF
+
+namespace {
+
+t_nfc_allowlist list;
+uint8_t uids[NFC_ALLOWLIST_MAX_TAGS][NFC_UID_MAX_LENGTH];
+
+// Deterministic pseudo-random numbers
+uint32_t randomState = 1;
+
+uint32_t nextRandom() {
+  randomState = randomState * 1103515245UL + 12345UL;
+  return randomState >> 16;
+}
+
+// 4 byte UIDs like the tags of the fleet, unique within a config
+void randomUids(size_t count) {
+  for(size_t i = 0; i < count; i++) {
+    bool unique;
+    do {
+      for(uint8_t j = 0; j < 4; j++) {
+        uids[i][j] = nextRandom();
+      }
+      unique = true;
+      for(size_t other = 0; other < i; other++) {
+        unique &= memcmp(uids[i], uids[other], 4) != 0;
+      }
+    } while(!unique);
+  }
+}
+
+uint8_t actionOf(size_t tag) {
+  return tag % 3;
+}
+
+// Adds count random tags and checks all of them, returns whether the table
+// was rehashed on the way
+bool fill(size_t count) {
+  clearAllowlist(&list);
+  randomUids(count);
+  for(size_t i = 0; i < count; i++) {
+    TEST_ASSERT_TRUE_MESSAGE(addAllowlistTag(&list, uids[i], 4, actionOf(i)), "Insert within capacity rejected");
+  }
+  TEST_ASSERT_EQUAL(count, list.count);
+  for(size_t i = 0; i < count; i++) {
+    TEST_ASSERT_EQUAL(actionOf(i), matchAllowlist(&list, uids[i], 4, FALLBACK));
+  }
+  return list.seed != 0;
+}
+
+}
+
+void setUp() {
+  clearAllowlist(&list);
+}
+
+void tearDown() {}
+
+void test_every_config_fits_up_to_max_tags() {
+  const size_t counts[] = { 6, 8, NFC_ALLOWLIST_MAX_TAGS };
+  for(size_t count : counts) {
+    size_t rehashed = 0;
+    for(int config = 0; config < CONFIGS; config++) {
+      rehashed += fill(count);
+    }
+    // Collisions do happen, otherwise the rehash isn't tested
+    if(count == NFC_ALLOWLIST_MAX_TAGS) {
+      TEST_ASSERT_GREATER_THAN(0, rehashed);
+    }
+  }
+}
+
+void test_unknown_tags_get_the_fallback() {
+  for(int config = 0; config < CONFIGS; config++) {
+    fill(NFC_ALLOWLIST_MAX_TAGS);
+    uint8_t unknown[NFC_UID_MAX_LENGTH];
+    for(uint8_t j = 0; j < 4; j++) {
+      unknown[j] = nextRandom();
+    }
+    bool known = false;
+    for(size_t i = 0; i < NFC_ALLOWLIST_MAX_TAGS; i++) {
+      known |= memcmp(unknown, uids[i], 4) == 0;
+    }
+    if(!known) {
+      TEST_ASSERT_EQUAL(FALLBACK, matchAllowlist(&list, unknown, 4, FALLBACK));
+    }
+    // Same bytes, different length
+    TEST_ASSERT_EQUAL(FALLBACK, matchAllowlist(&list, uids[0], 7, FALLBACK));
+  }
+}
+
+void test_full_table_rejects_new_tags_and_stays_intact() {
+  fill(NFC_ALLOWLIST_MAX_TAGS);
+  const uint8_t extra[NFC_UID_MAX_LENGTH] = { 0x04, 0xA1, 0xB2, 0xC3, 0xD4, 0xE5, 0xF6 };
+  TEST_ASSERT_FALSE(addAllowlistTag(&list, extra, 7, 1));
+  TEST_ASSERT_EQUAL(NFC_ALLOWLIST_MAX_TAGS, list.count);
+  TEST_ASSERT_EQUAL(FALLBACK, matchAllowlist(&list, extra, 7, FALLBACK));
+  for(size_t i = 0; i < NFC_ALLOWLIST_MAX_TAGS; i++) {
+    TEST_ASSERT_EQUAL(actionOf(i), matchAllowlist(&list, uids[i], 4, FALLBACK));
+  }
+}
+
+void test_full_table_still_replaces_actions() {
+  fill(NFC_ALLOWLIST_MAX_TAGS);
+  TEST_ASSERT_TRUE(addAllowlistTag(&list, uids[0], 4, 2));
+  TEST_ASSERT_EQUAL(NFC_ALLOWLIST_MAX_TAGS, list.count);
+  TEST_ASSERT_EQUAL(2, matchAllowlist(&list, uids[0], 4, FALLBACK));
+}
+
+void test_invalid_uids() {
+  const uint8_t uid[NFC_UID_MAX_LENGTH + 1] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+  TEST_ASSERT_FALSE(addAllowlistTag(&list, uid, 0, 1));
+  TEST_ASSERT_FALSE(addAllowlistTag(&list, uid, NFC_UID_MAX_LENGTH + 1, 1));
+  TEST_ASSERT_EQUAL(0, list.count);
+  // An empty UID packs to the key of empty slots
+  TEST_ASSERT_EQUAL(FALLBACK, matchAllowlist(&list, uid, 0, FALLBACK));
+}
+
+void test_rate_limiter_burst_and_refill() {
+  t_tag_rate_limiter limiter;
+  initTagRateLimiter(&limiter, 3, 2000, 1000);
+  TEST_ASSERT_TRUE(allowUnknownTag(&limiter, 1000));
+  TEST_ASSERT_TRUE(allowUnknownTag(&limiter, 1100));
+  TEST_ASSERT_TRUE(allowUnknownTag(&limiter, 1200));
+  TEST_ASSERT_FALSE(allowUnknownTag(&limiter, 2900));
+  TEST_ASSERT_TRUE(allowUnknownTag(&limiter, 3000));
+  TEST_ASSERT_FALSE(allowUnknownTag(&limiter, 3100));
+  // A long quiet period only refills up to the burst
+  TEST_ASSERT_TRUE(allowUnknownTag(&limiter, 60000));
+  TEST_ASSERT_TRUE(allowUnknownTag(&limiter, 60000));
+  TEST_ASSERT_TRUE(allowUnknownTag(&limiter, 60000));
+  TEST_ASSERT_FALSE(allowUnknownTag(&limiter, 60000));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_every_config_fits_up_to_max_tags);
+  RUN_TEST(test_unknown_tags_get_the_fallback);
+  RUN_TEST(test_full_table_rejects_new_tags_and_stays_intact);
+  RUN_TEST(test_full_table_still_replaces_actions);
+  RUN_TEST(test_invalid_uids);
+  RUN_TEST(test_rate_limiter_burst_and_refill);
+  return UNITY_END();
+}
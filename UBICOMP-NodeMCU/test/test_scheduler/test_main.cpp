@@ -0,0 +1,207 @@
+// The sensor scheduler on a virtual clock, like tools/schedsim.cpp. Every
+// poll takes its given cost, the idle time between polls passes instantly
+
+#include <unity.h>
+#include <Scheduler.h>
+
+#include <string.h>
+
+namespace {
+
+t_scheduler scheduler;
+uint32_t now;
+uint32_t costs[SCHEDULER_MAX_TASKS];
+// A cost for the next poll of a task only, 0 if none
+uint32_t onceCosts[SCHEDULER_MAX_TASKS];
+// Tasks in the order they were polled
+int polls[64];
+size_t pollCount;
+
+uint32_t virtualClock() {
+  return now;
+}
+
+template <int TASK>
+void poll() {
+  if(pollCount < sizeof(polls) / sizeof(polls[0])) {
+    polls[pollCount] = TASK;
+  }
+  pollCount++;
+  now += onceCosts[TASK] ? onceCosts[TASK] : costs[TASK];
+  onceCosts[TASK] = 0;
+}
+
+const t_task_function POLLS[SCHEDULER_MAX_TASKS] = { poll<0>, poll<1>, poll<2>, poll<3> };
+
+// The cost defaults to the budget
+int add(uint32_t period, uint32_t budget) {
+  // A full scheduler rejects the task before it looks at the function
+  t_task_function run = scheduler.count < SCHEDULER_MAX_TASKS ? POLLS[scheduler.count] : poll<0>;
+  int task = addScheduledTask(&scheduler, "task", run, period, budget, now);
+  if(task >= 0) {
+    costs[task] = budget;
+  }
+  return task;
+}
+
+// Runs the schedule until the clock passed duration (us)
+void runFor(uint32_t duration) {
+  uint32_t end = now + duration;
+  while((int32_t) (now - end) < 0) {
+    now += runScheduler(&scheduler, virtualClock);
+  }
+}
+
+void assertOnTime(const t_scheduled_task& task, uint32_t duration) {
+  TEST_ASSERT_UINT32_WITHIN(1, duration / task.period, task.runs);
+  TEST_ASSERT_EQUAL(0, task.misses);
+  TEST_ASSERT_EQUAL(0, task.overruns);
+}
+
+}
+
+void setUp() {
+  initScheduler(&scheduler);
+  now = 0;
+  memset(costs, 0, sizeof(costs));
+  memset(onceCosts, 0, sizeof(onceCosts));
+  pollCount = 0;
+}
+
+void tearDown() {}
+
+void test_admission_up_to_full_utilization() {
+  TEST_ASSERT_EQUAL(0, add(10000, 5000));
+  TEST_ASSERT_EQUAL(1, add(20000, 5000));
+  TEST_ASSERT_EQUAL(750, scheduler.utilization);
+  // 25% are left, utilization is counted in 1/1000
+  TEST_ASSERT_EQUAL(-1, add(8000, 2008));
+  TEST_ASSERT_EQUAL(2, add(8000, 2000));
+  TEST_ASSERT_EQUAL(1000, scheduler.utilization);
+  TEST_ASSERT_EQUAL(3, scheduler.count);
+}
+
+void test_admission_rejects_invalid_tasks() {
+  TEST_ASSERT_EQUAL(-1, add(0, 0));
+  TEST_ASSERT_EQUAL(-1, add(1000, 1001));
+  for(int i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+    TEST_ASSERT_EQUAL(i, add(100000, 1000));
+  }
+  TEST_ASSERT_EQUAL(-1, add(100000, 1000));
+}
+
+void test_admission_rejects_budget_longer_than_another_period() {
+  TEST_ASSERT_EQUAL(0, add(10000, 1000));
+  // Far from full, but either would block the other past its deadline
+  TEST_ASSERT_EQUAL(-1, add(1000000, 15000));
+  TEST_ASSERT_EQUAL(-1, add(500, 100));
+  // A rejected task leaves nothing behind
+  TEST_ASSERT_EQUAL(100, scheduler.utilization);
+  TEST_ASSERT_EQUAL(1, scheduler.count);
+}
+
+void test_earliest_deadline_first() {
+  add(30000, 1000);
+  add(10000, 1000);
+  add(20000, 1000);
+  runFor(20000);
+  // All released at 0 with deadlines 30000, 10000 and 20000, then only the
+  // 10 ms task is released again before 20000
+  const int expected[] = { 1, 2, 0, 1 };
+  TEST_ASSERT_EQUAL(4, pollCount);
+  TEST_ASSERT_EQUAL_INT_ARRAY(expected, polls, 4);
+}
+
+void test_ties_go_to_the_task_added_first() {
+  add(10000, 1000);
+  add(10000, 1000);
+  add(10000, 1000);
+  runFor(20000);
+  const int expected[] = { 0, 1, 2, 0, 1, 2 };
+  TEST_ASSERT_EQUAL(6, pollCount);
+  TEST_ASSERT_EQUAL_INT_ARRAY(expected, polls, 6);
+}
+
+void test_full_utilization_meets_every_deadline() {
+  add(10000, 5000);
+  add(20000, 5000);
+  add(8000, 2000);
+  runFor(10000000);
+  for(uint8_t i = 0; i < scheduler.count; i++) {
+    assertOnTime(scheduler.tasks[i], 10000000);
+  }
+}
+
+void test_idle_time_until_the_next_release() {
+  add(10000, 1000);
+  add(25000, 2000);
+  TEST_ASSERT_EQUAL(0, runScheduler(&scheduler, virtualClock));
+  TEST_ASSERT_EQUAL(0, runScheduler(&scheduler, virtualClock));
+  // Both ran, at 3000 the next release is the first task's at 10000
+  TEST_ASSERT_EQUAL(3000, now);
+  TEST_ASSERT_EQUAL(7000, runScheduler(&scheduler, virtualClock));
+  TEST_ASSERT_EQUAL(2, pollCount);
+}
+
+void test_overrun_is_counted() {
+  add(10000, 1000);
+  costs[0] = 1500;
+  runFor(100000);
+  TEST_ASSERT_EQUAL(10, scheduler.tasks[0].runs);
+  TEST_ASSERT_EQUAL(10, scheduler.tasks[0].overruns);
+  // Still well within the period
+  TEST_ASSERT_EQUAL(0, scheduler.tasks[0].misses);
+}
+
+void test_skipped_releases_are_misses() {
+  add(1000, 500);
+  // One poll hangs for 3.5 periods: its own deadline at 1000 and the
+  // releases at 1000 and 2000 are missed, the one at 3000 runs right away
+  onceCosts[0] = 3500;
+  TEST_ASSERT_EQUAL(0, runScheduler(&scheduler, virtualClock));
+  TEST_ASSERT_EQUAL(3, scheduler.tasks[0].misses);
+  TEST_ASSERT_EQUAL(3000, scheduler.tasks[0].release);
+  TEST_ASSERT_EQUAL(0, runScheduler(&scheduler, virtualClock));
+  TEST_ASSERT_EQUAL(4000, scheduler.tasks[0].release);
+  // Not caught up on in a burst
+  TEST_ASSERT_EQUAL(2, scheduler.tasks[0].runs);
+  TEST_ASSERT_EQUAL(3, scheduler.tasks[0].misses);
+  TEST_ASSERT_EQUAL(1, scheduler.tasks[0].overruns);
+}
+
+void test_long_poll_makes_another_task_miss() {
+  add(2000, 500);
+  add(10000, 1000);
+  // The 10 ms task takes 6.5 ms once. The 2 ms task released at 2000 only
+  // runs at 7000, misses its deadline and skips the release at 4000
+  onceCosts[1] = 6500;
+  runFor(10000);
+  TEST_ASSERT_EQUAL(2, scheduler.tasks[0].misses);
+  TEST_ASSERT_EQUAL(1, scheduler.tasks[1].overruns);
+  TEST_ASSERT_EQUAL(0, scheduler.tasks[1].misses);
+}
+
+void test_clock_wraps_around() {
+  now = UINT32_MAX - 50000;
+  add(10000, 1000);
+  add(16000, 2000);
+  runFor(200000);
+  assertOnTime(scheduler.tasks[0], 200000);
+  assertOnTime(scheduler.tasks[1], 200000);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_admission_up_to_full_utilization);
+  RUN_TEST(test_admission_rejects_invalid_tasks);
+  RUN_TEST(test_admission_rejects_budget_longer_than_another_period);
+  RUN_TEST(test_earliest_deadline_first);
+  RUN_TEST(test_ties_go_to_the_task_added_first);
+  RUN_TEST(test_full_utilization_meets_every_deadline);
+  RUN_TEST(test_idle_time_until_the_next_release);
+  RUN_TEST(test_overrun_is_counted);
+  RUN_TEST(test_skipped_releases_are_misses);
+  RUN_TEST(test_long_poll_makes_another_task_miss);
+  RUN_TEST(test_clock_wraps_around);
+  return UNITY_END();
+}
@@ -0,0 +1,403 @@
+// Payloads of SensorJson.cpp byte for byte, the largest values of each schema
+// against the *_JSON_SIZE buffers and a comparison with ArduinoJson, which
+// serialized the payloads before
+
+#include <unity.h>
+#include <ArduinoJson.h>
+#include <SensorJson.h>
+#include <NodeRules.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+// Serializations of each measured payload
+#define BENCHMARK_RUNS 20000
+
+namespace {
+
+// Larger than every payload buffer, so overflows show up behind them
+char out[2048];
+
+// Same names as main.cpp
+const char* const METRIC_NAMES[] = { "loop", "nfc", "ir", "sound", "publish" };
+const char* const BOOT_PHASE_NAMES[] = { "setup", "peripherals", "nfc", "wifi", "mqtt", "state" };
+const size_t METRIC_COUNT = sizeof(METRIC_NAMES) / sizeof(METRIC_NAMES[0]);
+const size_t BOOT_PHASE_COUNT = sizeof(BOOT_PHASE_NAMES) / sizeof(BOOT_PHASE_NAMES[0]);
+
+t_ir_data irData(uint32_t code, uint16_t command, uint8_t action) {
+  t_ir_data ir;
+  ir.code = code;
+  ir.command = command;
+  const t_ir_code* known = lookupIRCode(code);
+  ir.button = known ? known->button : IR_BUTTON_NONE;
+  ir.action = action;
+  return ir;
+}
+
+t_nfc_data nfcData(const uint8_t* uid, uint8_t length, uint8_t tagType, uint8_t action) {
+  t_nfc_data nfc;
+  memset(&nfc, 0, sizeof(nfc));
+  memcpy(nfc.uid, uid, length);
+  nfc.uidLength = length;
+  nfc.tagType = tagType;
+  nfc.action = action;
+  return nfc;
+}
+
+t_nfc_data longestNfcData() {
+  const uint8_t uid[NFC_UID_MAX_LENGTH] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+  // The type 2 name is longer than "Mifare Classic"
+  return nfcData(uid, sizeof(uid), NFC_TAG_TYPE_MIFARE_CLASSIC + 1, RULE_TOGGLE);
+}
+
+void assertJson(const char* expected, size_t length) {
+  TEST_ASSERT_EQUAL_STRING(expected, out);
+  TEST_ASSERT_EQUAL(strlen(expected), length);
+}
+
+// The largest payload has to fit exactly into its buffer, terminator included
+template <typename Write>
+void assertFits(size_t size, Write write) {
+  memset(out, 'x', sizeof(out));
+  size_t length = write(out, size);
+  TEST_ASSERT_GREATER_THAN(0, length);
+  TEST_ASSERT_LESS_THAN(size, length);
+  TEST_ASSERT_EQUAL(strlen(out), length);
+  // Nothing is written past the buffer
+  TEST_ASSERT_EQUAL('x', out[size]);
+}
+
+template <typename Write>
+double nanosPerRun(Write write) {
+  auto start = std::chrono::steady_clock::now();
+  size_t written = 0;
+  for(int i = 0; i < BENCHMARK_RUNS; i++) {
+    written += write();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  TEST_ASSERT_GREATER_THAN(0, written);
+  return std::chrono::duration<double, std::nano>(elapsed).count() / BENCHMARK_RUNS;
+}
+
+void report(const char* payload, size_t buffer, size_t document, double ownNanos, double arduinoJsonNanos) {
+  char message[160];
+  snprintf(message, sizeof(message), "%s: %u bytes (buffer) vs %u bytes (JsonDocument and buffer), %.0f ns vs %.0f ns per payload",
+           payload, (unsigned) buffer, (unsigned) document, ownNanos, arduinoJsonNanos);
+  TEST_MESSAGE(message);
+}
+
+}
+
+void setUp() {
+  memset(out, 0, sizeof(out));
+}
+
+void tearDown() {}
+
+/***** Golden payloads ******/
+
+void test_ir_json() {
+  t_ir_data ir = irData(0xFFB04F, 176, SENSOR_NO_ACTION);
+  assertJson("{\"code\":16756815,\"command\":176,\"button\":\"ON\"}", writeIrJson(out, sizeof(out), &ir));
+  ir = irData(0xFFB847, 29, RULE_TOGGLE);
+  assertJson("{\"code\":16758855,\"command\":29,\"button\":\"DIM_DOWN\",\"action\":2}", writeIrJson(out, sizeof(out), &ir));
+  // Unknown codes have no button
+  ir = irData(0, 0, 0);
+  assertJson("{\"code\":0,\"command\":0,\"action\":0}", writeIrJson(out, sizeof(out), &ir));
+}
+
+void test_sound_json() {
+  t_sound_data sound = { 412, 1988, 730 };
+  assertJson("{\"rms\":412,\"peak\":1988,\"envelope\":730}", writeSoundJson(out, sizeof(out), &sound));
+}
+
+void test_nfc_json() {
+  const uint8_t uid[] = { 0x8E, 0xFC, 0x5B, 0x22 };
+  t_nfc_data nfc = nfcData(uid, sizeof(uid), NFC_TAG_TYPE_MIFARE_CLASSIC, SENSOR_NO_ACTION);
+  assertJson("{\"uid\":\"8E:FC:5B:22\",\"type\":\"Mifare Classic\"}", writeNfcJson(out, sizeof(out), &nfc));
+
+  // Leading zeros of each byte are kept
+  const uint8_t longUid[] = { 0x04, 0xA1, 0xB2, 0x0C, 0xD4, 0xE5, 0x06 };
+  nfc = nfcData(longUid, sizeof(longUid), 2, 1);
+  assertJson("{\"uid\":\"04:A1:B2:0C:D4:E5:06\",\"type\":\"NFC Forum Type 2\",\"action\":1}", writeNfcJson(out, sizeof(out), &nfc));
+}
+
+void test_acoustic_json() {
+  t_acoustic_data acoustic = { ACOUSTIC_CLAP, 3100, 60, 125000 };
+  assertJson("{\"event\":\"clap\",\"onset\":125000,\"peak\":3100,\"duration\":60}", writeAcousticJson(out, sizeof(out), &acoustic));
+  acoustic.kind = ACOUSTIC_LOUD;
+  acoustic.duration = 900;
+  assertJson("{\"event\":\"loud\",\"onset\":125000,\"peak\":3100,\"duration\":900}", writeAcousticJson(out, sizeof(out), &acoustic));
+}
+
+void test_state_json() {
+  assertJson("{\"state\":1,\"node\":\"node-1\"}", writeStateJson(out, sizeof(out), 1, "node-1"));
+  // Quotes and backslashes in the identifier are escaped
+  assertJson("{\"state\":0,\"node\":\"a\\\"b\\\\c\"}", writeStateJson(out, sizeof(out), 0, "a\"b\\c"));
+}
+
+void test_batch_json() {
+  t_sensor_event events[3];
+  memset(events, 0, sizeof(events));
+  events[0].type = SENSOR_IR;
+  events[0].timestamp = 1200;
+  events[0].ir = irData(0xFFB04F, 176, SENSOR_NO_ACTION);
+  events[1].type = SENSOR_NFC;
+  events[1].timestamp = 1250;
+  const uint8_t uid[] = { 0x8E, 0xFC, 0x5B, 0x22 };
+  events[1].nfc = nfcData(uid, sizeof(uid), NFC_TAG_TYPE_MIFARE_CLASSIC, 2);
+  events[2].type = SENSOR_SOUND;
+  events[2].timestamp = 1300;
+  events[2].sound = { 1, 2, 3 };
+  assertJson("[{\"sensor\":\"ir\",\"timestamp\":1200,\"code\":16756815,\"command\":176,\"button\":\"ON\"},"
+             "{\"sensor\":\"nfc\",\"timestamp\":1250,\"uid\":\"8E:FC:5B:22\",\"type\":\"Mifare Classic\",\"action\":2},"
+             "{\"sensor\":\"sound\",\"timestamp\":1300,\"rms\":1,\"peak\":2,\"envelope\":3}]",
+             writeBatchJson(out, sizeof(out), events, 3));
+  assertJson("[]", writeBatchJson(out, sizeof(out), events, 0));
+}
+
+void test_metrics_json() {
+  t_latency_histogram histograms[2];
+  memset(histograms, 0, sizeof(histograms));
+  histograms[0].sum = 5120;
+  histograms[0].buckets[1] = 12;
+  histograms[0].buckets[2] = 830;
+  assertJson("{\"interval\":10000,\"loop\":{\"sum\":5120,\"buckets\":[0,12,830]},\"nfc\":{\"sum\":0,\"buckets\":[]}}",
+             writeMetricsJson(out, sizeof(out), 10000, histograms, METRIC_NAMES, 2));
+}
+
+void test_boot_json() {
+  const uint32_t times[] = { 31, 40, 0, 1250, 1400, 1420 };
+  assertJson("{\"build\":\"Oct 17 2026 09:12:44\",\"setup\":31,\"peripherals\":40,\"nfc\":null,\"wifi\":1250,\"mqtt\":1400,\"state\":1420}",
+             writeBootJson(out, sizeof(out), "Oct 17 2026 09:12:44", times, BOOT_PHASE_NAMES, BOOT_PHASE_COUNT));
+}
+
+void test_dropped_json() {
+  assertJson("{\"dropped\":12}", writeDroppedJson(out, sizeof(out), 12));
+}
+
+void test_schedule_json() {
+  t_scheduled_task tasks[2];
+  memset(tasks, 0, sizeof(tasks));
+  tasks[0].name = "ir";
+  tasks[0].period = 10000;
+  tasks[0].budget = 1000;
+  tasks[0].runs = 120;
+  tasks[0].overruns = 2;
+  tasks[1].name = "nfc";
+  tasks[1].period = 20000;
+  tasks[1].budget = 5000;
+  tasks[1].runs = 60;
+  tasks[1].misses = 1;
+  assertJson("{\"ir\":{\"period\":10000,\"budget\":1000,\"runs\":120,\"misses\":0,\"overruns\":2},"
+             "\"nfc\":{\"period\":20000,\"budget\":5000,\"runs\":60,\"misses\":1,\"overruns\":0}}",
+             writeScheduleJson(out, sizeof(out), tasks, 2));
+}
+
+void test_bus_json() {
+  t_i2c_device devices[2];
+  memset(devices, 0, sizeof(devices));
+  devices[0].name = "nfc";
+  devices[0].transactions = 5210;
+  devices[0].busy = 80412;
+  devices[0].wait = 310;
+  devices[1].name = "lcd";
+  assertJson("{\"nfc\":{\"transactions\":5210,\"busy\":80412,\"wait\":310},\"lcd\":{\"transactions\":0,\"busy\":0,\"wait\":0}}",
+             writeBusJson(out, sizeof(out), devices, 2));
+}
+
+void test_too_small_buffer_writes_nothing() {
+  const char* expected = "{\"state\":1,\"node\":\"node-1\"}";
+  size_t length = strlen(expected);
+  // No room for the terminator
+  memset(out, 'x', sizeof(out));
+  TEST_ASSERT_EQUAL(0, writeStateJson(out, length, 1, "node-1"));
+  TEST_ASSERT_EQUAL('\0', out[0]);
+  TEST_ASSERT_EQUAL('x', out[length]);
+  TEST_ASSERT_EQUAL(0, writeStateJson(out, 0, 1, "node-1"));
+  TEST_ASSERT_EQUAL(length, writeStateJson(out, length + 1, 1, "node-1"));
+}
+
+/***** Largest payloads ******/
+
+void test_largest_payloads_fit_their_buffers() {
+  // Every known button, unknown codes have no name but the longest number
+  for(uint8_t i = 0; i < IRCodes::COUNT; i++) {
+    t_ir_data ir = irData(IRCodes::CODES[i].code, 65535, RULE_TOGGLE);
+    assertFits(IR_JSON_SIZE, [&](char* buffer, size_t size) { return writeIrJson(buffer, size, &ir); });
+  }
+  t_ir_data unknown = irData(4294967295UL, 65535, RULE_TOGGLE);
+  assertFits(IR_JSON_SIZE, [&](char* buffer, size_t size) { return writeIrJson(buffer, size, &unknown); });
+
+  t_sound_data sound = { 65535, 65535, 65535 };
+  assertFits(SOUND_JSON_SIZE, [&](char* buffer, size_t size) { return writeSoundJson(buffer, size, &sound); });
+
+  t_nfc_data nfc = longestNfcData();
+  assertFits(NFC_JSON_SIZE, [&](char* buffer, size_t size) { return writeNfcJson(buffer, size, &nfc); });
+
+  t_acoustic_data acoustic = { ACOUSTIC_CLAP, 65535, 65535, 4294967295UL };
+  assertFits(ACOUSTIC_JSON_SIZE, [&](char* buffer, size_t size) { return writeAcousticJson(buffer, size, &acoustic); });
+
+  // Node identifiers are the node-<n> names of the coordinator's config
+  assertFits(STATE_JSON_SIZE, [&](char* buffer, size_t size) { return writeStateJson(buffer, size, 1, "node-4294967295"); });
+
+  assertFits(DROPPED_JSON_SIZE, [&](char* buffer, size_t size) { return writeDroppedJson(buffer, size, 4294967295UL); });
+}
+
+void test_largest_batch_fits_its_buffer() {
+  const size_t count = 8;
+  t_sensor_event events[count];
+  memset(events, 0, sizeof(events));
+  for(size_t i = 0; i < count; i++) {
+    events[i].timestamp = 4294967295UL;
+    switch(i % 3) {
+      case 0:
+        events[i].type = SENSOR_NFC;
+        events[i].nfc = longestNfcData();
+        break;
+      case 1:
+        events[i].type = SENSOR_ACOUSTIC;
+        events[i].acoustic = { ACOUSTIC_CLAP, 65535, 65535, 4294967295UL };
+        break;
+      default:
+        events[i].type = SENSOR_IR;
+        events[i].ir = irData(0xFFB847, 65535, RULE_TOGGLE);
+        break;
+    }
+    assertFits(BATCH_JSON_SIZE(1), [&](char* buffer, size_t size) { return writeBatchJson(buffer, size, &events[i], 1); });
+  }
+  assertFits(BATCH_JSON_SIZE(count), [&](char* buffer, size_t size) { return writeBatchJson(buffer, size, events, count); });
+}
+
+void test_largest_reports_fit_their_buffers() {
+  t_latency_histogram histograms[METRIC_COUNT];
+  for(size_t i = 0; i < METRIC_COUNT; i++) {
+    histograms[i].sum = 4294967295UL;
+    for(size_t bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+      histograms[i].buckets[bucket] = 4294967295UL;
+    }
+  }
+  assertFits(METRICS_JSON_SIZE(METRIC_COUNT), [&](char* buffer, size_t size) {
+    return writeMetricsJson(buffer, size, 4294967295UL, histograms, METRIC_NAMES, METRIC_COUNT);
+  });
+
+  uint32_t times[BOOT_PHASE_COUNT];
+  for(size_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+    times[i] = 4294967295UL;
+  }
+  // Like __DATE__ " " __TIME__
+  assertFits(BOOT_JSON_SIZE(BOOT_PHASE_COUNT), [&](char* buffer, size_t size) {
+    return writeBootJson(buffer, size, "Oct 17 2026 09:12:44", times, BOOT_PHASE_NAMES, BOOT_PHASE_COUNT);
+  });
+
+  t_scheduled_task tasks[3];
+  const char* const taskNames[] = { "ir", "nfc", "sound" };
+  for(size_t i = 0; i < 3; i++) {
+    tasks[i].name = taskNames[i];
+    tasks[i].period = tasks[i].budget = tasks[i].runs = tasks[i].misses = tasks[i].overruns = 4294967295UL;
+  }
+  assertFits(SCHEDULE_JSON_SIZE(3), [&](char* buffer, size_t size) { return writeScheduleJson(buffer, size, tasks, 3); });
+
+  t_i2c_device devices[2];
+  const char* const deviceNames[] = { "nfc", "lcd" };
+  for(size_t i = 0; i < 2; i++) {
+    devices[i].name = deviceNames[i];
+    devices[i].transactions = devices[i].busy = devices[i].wait = 4294967295UL;
+  }
+  assertFits(BUS_JSON_SIZE(2), [&](char* buffer, size_t size) { return writeBusJson(buffer, size, devices, 2); });
+}
+
+/***** ArduinoJson ******/
+
+void test_same_bytes_as_arduino_json() {
+  char expected[128];
+
+  t_ir_data ir = irData(0xFFB847, 29, RULE_TOGGLE);
+  StaticJsonDocument<JSON_OBJECT_SIZE(4)> irDoc;
+  irDoc["code"] = ir.code;
+  irDoc["command"] = ir.command;
+  irDoc["button"] = lookupIRCode(ir.code)->name;
+  irDoc["action"] = ir.action;
+  serializeJson(irDoc, expected, sizeof(expected));
+  assertJson(expected, writeIrJson(out, sizeof(out), &ir));
+
+  t_nfc_data nfc = longestNfcData();
+  char uid[NFC_UID_STRING_LENGTH];
+  formatNfcUid(&nfc, uid);
+  StaticJsonDocument<JSON_OBJECT_SIZE(3)> nfcDoc;
+  nfcDoc["uid"] = uid;
+  nfcDoc["type"] = nfcTagTypeName(&nfc);
+  nfcDoc["action"] = nfc.action;
+  serializeJson(nfcDoc, expected, sizeof(expected));
+  assertJson(expected, writeNfcJson(out, sizeof(out), &nfc));
+
+  StaticJsonDocument<JSON_OBJECT_SIZE(2)> stateDoc;
+  stateDoc["state"] = 1;
+  stateDoc["node"] = "node-1";
+  serializeJson(stateDoc, expected, sizeof(expected));
+  assertJson(expected, writeStateJson(out, sizeof(out), 1, "node-1"));
+}
+
+void test_compare_with_arduino_json() {
+  // Payloads as the firmware serialized them with ArduinoJson before
+  t_ir_data ir = irData(0xFFB847, 29, RULE_TOGGLE);
+  StaticJsonDocument<JSON_OBJECT_SIZE(4)> irDoc;
+  double irOwn = nanosPerRun([&]() { return writeIrJson(out, IR_JSON_SIZE, &ir); });
+  double irArduinoJson = nanosPerRun([&]() {
+    irDoc.clear();
+    irDoc["code"] = ir.code;
+    irDoc["command"] = ir.command;
+    irDoc["button"] = lookupIRCode(ir.code)->name;
+    irDoc["action"] = ir.action;
+    return serializeJson(irDoc, out, IR_JSON_SIZE);
+  });
+  report("ir", IR_JSON_SIZE, irDoc.capacity() + IR_JSON_SIZE, irOwn, irArduinoJson);
+
+  t_nfc_data nfc = longestNfcData();
+  StaticJsonDocument<JSON_OBJECT_SIZE(3)> nfcDoc;
+  double nfcOwn = nanosPerRun([&]() { return writeNfcJson(out, NFC_JSON_SIZE, &nfc); });
+  double nfcArduinoJson = nanosPerRun([&]() {
+    char uid[NFC_UID_STRING_LENGTH];
+    formatNfcUid(&nfc, uid);
+    nfcDoc.clear();
+    // Copied into the document like a String was
+    nfcDoc["uid"] = (char*) uid;
+    nfcDoc["type"] = nfcTagTypeName(&nfc);
+    nfcDoc["action"] = nfc.action;
+    return serializeJson(nfcDoc, out, NFC_JSON_SIZE);
+  });
+  report("nfc", NFC_JSON_SIZE, nfcDoc.capacity() + NFC_JSON_SIZE, nfcOwn, nfcArduinoJson);
+
+  StaticJsonDocument<JSON_OBJECT_SIZE(2)> stateDoc;
+  double stateOwn = nanosPerRun([&]() { return writeStateJson(out, STATE_JSON_SIZE, 1, "node-1"); });
+  double stateArduinoJson = nanosPerRun([&]() {
+    stateDoc.clear();
+    stateDoc["state"] = 1;
+    stateDoc["node"] = "node-1";
+    return serializeJson(stateDoc, out, STATE_JSON_SIZE);
+  });
+  report("state", STATE_JSON_SIZE, stateDoc.capacity() + STATE_JSON_SIZE, stateOwn, stateArduinoJson);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_ir_json);
+  RUN_TEST(test_sound_json);
+  RUN_TEST(test_nfc_json);
+  RUN_TEST(test_acoustic_json);
+  RUN_TEST(test_state_json);
+  RUN_TEST(test_batch_json);
+  RUN_TEST(test_metrics_json);
+  RUN_TEST(test_boot_json);
+  RUN_TEST(test_dropped_json);
+  RUN_TEST(test_schedule_json);
+  RUN_TEST(test_bus_json);
+  RUN_TEST(test_too_small_buffer_writes_nothing);
+  RUN_TEST(test_largest_payloads_fit_their_buffers);
+  RUN_TEST(test_largest_batch_fits_its_buffer);
+  RUN_TEST(test_largest_reports_fit_their_buffers);
+  RUN_TEST(test_same_bytes_as_arduino_json);
+  RUN_TEST(test_compare_with_arduino_json);
+  return UNITY_END();
+}
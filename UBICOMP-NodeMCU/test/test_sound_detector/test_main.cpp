@@ -0,0 +1,194 @@
+// Acoustic event detection on synthetic microphone recordings. Every block of
+// samples goes through analyzeSoundBlock() and its peak into the detector,
+// like SoundSensor::read() does
+
+#include <unity.h>
+#include <SoundFeatures.h>
+#include <SoundDetector.h>
+
+#include <math.h>
+
+// Same sampling and tuning as main.cpp
+#define SAMPLE_RATE 8000
+#define BLOCK_SIZE 256
+#define DC_OFFSET 2048
+#define MAX_EVENTS 16
+
+namespace {
+
+const t_sound_detector_config DETECTOR_CONFIG = {
+  0.01f,  // floorAdapt
+  3.0f,   // onFactor
+  1.5f,   // offFactor
+  40,     // minLevel
+  250,    // refractory (ms)
+  120,    // clapMaxDuration (ms)
+  2000    // maxDuration (ms)
+};
+
+// Amplitude of the signal at a sample, in ADC counts
+typedef float (*Recording)(uint32_t sample);
+
+t_sound_analyzer analyzer;
+t_sound_detector detector;
+t_acoustic_data events[MAX_EVENTS];
+size_t eventCount;
+
+// Deterministic noise in [-1, 1]
+uint32_t noiseState;
+
+float noise() {
+  noiseState = noiseState * 1664525UL + 1013904223UL;
+  return (int32_t) noiseState / 2147483648.0f;
+}
+
+float ms(uint32_t sample) {
+  return sample * 1000.0f / SAMPLE_RATE;
+}
+
+// A clap is a broadband burst that decays within a few ms
+float clap(uint32_t sample, float at) {
+  float t = ms(sample) - at;
+  if(t < 0 || t > 40) {
+    return 0;
+  }
+  return 1800 * expf(-t / 6);
+}
+
+float quietRoom(uint32_t sample) {
+  return 20;
+}
+
+float oneClap(uint32_t sample) {
+  return 20 + clap(sample, 1000);
+}
+
+float twoClaps(uint32_t sample) {
+  return 20 + clap(sample, 1000) + clap(sample, 1600);
+}
+
+float clapWithEcho(uint32_t sample) {
+  // The echo falls into the refractory period
+  return 20 + clap(sample, 1000) + clap(sample, 1150) / 2;
+}
+
+float steadyFan(uint32_t sample) {
+  return 300;
+}
+
+float clapOverFan(uint32_t sample) {
+  return 300 + clap(sample, 3000);
+}
+
+float vacuumCleaner(uint32_t sample) {
+  // Switched on after a while and left running
+  return ms(sample) < 2000 ? 20 : 500;
+}
+
+float shortNoise(uint32_t sample) {
+  // Someone talking for half a second
+  float t = ms(sample);
+  return t >= 1000 && t < 1500 ? 600 : 20;
+}
+
+// Records the signal for a while and collects the detected events
+void listen(Recording recording, uint32_t duration) {
+  initSoundAnalyzer(&analyzer, 0.05f, 0.0005f);
+  initSoundDetector(&detector, &DETECTOR_CONFIG);
+  noiseState = 1;
+  eventCount = 0;
+
+  uint16_t block[BLOCK_SIZE];
+  uint32_t samples = duration * SAMPLE_RATE / 1000;
+  for(uint32_t start = 0; start + BLOCK_SIZE <= samples; start += BLOCK_SIZE) {
+    for(uint32_t i = 0; i < BLOCK_SIZE; i++) {
+      float value = DC_OFFSET + recording(start + i) * noise();
+      block[i] = (uint16_t) (value < 0 ? 0 : value > 4095 ? 4095 : value);
+    }
+    uint16_t level = analyzeSoundBlock(&analyzer, block, BLOCK_SIZE);
+    // Blocks arrive once they're full
+    uint32_t timestamp = (start + BLOCK_SIZE) * 1000 / SAMPLE_RATE;
+    t_acoustic_data event;
+    if(detectSoundEvent(&detector, level, timestamp, &event) && eventCount < MAX_EVENTS) {
+      events[eventCount++] = event;
+    }
+  }
+}
+
+void assertClapAt(const t_acoustic_data& event, uint32_t at) {
+  TEST_ASSERT_EQUAL(ACOUSTIC_CLAP, event.kind);
+  // Within the block the clap started in
+  TEST_ASSERT_UINT32_WITHIN(BLOCK_SIZE * 1000 / SAMPLE_RATE, at + BLOCK_SIZE * 1000 / SAMPLE_RATE / 2, event.onset);
+  TEST_ASSERT_LESS_OR_EQUAL(DETECTOR_CONFIG.clapMaxDuration, event.duration);
+  TEST_ASSERT_GREATER_THAN(1000, event.peak);
+}
+
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_quiet_room_has_no_events() {
+  listen(quietRoom, 10000);
+  TEST_ASSERT_EQUAL(0, eventCount);
+}
+
+void test_clap_triggers() {
+  listen(oneClap, 3000);
+  TEST_ASSERT_EQUAL(1, eventCount);
+  assertClapAt(events[0], 1000);
+}
+
+void test_two_claps_are_two_events() {
+  listen(twoClaps, 3000);
+  TEST_ASSERT_EQUAL(2, eventCount);
+  assertClapAt(events[0], 1000);
+  assertClapAt(events[1], 1600);
+}
+
+void test_echo_of_a_clap_is_ignored() {
+  listen(clapWithEcho, 3000);
+  TEST_ASSERT_EQUAL(1, eventCount);
+  assertClapAt(events[0], 1000);
+}
+
+void test_steady_noise_does_not_trigger() {
+  listen(steadyFan, 10000);
+  TEST_ASSERT_EQUAL(0, eventCount);
+}
+
+void test_clap_over_steady_noise_triggers() {
+  listen(clapOverFan, 5000);
+  TEST_ASSERT_EQUAL(1, eventCount);
+  assertClapAt(events[0], 3000);
+}
+
+void test_sustained_noise_is_no_clap() {
+  listen(vacuumCleaner, 12000);
+  // Reported once as loud, then it's the new noise floor
+  TEST_ASSERT_EQUAL(1, eventCount);
+  TEST_ASSERT_EQUAL(ACOUSTIC_LOUD, events[0].kind);
+  TEST_ASSERT_UINT32_WITHIN(BLOCK_SIZE * 1000 / SAMPLE_RATE, 2000, events[0].onset);
+  TEST_ASSERT_GREATER_OR_EQUAL(DETECTOR_CONFIG.maxDuration, events[0].duration);
+}
+
+void test_short_noise_is_loud() {
+  listen(shortNoise, 3000);
+  TEST_ASSERT_EQUAL(1, eventCount);
+  TEST_ASSERT_EQUAL(ACOUSTIC_LOUD, events[0].kind);
+  TEST_ASSERT_UINT32_WITHIN(2 * BLOCK_SIZE * 1000 / SAMPLE_RATE, 500, events[0].duration);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_quiet_room_has_no_events);
+  RUN_TEST(test_clap_triggers);
+  RUN_TEST(test_two_claps_are_two_events);
+  RUN_TEST(test_echo_of_a_clap_is_ignored);
+  RUN_TEST(test_steady_noise_does_not_trigger);
+  RUN_TEST(test_clap_over_steady_noise_triggers);
+  RUN_TEST(test_sustained_noise_is_no_clap);
+  RUN_TEST(test_short_noise_is_loud);
+  return UNITY_END();
+}
@@ -0,0 +1,164 @@
+// RMS, peak and envelope of synthetic blocks of 12 bit ADC samples
+
+#include <unity.h>
+#include <SoundFeatures.h>
+
+#include <math.h>
+
+// Like a DMA buffer of the I2S ADC
+#define BLOCK_SIZE 256
+// Idle level of the microphone output, half of the 12 bit range
+#define DC_OFFSET 2048
+
+namespace {
+
+t_sound_analyzer analyzer;
+uint16_t block[BLOCK_SIZE];
+
+void fillSilence() {
+  for(size_t i = 0; i < BLOCK_SIZE; i++) {
+    block[i] = DC_OFFSET;
+  }
+}
+
+void fillSquare(uint16_t amplitude) {
+  for(size_t i = 0; i < BLOCK_SIZE; i++) {
+    block[i] = i % 2 ? DC_OFFSET - amplitude : DC_OFFSET + amplitude;
+  }
+}
+
+// Whole periods of 32 samples, starts at the DC offset
+void fillSine(uint16_t amplitude) {
+  for(size_t i = 0; i < BLOCK_SIZE; i++) {
+    block[i] = (uint16_t) lroundf(DC_OFFSET + amplitude * sinf(2 * (float) M_PI * i / 32));
+  }
+}
+
+// The DC offset is seeded by the first sample, a microphone starts at its idle level
+void start(float attack, float release) {
+  initSoundAnalyzer(&analyzer, attack, release);
+  fillSilence();
+  analyzeSoundBlock(&analyzer, block, BLOCK_SIZE);
+  t_sound_data features;
+  takeSoundFeatures(&analyzer, &features);
+}
+
+}
+
+void setUp() {
+  // Instant attack, slow release
+  start(1.0f, 0.01f);
+}
+
+void tearDown() {}
+
+void test_no_samples_no_features() {
+  t_sound_data features;
+  TEST_ASSERT_FALSE(takeSoundFeatures(&analyzer, &features));
+  TEST_ASSERT_EQUAL(0, analyzeSoundBlock(&analyzer, block, 0));
+  TEST_ASSERT_FALSE(takeSoundFeatures(&analyzer, &features));
+}
+
+void test_silence() {
+  fillSilence();
+  TEST_ASSERT_EQUAL(0, analyzeSoundBlock(&analyzer, block, BLOCK_SIZE));
+  t_sound_data features;
+  TEST_ASSERT_TRUE(takeSoundFeatures(&analyzer, &features));
+  TEST_ASSERT_EQUAL(0, features.rms);
+  TEST_ASSERT_EQUAL(0, features.peak);
+  TEST_ASSERT_EQUAL(0, features.envelope);
+}
+
+void test_square_wave() {
+  fillSquare(1000);
+  for(int i = 0; i < 4; i++) {
+    TEST_ASSERT_UINT32_WITHIN(2, 1000, analyzeSoundBlock(&analyzer, block, BLOCK_SIZE));
+  }
+  t_sound_data features;
+  TEST_ASSERT_TRUE(takeSoundFeatures(&analyzer, &features));
+  // The DC offset sits in the middle, every sample is as far off as the amplitude
+  TEST_ASSERT_UINT32_WITHIN(2, 1000, features.rms);
+  TEST_ASSERT_UINT32_WITHIN(2, 1000, features.peak);
+  TEST_ASSERT_UINT32_WITHIN(2, 1000, features.envelope);
+}
+
+void test_sine_wave() {
+  fillSine(800);
+  for(int i = 0; i < 4; i++) {
+    analyzeSoundBlock(&analyzer, block, BLOCK_SIZE);
+  }
+  t_sound_data features;
+  TEST_ASSERT_TRUE(takeSoundFeatures(&analyzer, &features));
+  TEST_ASSERT_UINT32_WITHIN(8, 566, features.rms);  // 800 / sqrt(2)
+  TEST_ASSERT_UINT32_WITHIN(4, 800, features.peak);
+}
+
+void test_dc_offset_is_removed() {
+  // Same wave around another offset, seeded by the first sample
+  initSoundAnalyzer(&analyzer, 1.0f, 0.01f);
+  block[0] = 3000;
+  analyzeSoundBlock(&analyzer, block, 1);
+  for(size_t i = 0; i < BLOCK_SIZE; i++) {
+    block[i] = i % 2 ? 3000 - 500 : 3000 + 500;
+  }
+  analyzeSoundBlock(&analyzer, block, BLOCK_SIZE);
+  t_sound_data features;
+  TEST_ASSERT_TRUE(takeSoundFeatures(&analyzer, &features));
+  TEST_ASSERT_UINT32_WITHIN(2, 500, features.rms);
+  TEST_ASSERT_UINT32_WITHIN(2, 500, features.peak);
+}
+
+void test_taking_features_starts_a_new_interval() {
+  fillSquare(1500);
+  analyzeSoundBlock(&analyzer, block, BLOCK_SIZE);
+  t_sound_data features;
+  TEST_ASSERT_TRUE(takeSoundFeatures(&analyzer, &features));
+  TEST_ASSERT_UINT32_WITHIN(2, 1500, features.peak);
+
+  fillSquare(100);
+  analyzeSoundBlock(&analyzer, block, BLOCK_SIZE);
+  TEST_ASSERT_TRUE(takeSoundFeatures(&analyzer, &features));
+  TEST_ASSERT_UINT32_WITHIN(2, 100, features.rms);
+  TEST_ASSERT_UINT32_WITHIN(2, 100, features.peak);
+  TEST_ASSERT_FALSE(takeSoundFeatures(&analyzer, &features));
+}
+
+void test_envelope_rises_fast_and_falls_slowly() {
+  fillSquare(1000);
+  analyzeSoundBlock(&analyzer, block, BLOCK_SIZE);
+  fillSilence();
+  analyzeSoundBlock(&analyzer, block, BLOCK_SIZE);
+
+  t_sound_data features;
+  TEST_ASSERT_TRUE(takeSoundFeatures(&analyzer, &features));
+  // 1000 released by 1% per sample over a block of silence
+  float expected = 1000 * powf(0.99f, BLOCK_SIZE);
+  TEST_ASSERT_UINT32_WITHIN(3, (uint32_t) lroundf(expected), features.envelope);
+  TEST_ASSERT_UINT32_WITHIN(2, 1000, features.peak);
+  // Half of the interval was silent
+  TEST_ASSERT_UINT32_WITHIN(4, 707, features.rms);  // 1000 / sqrt(2)
+}
+
+void test_slow_attack_smooths_a_burst() {
+  start(0.001f, 0.001f);
+  fillSquare(1000);
+  // A block is too short for the slow follower to reach the level
+  analyzeSoundBlock(&analyzer, block, BLOCK_SIZE);
+  t_sound_data features;
+  TEST_ASSERT_TRUE(takeSoundFeatures(&analyzer, &features));
+  TEST_ASSERT_UINT32_WITHIN(3, (uint32_t) lroundf(1000 * (1 - powf(0.999f, BLOCK_SIZE))), features.envelope);
+  TEST_ASSERT_UINT32_WITHIN(2, 1000, features.peak);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_no_samples_no_features);
+  RUN_TEST(test_silence);
+  RUN_TEST(test_square_wave);
+  RUN_TEST(test_sine_wave);
+  RUN_TEST(test_dc_offset_is_removed);
+  RUN_TEST(test_taking_features_starts_a_new_interval);
+  RUN_TEST(test_envelope_rises_fast_and_falls_slowly);
+  RUN_TEST(test_slow_attack_smooths_a_burst);
+  return UNITY_END();
+}
@@ -0,0 +1,207 @@
+// Host side of the flash event log (include/EventLog.h): runs the log against
+// a file that simulates NOR flash, and inspects partition dumps of a node
+// built with -D FLASH_LOG
+//
+// Build:  g++ -std=c++14 -O2 -Iinclude tools/eventlog.cpp src/EventLog.cpp -o eventlog
+// Usage:  eventlog <image> format <sectors>     new erased image
+//         eventlog <image> append <count> [cut]  append IR events, with cut the
+//                                                flash stops taking writes after
+//                                                that many bytes, like on a reset
+//         eventlog <image> read [count]          print pending events
+//         eventlog <image> consume <count>       consume the oldest events
+//         eventlog <image> stats                 sectors, pending and dropped
+//
+// A dump of the device is read with
+// esptool.py read_flash <offset of eventlog> <size of eventlog> log.bin
+
+#include <EventLog.h>
+#include <SensorEvent.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+// NOR flash: erasing sets a sector to 0xFF, writing can only clear bits
+struct FlashFile {
+  std::vector<uint8_t> data;
+  // Bytes the flash still takes before it "loses power", -1 for unlimited
+  long budget;
+};
+
+bool flashRead(void* context, uint32_t offset, void* data, size_t length) {
+  FlashFile* flash = (FlashFile*) context;
+  if(offset + length > flash->data.size()) {
+    return false;
+  }
+  memcpy(data, &flash->data[offset], length);
+  return true;
+}
+
+bool flashWrite(void* context, uint32_t offset, const void* data, size_t length) {
+  FlashFile* flash = (FlashFile*) context;
+  if(offset + length > flash->data.size()) {
+    return false;
+  }
+  const uint8_t* bytes = (const uint8_t*) data;
+  for(size_t i = 0; i < length; i++) {
+    if(flash->budget == 0) {
+      return false;
+    }
+    if(flash->budget > 0) {
+      flash->budget--;
+    }
+    flash->data[offset + i] &= bytes[i];
+  }
+  return true;
+}
+
+bool flashErase(void* context, uint32_t offset) {
+  FlashFile* flash = (FlashFile*) context;
+  if(offset % LOG_SECTOR_SIZE || offset + LOG_SECTOR_SIZE > flash->data.size() || flash->budget == 0) {
+    return false;
+  }
+  memset(&flash->data[offset], 0xFF, LOG_SECTOR_SIZE);
+  return true;
+}
+
+bool load(const char* path, FlashFile* flash) {
+  std::ifstream in(path, std::ios::binary);
+  if(!in) {
+    return false;
+  }
+  flash->data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  return flash->data.size() >= 2 * LOG_SECTOR_SIZE && flash->data.size() % LOG_SECTOR_SIZE == 0;
+}
+
+bool save(const char* path, const FlashFile& flash) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write((const char*) flash.data.data(), flash.data.size());
+  return (bool) out;
+}
+
+void printEvent(const uint8_t* payload, size_t length) {
+  if(length != sizeof(t_sensor_event)) {
+    printf("record of %zu bytes\n", length);
+    return;
+  }
+  t_sensor_event event;
+  memcpy(&event, payload, sizeof(event));
+  switch(event.type) {
+    case SENSOR_IR:
+      printf("%10u ir code=%u command=%u\n", event.timestamp, event.ir.code, event.ir.command);
+      break;
+    case SENSOR_SOUND:
+      printf("%10u sound rms=%u peak=%u\n", event.timestamp, event.sound.rms, event.sound.peak);
+      break;
+    case SENSOR_NFC:
+      printf("%10u nfc uid of %u bytes\n", event.timestamp, event.nfc.uidLength);
+      break;
+    case SENSOR_ACOUSTIC:
+      printf("%10u acoustic kind=%u peak=%u\n", event.timestamp, event.acoustic.kind, event.acoustic.peak);
+      break;
+    default:
+      printf("%10u unknown sensor %u\n", event.timestamp, event.type);
+      break;
+  }
+}
+
+int usage() {
+  fprintf(stderr, "usage: eventlog <image> format <sectors> | append <count> [cut] | read [count] | consume <count> | stats\n");
+  return 2;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if(argc < 3) {
+    return usage();
+  }
+  const char* path = argv[1];
+  std::string command = argv[2];
+  long argument = argc > 3 ? atol(argv[3]) : -1;
+
+  FlashFile flash;
+  flash.budget = -1;
+  if(command == "format") {
+    if(argument < 2) {
+      return usage();
+    }
+    flash.data.assign(argument * LOG_SECTOR_SIZE, 0xFF);
+    return save(path, flash) ? 0 : 1;
+  }
+  if(!load(path, &flash)) {
+    fprintf(stderr, "%s is no image of whole sectors, at least two\n", path);
+    return 1;
+  }
+
+  t_log_flash ops = { flashRead, flashWrite, flashErase, &flash, (uint32_t) flash.data.size() };
+  t_event_log log;
+  if(!mountLog(&log, &ops)) {
+    fprintf(stderr, "Couldn't mount the log\n");
+    return 1;
+  }
+
+  if(command == "append") {
+    flash.budget = argc > 4 ? atol(argv[4]) : -1;
+    // Continue the timestamps of the pending events
+    t_sensor_event event;
+    memset(&event, 0, sizeof(event));
+    uint32_t timestamp = 0;
+    uint32_t cursor = startLogRead(&log);
+    while(readLog(&log, &cursor, &event, sizeof(event))) {
+      timestamp = event.timestamp;
+    }
+    long appended = 0;
+    for(; appended < argument; appended++) {
+      memset(&event, 0, sizeof(event));
+      event.type = SENSOR_IR;
+      event.timestamp = ++timestamp;
+      event.ir.code = 0xFFA25D;
+      event.ir.command = (uint16_t) appended;
+      event.ir.action = SENSOR_NO_ACTION;
+      if(!appendLog(&log, &event, sizeof(event))) {
+        break;
+      }
+    }
+    bool flushed = flushLog(&log);
+    printf("appended %ld, %s, dropped %u\n", appended, flushed ? "flushed" : "cut off", log.dropped);
+  } else if(command == "read") {
+    uint32_t cursor = startLogRead(&log);
+    uint8_t payload[LOG_RECORD_MAX_SIZE];
+    size_t length;
+    for(long i = 0; (argument < 0 || i < argument) && (length = readLog(&log, &cursor, payload, sizeof(payload))); i++) {
+      printEvent(payload, length);
+    }
+  } else if(command == "consume") {
+    uint32_t cursor = startLogRead(&log);
+    uint8_t payload[LOG_RECORD_MAX_SIZE];
+    long consumed = 0;
+    while(consumed < argument && readLog(&log, &cursor, payload, sizeof(payload))) {
+      consumed++;
+    }
+    consumeLog(&log, cursor);
+    printf("consumed %ld\n", consumed);
+  } else if(command == "stats") {
+    for(uint32_t i = 0; i < log.sectors; i++) {
+      t_log_sector_header header;
+      memcpy(&header, &flash.data[i * LOG_SECTOR_SIZE], sizeof(header));
+      if(header.magic == LOG_MAGIC) {
+        printf("sector %u: sequence %u\n", i, header.sequence);
+      } else {
+        printf("sector %u: unused\n", i);
+      }
+    }
+    printf("pending %u, write offset %u, read offset %u\n", pendingLogRecords(&log), log.writeOffset, log.readOffset);
+    return 0;
+  } else {
+    return usage();
+  }
+
+  return save(path, flash) ? 0 : 1;
+}
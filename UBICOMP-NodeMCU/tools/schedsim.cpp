@@ -0,0 +1,86 @@
+// Runs the sensor scheduler (include/Scheduler.h) on a virtual clock, to tune
+// the periods and budgets of a deployment before flashing it. Every poll
+// takes its given cost, the idle time between polls passes instantly
+//
+// Build:  g++ -std=c++14 -O2 -Iinclude tools/schedsim.cpp src/Scheduler.cpp -o schedsim
+// Usage:  schedsim <seconds> <name>:<period>:<budget>[:<cost>] ...
+//         periods, budgets and costs in us, the cost defaults to the budget
+// e.g.    schedsim 60 ir:10000:1000:300 sound:16000:2000:2500
+//
+// Costs taken from the published metrics (ir, sound, nfc histograms) show
+// whether the schedule holds with the polls as they run on the device
+
+#include <Scheduler.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+uint32_t now = 0;
+uint32_t costs[SCHEDULER_MAX_TASKS];
+// Index of the task being polled, set before its poll runs
+int polled = -1;
+t_scheduler scheduler;
+
+uint32_t virtualClock() {
+  return now;
+}
+
+void poll() {
+  now += costs[polled];
+}
+
+int usage() {
+  fprintf(stderr, "usage: schedsim <seconds> <name>:<period>:<budget>[:<cost>] ...\n");
+  return 2;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if(argc < 3 || argc - 2 > SCHEDULER_MAX_TASKS) {
+    return usage();
+  }
+  uint64_t duration = (uint64_t) atol(argv[1]) * 1000000;
+
+  initScheduler(&scheduler);
+  for(int i = 2; i < argc; i++) {
+    char* name = strtok(argv[i], ":");
+    char* period = strtok(NULL, ":");
+    char* budget = strtok(NULL, ":");
+    char* cost = strtok(NULL, ":");
+    if(!name || !period || !budget) {
+      return usage();
+    }
+    int task = addScheduledTask(&scheduler, name, poll, atol(period), atol(budget), now);
+    if(task < 0) {
+      fprintf(stderr, "%s rejected, total utilization would be over 100%% or its budget longer than another period\n", name);
+      return 1;
+    }
+    costs[task] = cost ? atol(cost) : atol(budget);
+  }
+
+  uint64_t elapsed = 0;
+  uint64_t busy = 0;
+  while(elapsed < duration) {
+    uint32_t start = now;
+    polled = nextScheduledTask(&scheduler, now);
+    uint32_t idle = runScheduler(&scheduler, virtualClock);
+    if(idle) {
+      now += idle;
+    } else {
+      busy += now - start;
+    }
+    elapsed += now - start;
+  }
+
+  printf("utilization %.1f%% admitted, %.1f%% busy\n", scheduler.utilization / 10.0, 100.0 * busy / elapsed);
+  for(uint8_t i = 0; i < scheduler.count; i++) {
+    const t_scheduled_task* task = &scheduler.tasks[i];
+    printf("%-8s period %7u budget %6u cost %6u: runs %8u misses %6u overruns %6u\n",
+           task->name, task->period, task->budget, costs[i], task->runs, task->misses, task->overruns);
+  }
+  return 0;
+}
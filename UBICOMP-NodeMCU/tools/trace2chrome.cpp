@@ -0,0 +1,128 @@
+// Converts trace dumps of a node built with -D TRACING into the Chrome trace
+// event format, to be opened in chrome://tracing or https://ui.perfetto.dev
+//
+// Build:  g++ -std=c++14 -O2 -Iinclude tools/trace2chrome.cpp -o trace2chrome
+// Usage:  trace2chrome <dump> > trace.json
+//
+// A dump is either the serial monitor log of a dump (lines "trace:<32 hex
+// digits>", everything else is skipped) or the raw records of the MQTT dump,
+// e.g. mosquitto_sub -t node/<id>/trace -N > dump.bin
+
+#include <TraceRecord.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char SERIAL_PREFIX[] = "trace:";
+
+int hexValue(char c) {
+  if(c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if(c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if(c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+// Records are little endian, as dumped by the ESP32
+t_trace_record decodeRecord(const uint8_t* bytes) {
+  auto u16 = [&](size_t at) { return (uint16_t) (bytes[at] | bytes[at + 1] << 8); };
+  auto u32 = [&](size_t at) { return (uint32_t) u16(at) | (uint32_t) u16(at + 2) << 16; };
+
+  t_trace_record record;
+  record.timestamp = u32(0);
+  record.event = u16(4);
+  record.phase = bytes[6];
+  record.core = bytes[7];
+  record.arg0 = u32(8);
+  record.arg1 = u32(12);
+  return record;
+}
+
+std::vector<t_trace_record> parseSerial(const std::string& dump) {
+  std::vector<t_trace_record> records;
+  size_t at = 0;
+  while((at = dump.find(SERIAL_PREFIX, at)) != std::string::npos) {
+    at += sizeof(SERIAL_PREFIX) - 1;
+    uint8_t bytes[sizeof(t_trace_record)];
+    size_t i = 0;
+    for(; i < sizeof(bytes) && at + 2 * i + 1 < dump.size(); i++) {
+      int high = hexValue(dump[at + 2 * i]);
+      int low = hexValue(dump[at + 2 * i + 1]);
+      if(high < 0 || low < 0) {
+        break;
+      }
+      bytes[i] = high << 4 | low;
+    }
+    if(i == sizeof(bytes)) {
+      records.push_back(decodeRecord(bytes));
+    }
+  }
+  return records;
+}
+
+std::vector<t_trace_record> parseBinary(const std::string& dump) {
+  std::vector<t_trace_record> records;
+  for(size_t at = 0; at + sizeof(t_trace_record) <= dump.size(); at += sizeof(t_trace_record)) {
+    records.push_back(decodeRecord((const uint8_t*) dump.data() + at));
+  }
+  return records;
+}
+
+}
+
+int main(int argc, char** argv) {
+  if(argc != 2) {
+    fprintf(stderr, "Usage: %s <dump>\n", argv[0]);
+    return 1;
+  }
+  std::ifstream file(argv[1], std::ios::binary);
+  if(!file) {
+    fprintf(stderr, "Can't open %s\n", argv[1]);
+    return 1;
+  }
+  std::string dump((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  std::vector<t_trace_record> records = dump.find(SERIAL_PREFIX) != std::string::npos ? parseSerial(dump) : parseBinary(dump);
+
+  // Timestamps are the low 32 bits of a us clock. Records are in the order
+  // they were claimed, so a large step back is a wrap around
+  uint64_t epoch = 0;
+  uint32_t previous = records.empty() ? 0 : records[0].timestamp;
+
+  printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  for(size_t i = 0; i < records.size(); i++) {
+    const t_trace_record& record = records[i];
+    if(record.timestamp < previous && previous - record.timestamp > 0x80000000u) {
+      epoch += 0x100000000ull;
+    }
+    previous = record.timestamp;
+
+    const char* phase = record.phase == TRACE_PHASE_BEGIN ? "B" : record.phase == TRACE_PHASE_END ? "E" : "i";
+    char unknown[16];
+    const char* name = unknown;
+    if(record.event < TRACE_EVENT_COUNT) {
+      name = TRACE_EVENT_NAMES[record.event];
+    } else {
+      snprintf(unknown, sizeof(unknown), "event %u", record.event);
+    }
+
+    printf("%s\n{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%llu,\"pid\":0,\"tid\":%u,", i ? "," : "", name, phase,
+      (unsigned long long) (epoch + record.timestamp), record.core);
+    if(record.phase == TRACE_PHASE_INSTANT) {
+      printf("\"s\":\"t\",");
+    }
+    printf("\"args\":{\"arg0\":%u,\"arg1\":%u}}", record.arg0, record.arg1);
+  }
+  printf("\n]}\n");
+  return 0;
+}